@@ -6,26 +6,26 @@
 
 #include "constants.hpp"
 #include "functions.hpp"
+#include "geometry.hpp"
+#include "polar.hpp"
 
-extern CRGB pixels[2 * PIXEL_RING_COUNT];
+static void showNumber(CRGB* pixels, uint32_t number, const CRGB& color);
 
-static void showNumber(uint32_t number, const CRGB& color);
-static void copyLens(uint8_t rotate = 0);
-static void mirrorLens(uint8_t rotate = 0);
+typedef PolarRing<PIXEL_RING_COUNT> LensRing;
 
-void binaryClock(uint8_t hue) {
+uint16_t binaryClock(uint8_t hue, CRGB* const pixels) {
   // Do a binary shift instead of integer division because of speed and code size.
   // It's a little less precise, but who cares.
   // Show 1/4 seconds instead of full seconds because it's more interesting. It
   // updates a lot faster and the other lens lights up faster.
   auto now = millis() >> 8;
   const auto color = gbChsv(hue, 0xFF, 0xFF);
-  showNumber(now, color);
-  delay(100);
+  showNumber(pixels, now, color);
+  return 100;
 }
 
 
-static void showNumber(uint32_t number, const CRGB& color) {
+static void showNumber(CRGB* const pixels, uint32_t number, const CRGB& color) {
   uint8_t counter = 0;
   while (number > 0) {
     if (number & 1) {
@@ -36,11 +36,10 @@ static void showNumber(uint32_t number, const CRGB& color) {
     number >>= 1;
     counter += 2;
   }
-  FastLED.show();
 }
 
 
-void lookAround(const uint8_t hue) {
+uint16_t lookAround(const uint8_t hue, CRGB* const pixels) {
   enum class BlinkState {
     DOWN,
     UP,
@@ -66,16 +65,13 @@ void lookAround(const uint8_t hue) {
     blinkCount = 0;
     fill_solid(&pixels[0], PIXEL_RING_COUNT * 2, CRGB::Black);
     pixels[current] = gbChsv(hue, 0xFF, 0xFF);
-    copyLens();
-    FastLED.show();
+    copyLens(pixels);
     reset = false;
   }
 
   const auto timeOffset_ms = millis() - startTime_ms;
   if (timeOffset_ms < 1000) {
-    delay(100);
-    // We return so that the hue can still change
-    return;
+    return 100;
   } else if (timeOffset_ms < 3000) {
     if (target == MOVE_1) {
       target = (current + 4 - random(8) + PIXEL_RING_COUNT / 2) % PIXEL_RING_COUNT;
@@ -85,12 +81,11 @@ void lookAround(const uint8_t hue) {
       // TODO: Go in the closer direction, or a random direction
       current = (current + 1) % PIXEL_RING_COUNT;
       pixels[current] = gbChsv(hue, 0xFF, 0xFF);
-      copyLens();
-      FastLED.show();
+      copyLens(pixels);
     } else {
       target = MOVE_2;
     }
-    delay(50);
+    return 50;
   } else if (timeOffset_ms < 5000) {
     if (target == MOVE_2) {
       target = (current + 4 - random(8) + PIXEL_RING_COUNT / 2) % PIXEL_RING_COUNT;
@@ -100,10 +95,9 @@ void lookAround(const uint8_t hue) {
       // TODO: Go in the closer direction, or a random direction
       current = (current - 1 + PIXEL_RING_COUNT) % PIXEL_RING_COUNT;
       pixels[current] = gbChsv(hue, 0xFF, 0xFF);
-      copyLens();
-      FastLED.show();
+      copyLens(pixels);
     }
-    delay(50);
+    return 50;
   } else {
     fill_solid(&pixels[0], PIXEL_RING_COUNT, CRGB::Black);
     pixels[target] = gbChsv(hue, 0xFF, 0xFF);
@@ -111,10 +105,10 @@ void lookAround(const uint8_t hue) {
     switch (blinkState) { 
       case BlinkState::DOWN:
         for (int i = 0; i < blinkOffset; ++i) {
-          pixels[(i + OFFSET) % PIXEL_RING_COUNT] = blinkColor;
-          pixels[((PIXEL_RING_COUNT / 2 - i + OFFSET) % PIXEL_RING_COUNT)] = blinkColor;
-          pixels[((PIXEL_RING_COUNT / 2 + i + OFFSET) % PIXEL_RING_COUNT)] = blinkColor;
-          pixels[((PIXEL_RING_COUNT - i + OFFSET) % PIXEL_RING_COUNT)] = blinkColor;
+          pixels[pixelAt(0, i + OFFSET)] = blinkColor;
+          pixels[pixelAt(0, PIXEL_RING_COUNT / 2 - i + OFFSET)] = blinkColor;
+          pixels[pixelAt(0, PIXEL_RING_COUNT / 2 + i + OFFSET)] = blinkColor;
+          pixels[pixelAt(0, PIXEL_RING_COUNT - i + OFFSET)] = blinkColor;
         }
         ++blinkOffset;
         if (blinkOffset == PIXEL_RING_COUNT / 4) {
@@ -123,10 +117,10 @@ void lookAround(const uint8_t hue) {
         break;
       case BlinkState::UP:
         for (int i = 0; i < blinkOffset; ++i) {
-          pixels[((i + OFFSET) % PIXEL_RING_COUNT)] = blinkColor;
-          pixels[((PIXEL_RING_COUNT / 2 - i + OFFSET) % PIXEL_RING_COUNT)] = blinkColor;
-          pixels[((PIXEL_RING_COUNT / 2 + i + OFFSET) % PIXEL_RING_COUNT)] = blinkColor;
-          pixels[((PIXEL_RING_COUNT - i + OFFSET) % PIXEL_RING_COUNT)] = blinkColor;
+          pixels[pixelAt(0, i + OFFSET)] = blinkColor;
+          pixels[pixelAt(0, PIXEL_RING_COUNT / 2 - i + OFFSET)] = blinkColor;
+          pixels[pixelAt(0, PIXEL_RING_COUNT / 2 + i + OFFSET)] = blinkColor;
+          pixels[pixelAt(0, PIXEL_RING_COUNT - i + OFFSET)] = blinkColor;
         }
         --blinkOffset;
         if (blinkOffset == 0) {
@@ -142,14 +136,13 @@ void lookAround(const uint8_t hue) {
         break;
     }
 
-    copyLens();
-    FastLED.show();
-    delay(50);
+    copyLens(pixels);
+    return 50;
   }
 }
 
 
-void fadingSparks(uint8_t) {
+uint16_t fadingSparks(uint8_t, CRGB* const pixels) {
   // Like random sparks, but they fade in and out
   static bool increasing[2 * PIXEL_RING_COUNT] = {
     false, false, false, false, false, false, false, false,
@@ -198,15 +191,17 @@ void fadingSparks(uint8_t) {
       }
     }
   }
-  delay(50);
-  FastLED.show();
+  return 50;
 }
 
 
-void newtonsCradle(const uint8_t hue) {
+uint16_t newtonsCradle(const uint8_t hue, CRGB* const pixels) {
   static int8_t swingPosition = 0;
   static int8_t velocity = 7;
 
+  // The last frame is still showing until this returns, so clear it now
+  fill_solid(&pixels[0], PIXEL_RING_COUNT * 2, CRGB::Black);
+
   const auto color = gbChsv(hue, 0xFF, 0xFF);
   const auto cradleColor = gbChsv(hue + 0x7FFF, 0xFF, 0xFF);
   const uint8_t center = 4;
@@ -237,15 +232,12 @@ void newtonsCradle(const uint8_t hue) {
   // Draw the moving pixels
   pixels[movingLed] = color;
 
-  copyLens();
-  FastLED.show();
-  delay(100);
-
-  fill_solid(&pixels[0], PIXEL_RING_COUNT * 2, CRGB::Black);
+  copyLens(pixels);
+  return 100;
 }
 
 
-void rainbowSwirls(uint8_t) {
+uint16_t rainbowSwirls(uint8_t, CRGB* const pixels) {
   static uint16_t hue = 0;  // We use our own hue to make the colors rotate faster
   static uint8_t head = 0;
   const uint8_t brightness[] = {255, 192, 128, 96, 64, 48, 32, 24, 16, 8, 4, 2, 1};
@@ -268,19 +260,24 @@ void rainbowSwirls(uint8_t) {
   hue += 1000;
 
   // Make the second lens swirl the other direction
-  copyLens(PIXEL_RING_COUNT / 2);
+  copyLens(pixels, PIXEL_RING_COUNT / 2);
 
-  FastLED.show();
-  delay(50);
+  return 50;
 }
 
 
-void randomSparks(uint8_t hue) {
+uint16_t randomSparks(uint8_t hue, CRGB* const pixels) {
   // It's possible we might randomly choose the same LED multiple times per lens,
   // so this variable name isn't exactly accurate. I don't care though.
   const int LEDS_PER_LENS = 2;
 
-  int used[2 * LEDS_PER_LENS] = {0};
+  // The last frame's sparks are still showing until this returns, so clear
+  // them now
+  static int used[2 * LEDS_PER_LENS] = {0};
+  for (int led : used) {
+    pixels[led] = CRGB::Black;
+  }
+
   const auto color = gbChsv(hue, 0xFF, 0xFF);
   for (int i = 0; i < LEDS_PER_LENS; ++i) {
     const uint8_t led1 = random(PIXEL_RING_COUNT);
@@ -290,16 +287,11 @@ void randomSparks(uint8_t hue) {
     pixels[led2] = color;
     used[i + LEDS_PER_LENS] = led2;
   }
-  FastLED.show();
-  delay(50);
-  // And clear them
-  for (int led : used) {
-    pixels[led] = CRGB::Black;
-  }
+  return 50;
 }
 
 
-void shimmer(uint8_t hue) {
+uint16_t shimmer(uint8_t hue, CRGB* const pixels) {
   // Start above 0 so that each light should be on a bit
   static const uint8_t brightness[] = {4, 8, 16, 32, 64, 128};
   static uint8_t values[PIXEL_RING_COUNT * 2] = {
@@ -333,78 +325,90 @@ void shimmer(uint8_t hue) {
   for (int i = 0; i < PIXEL_RING_COUNT * 2; ++i) {
     pixels[i] = gbChsv(hue, 0xFF, brightness[values[i]]);
   }
-  FastLED.show();
-  delay(50);
+  return 50;
 }
 
 
-void spinnyWheels(uint8_t) {
+uint16_t spinnyWheels(uint8_t, CRGB* const pixels) {
   static uint16_t hue = 0;  // We use our own hue to make the colors rotate faster
-  static uint8_t offset = 0;  // Position of spinny eyes
+  const int SPOKES = 3;
+  const uint32_t SPOKE_PERIOD_MS = 400;
+
+  // Each spoke is lit for a quarter of the way to the next one
+  const angle_t phase = spinAngle(millis(), SPOKE_PERIOD_MS);
+  uint8_t values[PIXEL_RING_COUNT];
+  LensRing::render(
+    [phase](const angle_t angle, uint32_t) -> uint8_t {
+      return static_cast<angle_t>(angle * SPOKES + phase) < FULL_TURN / 4 ? 0xFF : 0;
+    },
+    0,
+    values);
 
   const auto color = gbChsv(hue, 0xFF, 0xFF);
   for (uint8_t i = 0; i < PIXEL_RING_COUNT; ++i) {
-    CRGB c = CRGB::Black;
-    if (((offset + i) & 0b111) < 2) {
-      c = color;  // 4 pixels on...
-    }
-    pixels[i] = c;  // First eye
+    pixels[pixelAt(0, i)] = CRGB(color).nscale8(values[i]);  // First eye
   }
-  mirrorLens();
-  FastLED.show();
-  ++offset;
-  hue += 20;
-  delay(50);
+  mirrorLens(pixels);
+  hue += 8;
+  return 20;
 }
 
 
-void swirls(uint8_t hue) {
-  static uint8_t head1 = 0;
-  static const uint8_t brightness[] = {255, 128, 64, 32, 16, 8, 4, 2, 1};
+uint16_t swirls(uint8_t hue, CRGB* const pixels) {
+  const uint32_t SWIRL_PERIOD_MS = 1000;
 
-  // I could probably optimize this loop so that I'm not going through the whole ring
+  uint8_t values[PIXEL_RING_COUNT];
+  LensRing::render(
+    [](const angle_t angle, const uint32_t time_ms) {
+      return fadingTail(behind(spinAngle(time_ms, SWIRL_PERIOD_MS), angle), LensRing::PIXEL_WIDTH);
+    },
+    millis(),
+    values);
+
+  const auto color = gbChsv(hue, 0xFF, 0xFF);
   for (uint8_t i = 0; i < PIXEL_RING_COUNT; ++i) {
-    const int8_t difference1 = head1 - i;
-    if (0 <= difference1 && difference1 < static_cast<int>(COUNT_OF(brightness))) {
-      pixels[i] = gbChsv(hue, 0xFF, brightness[difference1]);
-    } else {
-      const int8_t difference2 = PIXEL_RING_COUNT + difference1;
-      if (0 <= difference2 && difference2 < static_cast<int>(COUNT_OF(brightness))) {
-        pixels[i] = gbChsv(hue, 0xFF, brightness[difference2]);
-      }
-    }
+    pixels[pixelAt(0, i)] = CRGB(color).nscale8(values[i]);
   }
-  head1 = (head1 + 1) % PIXEL_RING_COUNT;
 
   // Make the second lens swirl the other direction
-  copyLens(PIXEL_RING_COUNT / 2);
+  copyLens(pixels, PIXEL_RING_COUNT / 2);
 
-  FastLED.show();
-  delay(50);
+  return 20;
 }
 
 
-void circularWipe(const uint8_t hue) {
-  static uint8_t head = 0;
+uint16_t circularWipe(const uint8_t hue, CRGB* const pixels) {
+  const uint32_t WIPE_MS = 1000;
+  static uint32_t wipeStart_ms = 0;
   static CRGB currentColor = CRGB(0xFF0000);
   static CRGB previousColor = CRGB(0x00FF00);
 
-  fill_solid(&pixels[0], head, currentColor);
-  fill_solid(&pixels[head], PIXEL_RING_COUNT - head, previousColor);
-  if (head < PIXEL_RING_COUNT) {
-    ++head;
-  } else {
-    head = 0;
+  const auto now_ms = millis();
+  if (now_ms - wipeStart_ms >= WIPE_MS) {
+    wipeStart_ms = now_ms;
     previousColor = currentColor;
     currentColor = gbChsv(hue, 0xFF, 0xFF);
   }
-  mirrorLens();
-  FastLED.show();
-  delay(50);
+
+  // How much of each pixel the new color has covered
+  const uint32_t head = (now_ms - wipeStart_ms) * FULL_TURN / WIPE_MS;
+  uint8_t coverage[PIXEL_RING_COUNT];
+  LensRing::render(
+    [head](const angle_t angle, uint32_t) -> uint8_t {
+      return angle < head ? 0xFF : 0;
+    },
+    now_ms,
+    coverage);
+
+  for (uint8_t i = 0; i < PIXEL_RING_COUNT; ++i) {
+    pixels[pixelAt(0, i)] = blend(previousColor, currentColor, coverage[i]);
+  }
+  mirrorLens(pixels);
+  return 20;
 }
 
 
-void pacMan(uint8_t) {
+uint16_t pacMan(uint8_t, CRGB* const pixels) {
   enum class PacManState {
     RUNNING,
     CHASING_BLUE,
@@ -462,9 +466,7 @@ void pacMan(uint8_t) {
   // Draw Pac-Man last, in case he's on top of something
   pixels[pacManPosition] = yellow;
 
-  mirrorLens();
-  FastLED.show();
-  delay(100);
+  mirrorLens(pixels);
 
   switch (state) {
     case PacManState::RUNNING:
@@ -497,22 +499,6 @@ void pacMan(uint8_t) {
   if (pacManPosition > PIXEL_RING_COUNT) {
     pacManPosition = PIXEL_RING_COUNT - 1;
   }
+  return 100;
 }
 
-
-void copyLens(const uint8_t rotate) {
-  // I didn't mount the lenses the same, so we need to fiddle a bit to get the copy effect
-  const int OFFSET = 2;
-  for (int i = 0; i < PIXEL_RING_COUNT; ++i) {
-    pixels[((i + rotate + PIXEL_RING_COUNT - OFFSET) % PIXEL_RING_COUNT + PIXEL_RING_COUNT)] = pixels[i];
-  }
-}
-
-
-void mirrorLens(const uint8_t rotate) {
-  // I didn't mount the lenses the same, so we need to fiddle a bit to get the mirror effect
-  const int OFFSET = 2;
-  for (int i = 0; i < PIXEL_RING_COUNT; ++i) {
-    pixels[((PIXEL_RING_COUNT * 2 - i + rotate - OFFSET) % PIXEL_RING_COUNT + PIXEL_RING_COUNT)] = pixels[i];
-  }
-}
@@ -0,0 +1,170 @@
+// Generated from python3 bands.py 128 5000 40, don't edit
+#ifndef BANDS_HPP
+#define BANDS_HPP
+
+#include <cstdint>
+
+// Maps FFT bins onto logarithmically spaced bands, so that each octave
+// gets the same number of LEDs. Bins that straddle 2 bands are split
+// between them by how much they overlap, so each band is a short dot
+// product over BAND_WEIGHTS.
+
+static const int BAND_SAMPLE_COUNT = 128;
+static const int BAND_SAMPLING_FREQUENCY_HZ = 5000;
+static const int BAND_COUNT = 40;
+static const int BAND_WEIGHT_BITS = 15;
+
+struct Band {
+  uint8_t firstBin;
+  uint8_t binCount;
+  uint16_t weightOffset;
+};
+
+static const Band BANDS[BAND_COUNT] = {
+  {2, 1, 0},  // 80-87 Hz
+  {2, 1, 1},  // 87-95 Hz
+  {2, 2, 2},  // 95-104 Hz
+  {3, 1, 4},  // 104-113 Hz
+  {3, 1, 5},  // 113-123 Hz
+  {3, 1, 6},  // 123-134 Hz
+  {3, 2, 7},  // 134-146 Hz
+  {4, 1, 9},  // 146-159 Hz
+  {4, 1, 10},  // 159-173 Hz
+  {4, 2, 11},  // 173-189 Hz
+  {5, 1, 13},  // 189-206 Hz
+  {5, 2, 14},  // 206-224 Hz
+  {6, 1, 16},  // 224-244 Hz
+  {6, 2, 17},  // 244-266 Hz
+  {7, 1, 19},  // 266-290 Hz
+  {7, 2, 20},  // 290-316 Hz
+  {8, 2, 22},  // 316-344 Hz
+  {9, 2, 24},  // 344-375 Hz
+  {10, 1, 26},  // 375-409 Hz
+  {10, 2, 27},  // 409-445 Hz
+  {11, 2, 29},  // 445-485 Hz
+  {12, 3, 31},  // 485-529 Hz
+  {14, 2, 34},  // 529-576 Hz
+  {15, 2, 36},  // 576-628 Hz
+  {16, 3, 38},  // 628-684 Hz
+  {18, 2, 41},  // 684-746 Hz
+  {19, 3, 43},  // 746-812 Hz
+  {21, 3, 46},  // 812-885 Hz
+  {23, 3, 49},  // 885-965 Hz
+  {25, 3, 52},  // 965-1051 Hz
+  {27, 3, 55},  // 1051-1145 Hz
+  {29, 4, 58},  // 1145-1248 Hz
+  {32, 4, 62},  // 1248-1360 Hz
+  {35, 4, 66},  // 1360-1482 Hz
+  {38, 4, 70},  // 1482-1615 Hz
+  {41, 5, 74},  // 1615-1760 Hz
+  {45, 5, 79},  // 1760-1917 Hz
+  {49, 5, 84},  // 1917-2089 Hz
+  {53, 6, 89},  // 2089-2276 Hz
+  {58, 6, 95},  // 2276-2480 Hz
+};
+
+static const uint16_t BAND_WEIGHTS[] = {
+  14041,
+  14656,
+  4797, 10503,
+  15970,
+  16671,
+  17402,
+  4253, 13912,
+  18962,
+  19794,
+  3372, 17290,
+  21568,
+  11162, 11352,
+  23502,
+  10835, 13697,
+  25609,
+  3064, 23668,
+  15806, 12099,
+  25272, 3856,
+  30406,
+  1162, 30577,
+  3116, 30016,
+  2292, 31046, 1247,
+  28547, 7555,
+  21255, 16431,
+  11555, 27295, 489,
+  25680, 15384,
+  10312, 25049, 7504,
+  16808, 23997, 3941,
+  19214, 22988, 4506,
+  17706, 22023, 9028,
+  12449, 21097, 17349,
+  3590, 20211, 20211, 9116,
+  10629, 19361, 19361, 6106,
+  12698, 18548, 18548, 8096,
+  10013, 17769, 17769, 14880,
+  2768, 17022, 17022, 17022, 9247,
+  7449, 16307, 16307, 16307, 9478,
+  6542, 15621, 15621, 15621, 15329,
+  281, 14965, 14965, 14965, 14965, 11609,
+  3215, 14336, 14336, 14336, 14336, 14336,
+};
+
+// How loud each band sounds, from the A-weighting curve at the middle of
+// the band, scaled so that the loudest is just under 1 << BAND_WEIGHT_BITS
+static const uint16_t BAND_LOUDNESS[BAND_COUNT] = {
+  2316,  // -21.7 dB at 84 Hz
+  2679,  // -20.5 dB at 91 Hz
+  3083,  // -19.3 dB at 99 Hz
+  3529,  // -18.1 dB at 108 Hz
+  4021,  // -17.0 dB at 118 Hz
+  4559,  // -15.9 dB at 128 Hz
+  5144,  // -14.8 dB at 140 Hz
+  5778,  // -13.8 dB at 152 Hz
+  6462,  // -12.8 dB at 166 Hz
+  7197,  // -11.9 dB at 181 Hz
+  7983,  // -11.0 dB at 197 Hz
+  8820,  // -10.1 dB at 215 Hz
+  9710,  // -9.3 dB at 234 Hz
+  10651,  // -8.5 dB at 255 Hz
+  11642,  // -7.7 dB at 278 Hz
+  12682,  // -7.0 dB at 303 Hz
+  13767,  // -6.3 dB at 330 Hz
+  14893,  // -5.6 dB at 359 Hz
+  16055,  // -4.9 dB at 392 Hz
+  17245,  // -4.3 dB at 427 Hz
+  18455,  // -3.7 dB at 465 Hz
+  19674,  // -3.2 dB at 507 Hz
+  20892,  // -2.6 dB at 552 Hz
+  22097,  // -2.2 dB at 602 Hz
+  23275,  // -1.7 dB at 656 Hz
+  24416,  // -1.3 dB at 714 Hz
+  25507,  // -0.9 dB at 778 Hz
+  26539,  // -0.6 dB at 848 Hz
+  27502,  // -0.3 dB at 924 Hz
+  28390,  // 0.0 dB at 1007 Hz
+  29197,  // 0.3 dB at 1097 Hz
+  29921,  // 0.5 dB at 1196 Hz
+  30560,  // 0.7 dB at 1303 Hz
+  31115,  // 0.8 dB at 1420 Hz
+  31587,  // 0.9 dB at 1547 Hz
+  31978,  // 1.1 dB at 1686 Hz
+  32289,  // 1.1 dB at 1837 Hz
+  32523,  // 1.2 dB at 2001 Hz
+  32682,  // 1.2 dB at 2181 Hz
+  32767,  // 1.3 dB at 2376 Hz
+};
+
+// Combines the magnitudes of the first BAND_SAMPLE_COUNT / 2 bins from an FFT
+// into BAND_COUNT bands. Magnitudes need to be under 2^15 so that the sums
+// can't overflow.
+inline void mapToBands(const uint16_t* const magnitudes, uint16_t* const bands) {
+  for (int i = 0; i < BAND_COUNT; ++i) {
+    const Band& band = BANDS[i];
+    const uint16_t* const bins = &magnitudes[band.firstBin];
+    const uint16_t* const weights = &BAND_WEIGHTS[band.weightOffset];
+    uint32_t sum = 0;
+    for (int j = 0; j < band.binCount; ++j) {
+      sum += static_cast<uint32_t>(bins[j]) * weights[j];
+    }
+    bands[i] = sum >> BAND_WEIGHT_BITS;
+  }
+}
+
+#endif  // BANDS_HPP
@@ -0,0 +1,141 @@
+"""Generates bands.hpp, which maps FFT bins onto logarithmically spaced bands.
+
+The goggles and the monk mask both use this. Run it from the sketch directory:
+    python3 bands.py 128 5000 40 > bands.hpp                    # goggles
+    python3 ../../goggles/bands.py 128 5000 45 > bands.hpp      # monk/mask
+
+Then check that pink noise still comes out flat with goggles/demo/bands.
+"""
+import math
+import sys
+
+# The lowest band starts here. Below this, Hamming window leakage from the
+# microphone's DC offset swamps everything.
+DEFAULT_LOW_HZ = 80
+WEIGHT_BITS = 15
+
+
+def a_weighting(hz):
+    """Gain of the standard A-weighting curve, which is roughly how loud
+    each frequency sounds to people compared to 1 kHz."""
+    f2 = hz * hz
+    gain = (12194 ** 2 * f2 * f2) / (
+        (f2 + 20.6 ** 2)
+        * math.sqrt((f2 + 107.7 ** 2) * (f2 + 737.9 ** 2))
+        * (f2 + 12194 ** 2)
+    )
+    # +2 dB makes 1 kHz come out at 0 dB
+    return gain * 10 ** (2.0 / 20)
+
+
+def main():
+    if "-h" in sys.argv or len(sys.argv) not in (4, 5):
+        print(f"Usage: {sys.argv[0]} <sample_count> <frequency> <band_count> [low_hz]")
+        sys.exit()
+
+    sample_count = int(sys.argv[1])
+    if sample_count not in (2**n for n in range(20)):
+        print(f"sample_count ({sample_count}) must be a power of 2")
+        sys.exit()
+    frequency = int(sys.argv[2])
+    band_count = int(sys.argv[3])
+    low_hz = float(sys.argv[4]) if len(sys.argv) == 5 else DEFAULT_LOW_HZ
+
+    bin_hz = frequency / sample_count
+    # Bin k covers k - 0.5 to k + 0.5, and the last usable bin is just under Nyquist
+    low = low_hz / bin_hz
+    high = sample_count / 2 - 0.5
+    if low < 0.5 or low >= high:
+        print(f"low_hz ({low_hz}) must be between {bin_hz / 2:0.1f} and {high * bin_hz:0.1f}")
+        sys.exit()
+
+    bands = []
+    weights = []
+    ratio = (high / low) ** (1 / band_count)
+    for band in range(band_count):
+        lower = low * ratio ** band
+        upper = low * ratio ** (band + 1)
+        first = int(math.floor(lower + 0.5))
+        last = int(math.floor(upper + 0.5))
+        overlaps = []
+        for bin_ in range(first, last + 1):
+            overlap = min(upper, bin_ + 0.5) - max(lower, bin_ - 0.5)
+            overlaps.append(max(overlap, 0.0))
+        # Drop bins that the band just barely touches
+        while len(overlaps) > 1 and overlaps[-1] < 0.01:
+            overlaps.pop()
+        while len(overlaps) > 1 and overlaps[0] < 0.01:
+            overlaps.pop(0)
+            first += 1
+        # Summing magnitudes over a band that's B bins wide grows with B for
+        # noise, so divide by sqrt(B). Then pink noise, which has the same
+        # power in every octave, comes out flat across the bands.
+        total = sum(overlaps)
+        bands.append((first, len(overlaps), len(weights), lower * bin_hz, upper * bin_hz))
+        for overlap in overlaps:
+            weights.append(round(overlap / math.sqrt(total) * (1 << WEIGHT_BITS)))
+
+    print(f"// Generated from python3 bands.py {' '.join(sys.argv[1:])}, don't edit")
+    print("#ifndef BANDS_HPP")
+    print("#define BANDS_HPP")
+    print()
+    print("#include <cstdint>")
+    print()
+    print("// Maps FFT bins onto logarithmically spaced bands, so that each octave")
+    print("// gets the same number of LEDs. Bins that straddle 2 bands are split")
+    print("// between them by how much they overlap, so each band is a short dot")
+    print("// product over BAND_WEIGHTS.")
+    print()
+    print(f"static const int BAND_SAMPLE_COUNT = {sample_count};")
+    print(f"static const int BAND_SAMPLING_FREQUENCY_HZ = {frequency};")
+    print(f"static const int BAND_COUNT = {band_count};")
+    print(f"static const int BAND_WEIGHT_BITS = {WEIGHT_BITS};")
+    print()
+    print("struct Band {")
+    print("  uint8_t firstBin;")
+    print("  uint8_t binCount;")
+    print("  uint16_t weightOffset;")
+    print("};")
+    print()
+    print("static const Band BANDS[BAND_COUNT] = {")
+    for first, count, offset, lower_hz, upper_hz in bands:
+        print(f"  {{{first}, {count}, {offset}}},  // {lower_hz:0.0f}-{upper_hz:0.0f} Hz")
+    print("};")
+    print()
+    print("static const uint16_t BAND_WEIGHTS[] = {")
+    for first, count, offset, _, _ in bands:
+        print(f"  {', '.join(str(w) for w in weights[offset:offset + count])},")
+    print("};")
+    print()
+    # Scale so the loudest sounding band is just under 1
+    loudness = [a_weighting(math.sqrt(lower_hz * upper_hz)) for _, _, _, lower_hz, upper_hz in bands]
+    loudest = max(loudness)
+    print("// How loud each band sounds, from the A-weighting curve at the middle of")
+    print("// the band, scaled so that the loudest is just under 1 << BAND_WEIGHT_BITS")
+    print("static const uint16_t BAND_LOUDNESS[BAND_COUNT] = {")
+    for (_, _, _, lower_hz, upper_hz), gain in zip(bands, loudness):
+        scaled = round(gain / loudest * ((1 << WEIGHT_BITS) - 1))
+        print(f"  {scaled},  // {20 * math.log10(gain):0.1f} dB at {math.sqrt(lower_hz * upper_hz):0.0f} Hz")
+    print("};")
+    print()
+    print("// Combines the magnitudes of the first BAND_SAMPLE_COUNT / 2 bins from an FFT")
+    print("// into BAND_COUNT bands. Magnitudes need to be under 2^15 so that the sums")
+    print("// can't overflow.")
+    print("inline void mapToBands(const uint16_t* const magnitudes, uint16_t* const bands) {")
+    print("  for (int i = 0; i < BAND_COUNT; ++i) {")
+    print("    const Band& band = BANDS[i];")
+    print("    const uint16_t* const bins = &magnitudes[band.firstBin];")
+    print("    const uint16_t* const weights = &BAND_WEIGHTS[band.weightOffset];")
+    print("    uint32_t sum = 0;")
+    print("    for (int j = 0; j < band.binCount; ++j) {")
+    print("      sum += static_cast<uint32_t>(bins[j]) * weights[j];")
+    print("    }")
+    print("    bands[i] = sum >> BAND_WEIGHT_BITS;")
+    print("  }")
+    print("}")
+    print()
+    print("#endif  // BANDS_HPP")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,68 @@
+#ifndef BASS_ENVELOPE_HPP
+#define BASS_ENVELOPE_HPP
+
+#include <cmath>
+#include <cstdint>
+
+// Measures how loud the bass is in a block of microphone samples using the
+// Goertzel algorithm. Each Goertzel bin is a 2-pole resonator tuned to one
+// FFT bin, so summing the power from the bins between 25 and 200 Hz replaces
+// the old per-sample bass bandpass + rectifier + 10 Hz lowpass chain. One
+// block gives one envelope sample, and with 200 samples at 5 kHz that's the
+// same 25 Hz envelope rate as before.
+//
+// The inner loop is integer only because the M0 doesn't have an FPU. The
+// float math only happens once per bin per block.
+template <int BLOCK_SIZE, int SAMPLE_RATE_HZ>
+class BassEnvelope {
+  public:
+    // Bins are spaced SAMPLE_RATE_HZ / BLOCK_SIZE apart, 25 Hz by default
+    static const int FIRST_BIN = 1;
+    static const int LAST_BIN = 200 * BLOCK_SIZE / SAMPLE_RATE_HZ;
+    static const int BIN_COUNT = LAST_BIN - FIRST_BIN + 1;
+    static_assert(BIN_COUNT > 0, "Blocks are too short to resolve bass");
+
+    // The microphone idles at about this reading
+    static const int16_t CENTER = 503;
+    // Keeps the output on the same scale as the old IIR envelope, so the
+    // numbers in the serial logs still mean the same thing. Measured by
+    // feeding both a 100 Hz sine wave.
+    static constexpr float GAIN = 6.5f;
+
+    BassEnvelope() : coefficients() {
+      for (int i = 0; i < BIN_COUNT; ++i) {
+        const float omega = 2.0f * static_cast<float>(M_PI) * (FIRST_BIN + i) / BLOCK_SIZE;
+        coefficients[i] = static_cast<int32_t>(lroundf(2.0f * cosf(omega) * (1 << COEFFICIENT_BITS)));
+      }
+    }
+
+    // Returns the bass envelope for one block of raw 10-bit ADC readings
+    float process(const int16_t* const samples) const {
+      float power = 0.0f;
+      for (int i = 0; i < BIN_COUNT; ++i) {
+        const int32_t coefficient = coefficients[i];
+        int32_t s1 = 0;
+        int32_t s2 = 0;
+        for (int j = 0; j < BLOCK_SIZE; ++j) {
+          const int32_t s0 =
+            (samples[j] - CENTER)
+            + static_cast<int32_t>((static_cast<int64_t>(coefficient) * s1) >> COEFFICIENT_BITS)
+            - s2;
+          s2 = s1;
+          s1 = s0;
+        }
+        const float f1 = static_cast<float>(s1);
+        const float f2 = static_cast<float>(s2);
+        const float c = static_cast<float>(coefficient) * (1.0f / (1 << COEFFICIENT_BITS));
+        power += f1 * f1 + f2 * f2 - c * f1 * f2;
+      }
+      // A sine wave with amplitude A puts N * A / 2 into its bin
+      return GAIN * 2.0f / BLOCK_SIZE * sqrtf(power);
+    }
+
+  private:
+    static const int COEFFICIENT_BITS = 14;
+    int32_t coefficients[BIN_COUNT];
+};
+
+#endif  // BASS_ENVELOPE_HPP
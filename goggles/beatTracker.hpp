@@ -0,0 +1,212 @@
+#ifndef BEAT_TRACKER_HPP
+#define BEAT_TRACKER_HPP
+
+#include <cmath>
+#include <cstdint>
+
+// Tracks the tempo and phase of the music from the bass envelope.
+//
+// Onsets (increases in the envelope) go into a leaky autocorrelation over
+// every lag in the BPM range, and the strongest lag is the beat period. A
+// phase-locked loop then counts down to the next beat and nudges itself
+// toward strong onsets, so beats are predicted instead of detected after the
+// fact, and a skipped kick drum doesn't stop the beat.
+//
+// This runs once per envelope sample (25 Hz) so floats are fine, even without
+// an FPU. It uses about 300 bytes of RAM.
+template <int RATE_HZ>
+class BeatTracker {
+  public:
+    static const int MINIMUM_BPM = 60;
+    static const int MAXIMUM_BPM = 200;
+
+    BeatTracker() :
+      onsets(),
+      correlations(),
+      weights(),
+      historyIndex(0),
+      previousEnvelope(0.0f),
+      energy(0.0f),
+      averageOnset(0.0f),
+      period(60.0f * RATE_HZ / 120),
+      phase_(0.0f),
+      confidence_(0.0f)
+    {
+      // Autocorrelation also peaks at 2x and 1/2x the real period, so give a
+      // bias toward common dance tempos, centered on 120 BPM
+      for (int i = 0; i < PAIR_COUNT; ++i) {
+        const float octaves = log2f(60.0f * RATE_HZ / (MINIMUM_LAG + i + 0.5f) / 120.0f);
+        weights[i] = expf(-0.5f * octaves * octaves);
+      }
+    }
+
+    // Feeds in one envelope sample. Returns true if this sample is on the
+    // beat. This fires LATENCY_SAMPLES early to make up for the time it
+    // takes to collect and filter the audio.
+    bool update(const float envelope) {
+      const float onset = envelope > previousEnvelope ? envelope - previousEnvelope : 0.0f;
+      previousEnvelope = envelope;
+
+      // Remove the average so that steady noise doesn't correlate with itself
+      const float centered = onset - averageOnset;
+      averageOnset = DECAY * averageOnset + (1.0f - DECAY) * onset;
+
+      energy = DECAY * energy + centered * centered;
+      for (int lag = MINIMUM_LAG; lag <= MAXIMUM_LAG + 1; ++lag) {
+        const float past = onsets[(historyIndex + HISTORY_LENGTH - lag) % HISTORY_LENGTH];
+        float& correlation = correlations[lag - MINIMUM_LAG];
+        correlation = DECAY * correlation + centered * past;
+      }
+      // The previous onset is a peak if it's bigger than its neighbors
+      const float previous = onsets[(historyIndex + HISTORY_LENGTH - 1) % HISTORY_LENGTH];
+      const float beforePrevious = onsets[(historyIndex + HISTORY_LENGTH - 2) % HISTORY_LENGTH];
+      const bool previousWasPeak = previous > beforePrevious && previous >= centered && previous > averageOnset;
+
+      onsets[historyIndex] = centered;
+      historyIndex = (historyIndex + 1) % HISTORY_LENGTH;
+
+      updatePeriod();
+
+      phase_ += 1.0f;
+      if (previousWasPeak) {
+        // Nudge the phase so that the next predicted beat lines up with this
+        // onset. The peak was 1 sample ago, and we predict beats early.
+        float error = fmodf(phase_ - 1.0f - LATENCY_SAMPLES, period);
+        if (error >= period / 2) {
+          error -= period;
+        } else if (error < -period / 2) {
+          error += period;
+        }
+        phase_ -= PHASE_GAIN * error;
+      }
+      if (phase_ >= period) {
+        // The period can shrink by more than a beat, so wrap instead of
+        // subtracting
+        phase_ = fmodf(phase_, period);
+        return true;
+      }
+      return false;
+    }
+
+    float bpm() const {
+      return 60.0f * RATE_HZ / period;
+    }
+
+    // How far we are from the last beat to the next one, 0 - 255
+    uint8_t phase() const {
+      const float ratio = phase_ / period;
+      if (ratio <= 0.0f) {
+        return 0;
+      }
+      return ratio >= 1.0f ? 255 : static_cast<uint8_t>(ratio * 255.0f);
+    }
+
+    // How strongly the music repeats at the tracked tempo, 0 - 255
+    uint8_t confidence() const {
+      return static_cast<uint8_t>(confidence_ * 255.0f);
+    }
+
+    // Predicted time until the next beat
+    uint16_t millisToNextBeat() const {
+      const float samples = period - phase_;
+      return samples <= 0.0f ? 0 : static_cast<uint16_t>(samples * 1000 / RATE_HZ);
+    }
+
+  private:
+    static const int MINIMUM_LAG = 60 * RATE_HZ / MAXIMUM_BPM;
+    static const int MAXIMUM_LAG = 60 * RATE_HZ / MINIMUM_BPM;
+    // Periods are usually a fractional number of samples, so the
+    // correlation gets split between 2 adjacent lags. Score adjacent pairs
+    // instead of single lags.
+    static const int LAG_COUNT = MAXIMUM_LAG - MINIMUM_LAG + 2;
+    static const int PAIR_COUNT = LAG_COUNT - 1;
+    static const int HISTORY_LENGTH = MAXIMUM_LAG + 2;
+    static_assert(MINIMUM_LAG >= 3, "RATE_HZ is too slow for MAXIMUM_BPM");
+
+    // About 4 seconds of memory at 25 Hz
+    static constexpr float DECAY = 0.99f;
+    // How quickly the period and phase follow the music
+    static constexpr float PERIOD_GAIN = 0.1f;
+    static constexpr float PHASE_GAIN = 0.2f;
+    static constexpr float LATENCY_SAMPLES = 1.5f;
+
+    float onsets[HISTORY_LENGTH];
+    float correlations[LAG_COUNT];
+    float weights[PAIR_COUNT];
+    uint8_t historyIndex;
+    float previousEnvelope;
+    float energy;
+    float averageOnset;
+    float period;  // In envelope samples
+    float phase_;  // Envelope samples since the last beat
+    float confidence_;
+
+    float pairSum(const int i) const {
+      return correlations[i] + correlations[i + 1];
+    }
+
+    void updatePeriod() {
+      int best = 0;
+      float bestScore = 0.0f;
+      for (int i = 0; i < PAIR_COUNT; ++i) {
+        const float score = pairSum(i) * weights[i];
+        if (score > bestScore) {
+          best = i;
+          bestScore = score;
+        }
+      }
+      // If there are strong onsets halfway between the beats too, we probably
+      // found a multiple of the real period
+      while (true) {
+        const int half = (2 * (MINIMUM_LAG + best) + 1) / 4 - MINIMUM_LAG;
+        int halfBest = -1;
+        for (int i = half - 1; i <= half + 1; ++i) {
+          if (i >= 0 && (halfBest < 0 || pairSum(i) > pairSum(halfBest))) {
+            halfBest = i;
+          }
+        }
+        if (halfBest < 0 || pairSum(halfBest) < 0.5f * pairSum(best)) {
+          break;
+        }
+        best = halfBest;
+      }
+
+      const float total = pairSum(best);
+      if (energy <= 0.0f || total <= 0.0f) {
+        confidence_ = 0.0f;
+        return;
+      }
+      confidence_ = total / energy;
+      if (confidence_ > 1.0f) {
+        confidence_ = 1.0f;
+      }
+
+      // Kick drums last more than one sample, so the correlation also spills
+      // into the neighbors of the pair. The centroid gives the fractional
+      // period.
+      const int first = best > 0 ? best - 1 : 0;
+      const int last = best + 2 < LAG_COUNT ? best + 2 : LAG_COUNT - 1;
+      float weightedSum = 0.0f;
+      float sum = 0.0f;
+      for (int i = first; i <= last; ++i) {
+        weightedSum += i * correlations[i];
+        sum += correlations[i];
+      }
+      // The neighbors can be negative enough to cancel out the pair, and
+      // then the centroid could be anywhere
+      if (sum <= 0.0f) {
+        return;
+      }
+      const float lag = clampLag(MINIMUM_LAG + weightedSum / sum);
+      period = clampLag(period + PERIOD_GAIN * confidence_ * (lag - period));
+    }
+
+    static float clampLag(const float lag) {
+      if (lag < MINIMUM_LAG) {
+        return MINIMUM_LAG;
+      }
+      return lag > MAXIMUM_LAG + 1 ? MAXIMUM_LAG + 1 : lag;
+    }
+};
+
+#endif  // BEAT_TRACKER_HPP
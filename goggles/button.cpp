@@ -0,0 +1,78 @@
+#include <Arduino.h>
+
+#include "button.hpp"
+
+// Like the sampler, this drives the SAMD21's timer registers directly. TC4
+// isn't used by FastLED, the Arduino core (Tone uses TC5) or the sampler (TC3).
+
+static ButtonTracker tracker;
+static uint8_t buttonPin = 0;
+
+static void syncTc4() {
+  while (TC4->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+// Calls tracker.update() from the timer after delay_ms, replacing whatever
+// was scheduled before. 0 just stops the timer.
+static void scheduleUpdate(const uint16_t delay_ms) {
+  TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+  syncTc4();
+  if (delay_ms == 0) {
+    return;
+  }
+  // The timer runs at 48 MHz / 1024, so 16 bits is good for 1.4 seconds
+  TC4->COUNT16.COUNT.reg = 0;
+  syncTc4();
+  TC4->COUNT16.CC[0].reg = static_cast<uint32_t>(delay_ms) * (SystemCoreClock / 1024) / 1000;
+  syncTc4();
+  TC4->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  TC4->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+  syncTc4();
+}
+
+static bool isPinDown() {
+  return digitalRead(buttonPin) == LOW;
+}
+
+static void onEdge() {
+  scheduleUpdate(tracker.edge(millis()));
+}
+
+
+void startButton(const uint8_t pin) {
+  buttonPin = pin;
+  pinMode(pin, INPUT_PULLUP);
+
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TC4_TC5;
+  while (GCLK->STATUS.bit.SYNCBUSY);
+
+  TC4->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+  syncTc4();
+  TC4->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV1024;
+  syncTc4();
+  TC4->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+  // attachInterrupt puts the pin change interrupt at priority 0 too, so the
+  // two handlers can't interrupt each other in the middle of the tracker
+  NVIC_SetPriority(TC4_IRQn, 0);
+  NVIC_EnableIRQ(TC4_IRQn);
+
+  attachInterrupt(digitalPinToInterrupt(pin), onEdge, CHANGE);
+  // In case it's already down
+  onEdge();
+}
+
+
+bool takeButtonEvent(ButtonEvent* const event) {
+  return tracker.take(event);
+}
+
+
+bool isButtonDown() {
+  return tracker.isDown();
+}
+
+
+void TC4_Handler() {
+  TC4->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  scheduleUpdate(tracker.update(isPinDown(), millis()));
+}
@@ -0,0 +1,79 @@
+#ifndef COMPOSITOR_HPP
+#define COMPOSITOR_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <FastLED.h>
+
+// Cross fades between animations instead of cutting to black. Each animation
+// draws into its own layer, which keeps its contents between frames because
+// some animations only redraw the pixels that changed. The compositor then
+// copies or blends the layers into the pixels that FastLED shows, so a frame
+// costs one extra pass over the pixels. For the goggles that's 2 layers of
+// 40 pixels, 240 bytes.
+template <int PIXEL_COUNT>
+class Compositor {
+  public:
+    Compositor() : layers(), front(0), fading(false), fadeStart_ms(0), fade_ms(0) {}
+
+    // The layer that the current animation draws into
+    CRGB* current() {
+      return layers[front];
+    }
+
+    // The layer that the next animation draws into while we're fading
+    CRGB* incoming() {
+      return layers[front ^ 1];
+    }
+
+    bool isFading() const {
+      return fading;
+    }
+
+    // Starts fading from the current layer to a blank incoming layer
+    void startFade(const uint32_t now_ms, const uint16_t duration_ms) {
+      fill_solid(incoming(), PIXEL_COUNT, CRGB::Black);
+      fading = true;
+      fadeStart_ms = now_ms;
+      fade_ms = duration_ms;
+    }
+
+    // Skips the fade and starts the next animation from black
+    void cut() {
+      fill_solid(layers[0], PIXEL_COUNT, CRGB::Black);
+      fill_solid(layers[1], PIXEL_COUNT, CRGB::Black);
+      fading = false;
+    }
+
+    // Writes the blended layers to output. Once the fade is done, the
+    // incoming layer becomes the current layer. Returns true if that happened.
+    bool compose(const uint32_t now_ms, CRGB* const output) {
+      if (fading && now_ms - fadeStart_ms >= fade_ms) {
+        front ^= 1;
+        fading = false;
+        memcpy(output, current(), sizeof(layers[0]));
+        return true;
+      }
+      if (!fading) {
+        memcpy(output, current(), sizeof(layers[0]));
+        return false;
+      }
+
+      const fract8 amount = (now_ms - fadeStart_ms) * 256 / fade_ms;
+      const CRGB* const from = current();
+      const CRGB* const to = incoming();
+      for (int i = 0; i < PIXEL_COUNT; ++i) {
+        output[i] = blend(from[i], to[i], amount);
+      }
+      return false;
+    }
+
+  private:
+    CRGB layers[2][PIXEL_COUNT];
+    uint8_t front;
+    bool fading;
+    uint32_t fadeStart_ms;
+    uint16_t fade_ms;
+};
+
+#endif  // COMPOSITOR_HPP
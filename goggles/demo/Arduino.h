@@ -0,0 +1,12 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// constants.hpp needs the microphone pin. Nothing here uses it.
+const int A1 = 1;
+
+// Programs that build the animations provide these, so that they can run on
+// a pretend clock with a fixed random seed
+unsigned long millis();
+long random(long maximum);
+
+#endif  // ARDUINO_H
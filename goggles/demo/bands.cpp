@@ -0,0 +1,128 @@
+// Runs pink noise through a 128-point Hamming DFT and the generated
+// mapToBands() for the goggles' 40 bands and the mask's 45. Pink noise has
+// the same power in every octave, so every band should come out about the
+// same. Prints each band and exits with 1 if the loudest and quietest bands
+// are further apart than bands.py promises.
+//
+//     ./bands
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+// Both headers use the same names and include guard
+namespace goggles {
+#include "../bands.hpp"
+}
+#undef BANDS_HPP
+namespace mask {
+#include "../../monk/mask/bands.hpp"
+}
+
+static const int SAMPLE_COUNT = 128;
+static const int FRAME_COUNT = 20000;
+// Keeps the magnitudes well under the 2^15 that mapToBands() allows
+static const double MAGNITUDE_SCALE = 40.0;
+
+static_assert(goggles::BAND_SAMPLE_COUNT == SAMPLE_COUNT, "Regenerate bands.hpp");
+static_assert(mask::BAND_SAMPLE_COUNT == SAMPLE_COUNT, "Regenerate bands.hpp");
+
+static uint32_t randomState = 1;
+
+// -1 to 1
+static double randomWhite() {
+  randomState = randomState * 1103515245 + 12345;
+  return static_cast<double>((randomState >> 8) & 0xFFFF) / 0x8000 - 1.0;
+}
+
+// Paul Kellet's filter, which is within 0.05 dB of pink above 10 Hz
+static double randomPink() {
+  static double b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0;
+  const double white = randomWhite();
+  b0 = 0.99886 * b0 + white * 0.0555179;
+  b1 = 0.99332 * b1 + white * 0.0750759;
+  b2 = 0.96900 * b2 + white * 0.1538520;
+  b3 = 0.86650 * b3 + white * 0.3104856;
+  b4 = 0.55000 * b4 + white * 0.5329522;
+  b5 = -0.7616 * b5 - white * 0.0168980;
+  const double pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362;
+  b6 = white * 0.115926;
+  return pink;
+}
+
+// Averages each band over FRAME_COUNT frames of pink noise and returns the
+// spread between the loudest and quietest bands in dB
+template <int BAND_COUNT>
+static double spread(
+  const char* const name,
+  void (*const mapToBands)(const uint16_t*, uint16_t*)
+) {
+  double window[SAMPLE_COUNT];
+  double cosines[SAMPLE_COUNT], sines[SAMPLE_COUNT];
+  for (int i = 0; i < SAMPLE_COUNT; ++i) {
+    window[i] = 0.54 - 0.46 * cos(2 * M_PI * i / (SAMPLE_COUNT - 1));
+    cosines[i] = cos(2 * M_PI * i / SAMPLE_COUNT);
+    sines[i] = sin(2 * M_PI * i / SAMPLE_COUNT);
+  }
+
+  randomState = 1;
+  double totals[BAND_COUNT] = {};
+  for (int frame = 0; frame < FRAME_COUNT; ++frame) {
+    double samples[SAMPLE_COUNT];
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+      samples[i] = randomPink() * window[i];
+    }
+    uint16_t magnitudes[SAMPLE_COUNT / 2];
+    for (int k = 0; k < SAMPLE_COUNT / 2; ++k) {
+      double real = 0, imaginary = 0;
+      for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        real += samples[i] * cosines[k * i % SAMPLE_COUNT];
+        imaginary -= samples[i] * sines[k * i % SAMPLE_COUNT];
+      }
+      const long magnitude = lround(sqrt(real * real + imaginary * imaginary) * MAGNITUDE_SCALE);
+      if (magnitude >= 1 << 15) {
+        printf("Magnitude %ld is too big for mapToBands()\n", magnitude);
+        return INFINITY;
+      }
+      magnitudes[k] = magnitude;
+    }
+    uint16_t bands[BAND_COUNT];
+    mapToBands(magnitudes, bands);
+    for (int i = 0; i < BAND_COUNT; ++i) {
+      totals[i] += bands[i];
+    }
+  }
+
+  double quietest = totals[0], loudest = totals[0];
+  for (int i = 0; i < BAND_COUNT; ++i) {
+    quietest = fmin(quietest, totals[i]);
+    loudest = fmax(loudest, totals[i]);
+  }
+  printf("%s:", name);
+  for (int i = 0; i < BAND_COUNT; ++i) {
+    printf(" %.1f", 20 * log10(totals[i] / loudest));
+  }
+  const double spread_dB = 20 * log10(loudest / quietest);
+  printf("\n  %d bands, %.2f dB between the loudest and quietest\n", BAND_COUNT, spread_dB);
+  return spread_dB;
+}
+
+
+int main() {
+  // What bands.py was checked against when it was written
+  const double GOGGLES_LIMIT_DB = 1.5;
+  const double MASK_LIMIT_DB = 1.7;
+
+  const double goggles_dB = spread<goggles::BAND_COUNT>("Goggles", goggles::mapToBands);
+  const double mask_dB = spread<mask::BAND_COUNT>("Mask", mask::mapToBands);
+  bool ok = true;
+  if (goggles_dB > GOGGLES_LIMIT_DB) {
+    printf("The goggles' bands should be within %.1f dB\n", GOGGLES_LIMIT_DB);
+    ok = false;
+  }
+  if (mask_dB > MASK_LIMIT_DB) {
+    printf("The mask's bands should be within %.1f dB\n", MASK_LIMIT_DB);
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
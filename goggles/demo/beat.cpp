@@ -0,0 +1,427 @@
+// Runs microphone audio through the goggles' beat detection and through the
+// filter chain it replaced, and compares them. The old chain ran
+// bassFilter, the rectifier and envelopeFilter on every sample, then
+// beatFilter and the _beatDetected state machine on every 200th. Now
+// BassEnvelope does the bass envelope a block at a time, and BeatTracker
+// finds the beats.
+//
+// It prints how well the old and new envelopes line up after beatFilter, how
+// many beats the old state machine finds from each of them, and what the
+// tracker makes of it. With --test, it makes up kick drum tracks from 90 to
+// 160 BPM instead of reading a WAV file, and checks every detection against
+// when the kicks really were. It exits with 1 if the envelopes don't match,
+// or the tracker gets the tempo wrong or finds fewer of the kicks than the
+// old chain did.
+//
+//     ./beat song.wav
+//     ./beat --test
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../bassEnvelope.hpp"
+#include "../beatTracker.hpp"
+
+static const int SAMPLE_RATE_HZ = 5000;
+static const int FILTER_SAMPLES = 200;
+static const int ENVELOPE_RATE_HZ = SAMPLE_RATE_HZ / FILTER_SAMPLES;
+// Same as beatDetector.cpp
+static const uint8_t MINIMUM_CONFIDENCE = 128;
+// Detections this many envelope samples apart count as the same beat. The
+// old chain is late by about the filter delay and the tracker is early on
+// purpose, so this is generous.
+static const int MATCH_SAMPLES = 3;
+// Give the filters and the tracker this long to settle before counting
+static const int SETTLE_SECONDS = 5;
+
+
+// The old chain from beatDetector.cpp, with its statics moved into a struct
+// so that it can run twice
+struct OldChain {
+  typedef int16_t beatLevel_t;
+  static const beatLevel_t THRESHOLD = 5;
+  static const int MINIMUM_PEAK_INTERVAL = 9;  // 166.67 BPM
+  static const int MAXIMUM_PEAK_INTERVAL = 18;  // 83.33 BPM
+
+  float bassX[3] = {0, 0, 0}, bassY[3] = {0, 0, 0};
+  float envelopeX[2] = {0, 0}, envelopeY[2] = {0, 0};
+  float beatX[3] = {0, 0, 0}, beatY[3] = {0, 0, 0};
+
+  // 20 - 200 hz Single Pole Bandpass IIR Filter
+  float bassFilter(const float sample) {
+    bassX[0] = bassX[1]; bassX[1] = bassX[2];
+    bassX[2] = sample / 3.f;
+    bassY[0] = bassY[1]; bassY[1] = bassY[2];
+    bassY[2] = (bassX[2] - bassX[0]) + (-0.7960060012f * bassY[0]) + (1.7903124146f * bassY[1]);
+    return bassY[2];
+  }
+
+  // 10 hz Single Pole Lowpass IIR Filter
+  float envelopeFilter(const float sample) {
+    envelopeX[0] = envelopeX[1];
+    envelopeX[1] = sample / 50.f;
+    envelopeY[0] = envelopeY[1];
+    envelopeY[1] = (envelopeX[0] + envelopeX[1]) + (0.9875119299f * envelopeY[0]);
+    return envelopeY[1];
+  }
+
+  // 1.7 - 3.0hz Single Pole Bandpass IIR Filter
+  float beatFilter(const float sample) {
+    beatX[0] = beatX[1]; beatX[1] = beatX[2];
+    beatX[2] = sample / 2.7f;
+    beatY[0] = beatY[1]; beatY[1] = beatY[2];
+    beatY[2] = (beatX[2] - beatX[0]) + (-0.7169861741f * beatY[0]) + (1.4453653501f * beatY[1]);
+    return beatY[2];
+  }
+
+  // getBeat() without the ADC and the busy wait
+  float envelope(const int16_t* const samples) {
+    float envelope = 0.0f;
+    for (int i = 0; i < FILTER_SAMPLES; ++i) {
+      float value = bassFilter(static_cast<float>(samples[i]) - 503.f);
+      if (value < 0) {
+        value = -value;
+      }
+      envelope = envelopeFilter(value);
+    }
+    return envelope;
+  }
+
+  beatLevel_t previousBeat = 0;
+  bool increasing = false;
+  uint8_t peakInterval = 14;
+  uint8_t samplesSinceLastPeak = MINIMUM_PEAK_INTERVAL;
+  uint8_t missedPeaks = 5;
+  bool lookingForNextPeak = false;
+  uint16_t beatsSinceLastDetected = 0;
+
+  bool _beatDetected(const beatLevel_t currentBeat) {
+    const int MISSES_BEFORE_RESET = 5;
+    ++samplesSinceLastPeak;
+
+    if (missedPeaks >= MISSES_BEFORE_RESET) {
+      if (increasing && currentBeat < previousBeat && currentBeat >= THRESHOLD) {
+        if (lookingForNextPeak) {
+          peakInterval = samplesSinceLastPeak;
+          lookingForNextPeak = false;
+          samplesSinceLastPeak = 0;
+          missedPeaks = 0;
+          return true;
+        } else if (MINIMUM_PEAK_INTERVAL <= samplesSinceLastPeak && samplesSinceLastPeak <= MAXIMUM_PEAK_INTERVAL) {
+          peakInterval = samplesSinceLastPeak;
+          lookingForNextPeak = true;
+          samplesSinceLastPeak = 0;
+          return true;
+        }
+      } else if (lookingForNextPeak && samplesSinceLastPeak > MAXIMUM_PEAK_INTERVAL) {
+        lookingForNextPeak = false;
+        samplesSinceLastPeak = 0;
+      }
+      return false;
+    }
+
+    if (peakInterval - 2 <= samplesSinceLastPeak && samplesSinceLastPeak <= peakInterval + 3) {
+      if (increasing && currentBeat < previousBeat) {
+        missedPeaks = 0;
+        if (peakInterval < samplesSinceLastPeak) {
+          ++peakInterval;
+        } else if (peakInterval > samplesSinceLastPeak) {
+          --peakInterval;
+        }
+        samplesSinceLastPeak = 1;
+        return true;
+      }
+      return false;
+    } else if (samplesSinceLastPeak > peakInterval + 3) {
+      samplesSinceLastPeak = 4;
+    }
+
+    if (samplesSinceLastPeak == peakInterval) {
+      ++missedPeaks;
+      return true;
+    }
+    return false;
+  }
+
+  // beatDetected(), taking the envelope instead of reading it
+  bool beatDetected(const float envelope, float* const level) {
+    *level = beatFilter(envelope);
+    const beatLevel_t currentBeat = static_cast<beatLevel_t>(*level);
+    const bool detected = _beatDetected(currentBeat);
+    increasing = currentBeat > previousBeat;
+    previousBeat = currentBeat;
+    if (detected && beatsSinceLastDetected >= MINIMUM_PEAK_INTERVAL) {
+      beatsSinceLastDetected = 0;
+      return true;
+    }
+    ++beatsSinceLastDetected;
+    return false;
+  }
+};
+
+
+// Beats found, and how many of them were within MATCH_SAMPLES of a real kick
+struct Beats {
+  std::vector<int> indexes;
+  int hits;
+};
+
+struct Result {
+  float correlation;
+  Beats oldChain;
+  Beats newEnvelope;
+  Beats tracker;
+  int kicks;
+  float bpm;
+  int confidence;
+};
+
+
+static uint32_t readLittleEndian(const uint8_t* const bytes, const int length) {
+  uint32_t value = 0;
+  for (int i = length - 1; i >= 0; --i) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+
+// Reads a 16 bit PCM WAV file and turns it into what the goggles' ADC would
+// read: mono, 5 kHz, 10 bits, centered on 503
+static bool readWav(const std::string& path, std::vector<int16_t>* const samples) {
+  FILE* const file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    printf("%s: couldn't read it\n", path.c_str());
+    return false;
+  }
+  std::vector<uint8_t> contents;
+  uint8_t buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    contents.insert(contents.end(), buffer, buffer + read);
+  }
+  fclose(file);
+
+  if (contents.size() < 12 || memcmp(&contents[0], "RIFF", 4) != 0 || memcmp(&contents[8], "WAVE", 4) != 0) {
+    printf("%s: not a WAV file\n", path.c_str());
+    return false;
+  }
+  int channels = 0;
+  int rate_Hz = 0;
+  size_t offset = 12;
+  while (offset + 8 <= contents.size()) {
+    const uint8_t* const chunk = &contents[offset];
+    const size_t size = std::min<size_t>(readLittleEndian(chunk + 4, 4), contents.size() - offset - 8);
+    if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+      const uint32_t format = readLittleEndian(chunk + 8, 2);
+      channels = readLittleEndian(chunk + 10, 2);
+      rate_Hz = readLittleEndian(chunk + 12, 4);
+      if (format != 1 || readLittleEndian(chunk + 22, 2) != 16 || channels == 0 || rate_Hz < SAMPLE_RATE_HZ) {
+        printf("%s: only 16 bit PCM at 5 kHz or more is supported\n", path.c_str());
+        return false;
+      }
+    } else if (memcmp(chunk, "data", 4) == 0 && channels > 0) {
+      const size_t frameCount = size / (channels * 2);
+      const auto mono = [&](const size_t i) {
+        int sum = 0;
+        for (int channel = 0; channel < channels; ++channel) {
+          sum += static_cast<int16_t>(readLittleEndian(chunk + 8 + (i * channels + channel) * 2, 2));
+        }
+        return static_cast<float>(sum) / channels;
+      };
+      // Linear interpolation. The goggles don't filter before the ADC
+      // either.
+      const size_t length = frameCount * SAMPLE_RATE_HZ / rate_Hz;
+      samples->resize(length);
+      for (size_t i = 0; i < length; ++i) {
+        const float position = static_cast<float>(i) * rate_Hz / SAMPLE_RATE_HZ;
+        const size_t before = static_cast<size_t>(position);
+        const size_t after = before + 1 < frameCount ? before + 1 : before;
+        const float fraction = position - before;
+        const float value = mono(before) * (1.0f - fraction) + mono(after) * fraction;
+        (*samples)[i] = static_cast<int16_t>(lroundf(503.0f + value * 512.0f / 32768.0f));
+      }
+      return true;
+    }
+    offset += 8 + size + (size & 1);
+  }
+  printf("%s: no audio in it\n", path.c_str());
+  return false;
+}
+
+
+// A kick drum on every beat, with some hiss and a hi-hat in between
+static void makeTrack(const float bpm, const int seconds, std::vector<int16_t>* const samples) {
+  const float pi = static_cast<float>(M_PI);
+  const int length = SAMPLE_RATE_HZ * seconds;
+  const float beat_s = 60.0f / bpm;
+  samples->resize(length);
+  uint32_t noise = 1;
+  for (int i = 0; i < length; ++i) {
+    const float t = static_cast<float>(i) / SAMPLE_RATE_HZ;
+    const float sinceBeat = fmodf(t, beat_s);
+    const float sinceHat = fmodf(t + beat_s / 2, beat_s);
+    noise = noise * 1103515245 + 12345;
+    const float hiss = static_cast<float>(static_cast<int>((noise >> 16) & 0xFF) - 128) / 128.0f;
+    const float kick = 200.0f * expf(-sinceBeat * 20.0f) * sinf(2.0f * pi * 60.0f * sinceBeat);
+    const float hat = 60.0f * expf(-sinceHat * 80.0f) * hiss;
+    (*samples)[i] = static_cast<int16_t>(lroundf(503.0f + kick + hat + 10.0f * hiss));
+  }
+}
+
+
+// Counts the beats after settling that are close to a kick. With no kicks,
+// everything counts as a hit.
+static void score(const std::vector<int>& kicks, Beats* const beats) {
+  beats->hits = 0;
+  for (const int beat : beats->indexes) {
+    if (beat < SETTLE_SECONDS * ENVELOPE_RATE_HZ) {
+      continue;
+    }
+    bool hit = kicks.empty();
+    for (const int kick : kicks) {
+      hit = hit || abs(beat - kick) <= MATCH_SAMPLES;
+    }
+    beats->hits += hit;
+  }
+}
+
+
+// kicks are envelope sample indexes of the real beats, if they're known
+static Result run(const std::vector<int16_t>& samples, const std::vector<int>& kicks, const bool print) {
+  OldChain oldChain;
+  OldChain newChain;
+  BassEnvelope<FILTER_SAMPLES, SAMPLE_RATE_HZ> bassEnvelope;
+  BeatTracker<ENVELOPE_RATE_HZ> beatTracker;
+
+  std::vector<float> oldLevels;
+  std::vector<float> newLevels;
+  Result result = Result();
+  for (size_t start = 0; start + FILTER_SAMPLES <= samples.size(); start += FILTER_SAMPLES) {
+    const int index = start / FILTER_SAMPLES;
+    float oldLevel;
+    float newLevel;
+    const bool oldBeat = oldChain.beatDetected(oldChain.envelope(&samples[start]), &oldLevel);
+    const float envelope = bassEnvelope.process(&samples[start]);
+    const bool newBeat = newChain.beatDetected(envelope, &newLevel);
+    const bool tracked = beatTracker.update(envelope) && beatTracker.confidence() >= MINIMUM_CONFIDENCE;
+    oldLevels.push_back(oldLevel);
+    newLevels.push_back(newLevel);
+    if (oldBeat) {
+      result.oldChain.indexes.push_back(index);
+    }
+    if (newBeat) {
+      result.newEnvelope.indexes.push_back(index);
+    }
+    if (tracked) {
+      result.tracker.indexes.push_back(index);
+    }
+    if (print && (oldBeat || newBeat || tracked)) {
+      printf(
+        "%6.2f s old:%-4s new:%-4s tracked:%-4s bpm:%5.1f conf:%3d\n",
+        static_cast<float>(index) / ENVELOPE_RATE_HZ,
+        oldBeat ? "beat" : "",
+        newBeat ? "beat" : "",
+        tracked ? "beat" : "",
+        beatTracker.bpm(),
+        beatTracker.confidence());
+    }
+  }
+
+  // Pearson correlation of the beatFilter outputs, skipping the first couple
+  // of seconds while the filters settle
+  const size_t skip = 2 * ENVELOPE_RATE_HZ;
+  double sumOld = 0, sumNew = 0, sumOldOld = 0, sumNewNew = 0, sumOldNew = 0;
+  const double count = oldLevels.size() > skip ? oldLevels.size() - skip : 0;
+  for (size_t i = skip; i < oldLevels.size(); ++i) {
+    sumOld += oldLevels[i];
+    sumNew += newLevels[i];
+    sumOldOld += oldLevels[i] * oldLevels[i];
+    sumNewNew += newLevels[i] * newLevels[i];
+    sumOldNew += oldLevels[i] * newLevels[i];
+  }
+  const double covariance = sumOldNew - sumOld * sumNew / count;
+  const double variances = (sumOldOld - sumOld * sumOld / count) * (sumNewNew - sumNew * sumNew / count);
+  result.correlation = count > 0 && variances > 0 ? covariance / sqrt(variances) : 0.0;
+
+  score(kicks, &result.oldChain);
+  score(kicks, &result.newEnvelope);
+  score(kicks, &result.tracker);
+  for (const int kick : kicks) {
+    result.kicks += kick >= SETTLE_SECONDS * ENVELOPE_RATE_HZ;
+  }
+  result.bpm = beatTracker.bpm();
+  result.confidence = beatTracker.confidence();
+  return result;
+}
+
+
+static void printResult(const Result& result) {
+  printf("envelope correlation %.3f, beats (on a kick/all) after %d s:", result.correlation, SETTLE_SECONDS);
+  if (result.kicks > 0) {
+    printf(" real %d,", result.kicks);
+  }
+  printf(
+    " old chain %d/%zu, new envelope %d/%zu, tracker %d/%zu at %.1f BPM, confidence %d\n",
+    result.oldChain.hits,
+    result.oldChain.indexes.size(),
+    result.newEnvelope.hits,
+    result.newEnvelope.indexes.size(),
+    result.tracker.hits,
+    result.tracker.indexes.size(),
+    result.bpm,
+    result.confidence);
+}
+
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s song.wav | --test\n", argv[0]);
+    return 1;
+  }
+
+  if (strcmp(argv[1], "--test") != 0) {
+    std::vector<int16_t> samples;
+    if (!readWav(argv[1], &samples)) {
+      return 1;
+    }
+    printResult(run(samples, std::vector<int>(), true));
+    return 0;
+  }
+
+  bool good = true;
+  const int seconds = 30;
+  for (int bpm = 90; bpm <= 160; bpm += 10) {
+    std::vector<int16_t> samples;
+    makeTrack(bpm, seconds, &samples);
+    std::vector<int> kicks;
+    for (int i = 0; i * 60 < seconds * bpm; ++i) {
+      kicks.push_back(i * 60 * ENVELOPE_RATE_HZ / bpm);
+    }
+    const Result result = run(samples, kicks, false);
+    printf("%3d BPM: ", bpm);
+    printResult(result);
+    // The periods are whole envelope samples plus a centroid, so the tempo
+    // is only good to a few BPM
+    const bool envelopeGood = result.correlation >= 0.99f;
+    const bool trackerGood =
+      fabsf(result.bpm - bpm) <= bpm * 0.05f
+      && result.confidence >= MINIMUM_CONFIDENCE
+      && result.tracker.hits >= result.oldChain.hits;
+    if (!envelopeGood) {
+      printf("  The new envelope doesn't match the old chain\n");
+    }
+    if (!trackerGood) {
+      printf("  The tracker is worse than the old chain\n");
+    }
+    good = good && envelopeGood && trackerGood;
+  }
+  printf(good ? "Everything matches\n" : "Something's wrong\n");
+  return good ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+// Unit tests for ButtonTracker, with made up edges in place of the pin
+// change interrupt and a pretend timer, the way button.cpp wires them up.
+// Covers bouncing contacts, long and double presses, a late timer, the queue
+// filling up and millis() wrapping. The monk mask has the same button.hpp.
+// Exits with 1 if any test fails.
+//
+//     ./button
+
+#include <cstdint>
+#include <cstdio>
+
+#include "../button.hpp"
+
+static const uint16_t DEBOUNCE_MS = ButtonTracker::DEBOUNCE_MS;
+static const uint16_t LONG_PRESS_MS = ButtonTracker::LONG_PRESS_MS;
+static const uint16_t GAP_MS = ButtonTracker::DOUBLE_PRESS_GAP_MS;
+
+// A pin level from this time on
+struct Edge {
+  uint32_t time_ms;
+  bool down;
+};
+
+struct Event {
+  uint32_t time_ms;
+  ButtonEvent event;
+};
+
+// Plays edges into a tracker one millisecond at a time. The timer can run
+// late, like when something holds interrupts off.
+class Simulation {
+  public:
+    explicit Simulation(const uint32_t start_ms = 0, const uint16_t timerLate_ms = 0) :
+      tracker(), now_ms(start_ms), pinDown(false), timerRunning(false), timer_ms(0), late_ms(timerLate_ms)
+    {}
+
+    // Runs until end_ms, relative to the start. If take is set, loop() takes
+    // events as they come, otherwise they're left in the queue.
+    int run(const Edge* const edges, const int edgeCount, const uint32_t end_ms, Event* const events, const bool take = true) {
+      const uint32_t start_ms = now_ms;
+      int next = 0;
+      int count = 0;
+      for (uint32_t t = 0; t <= end_ms; ++t) {
+        now_ms = start_ms + t;
+        while (next < edgeCount && edges[next].time_ms == t) {
+          if (edges[next].down != pinDown) {
+            pinDown = edges[next].down;
+            startTimer(tracker.edge(now_ms));
+          }
+          ++next;
+        }
+        if (timerRunning && static_cast<int32_t>(now_ms - timer_ms) >= 0) {
+          timerRunning = false;
+          startTimer(tracker.update(pinDown, now_ms));
+        }
+        ButtonEvent event;
+        while (take && tracker.take(&event)) {
+          events[count].time_ms = t;
+          events[count].event = event;
+          ++count;
+        }
+      }
+      return count;
+    }
+
+    ButtonTracker tracker;
+
+  private:
+    uint32_t now_ms;
+    bool pinDown;
+    bool timerRunning;
+    uint32_t timer_ms;
+    uint16_t late_ms;
+
+    void startTimer(const uint16_t delay_ms) {
+      timerRunning = delay_ms != 0;
+      timer_ms = now_ms + delay_ms + late_ms;
+    }
+};
+
+static int failures = 0;
+
+static const char* name(const ButtonEvent event) {
+  switch (event) {
+    case ButtonEvent::PRESS:
+      return "press";
+    case ButtonEvent::LONG_PRESS:
+      return "long press";
+    default:
+      return "double press";
+  }
+}
+
+// Checks that events are what's expected, and that each came out within
+// slack_ms after the expected time
+static void expect(
+  const char* const test,
+  const Event* const events,
+  const int count,
+  const Event* const expected,
+  const int expectedCount,
+  const uint32_t slack_ms = 1
+) {
+  bool ok = count == expectedCount;
+  for (int i = 0; ok && i < count; ++i) {
+    ok = events[i].event == expected[i].event
+      && events[i].time_ms >= expected[i].time_ms
+      && events[i].time_ms <= expected[i].time_ms + slack_ms;
+  }
+  printf("%s: %s\n", ok ? "ok  " : "FAIL", test);
+  if (!ok) {
+    ++failures;
+    for (int i = 0; i < count; ++i) {
+      printf("    got %s at %u ms\n", name(events[i].event), events[i].time_ms);
+    }
+    for (int i = 0; i < expectedCount; ++i) {
+      printf("    expected %s at %u ms\n", name(expected[i].event), expected[i].time_ms);
+    }
+  }
+}
+
+
+static void shortPress() {
+  const Edge edges[] = {{100, true}, {200, false}};
+  Event events[8];
+  Simulation simulation;
+  const int count = simulation.run(edges, 2, 1000, events);
+  // Single presses wait to see if a second one is coming
+  const Event expected[] = {{200 + GAP_MS, ButtonEvent::PRESS}};
+  expect("Short press is reported once the double press gap runs out", events, count, expected, 1);
+}
+
+
+static void bouncyPress() {
+  // Both contacts chatter for a few ms each way
+  const Edge edges[] = {
+    {100, true}, {101, false}, {103, true}, {104, false}, {107, true},
+    {250, false}, {252, true}, {253, false}, {256, true}, {258, false},
+  };
+  Event events[8];
+  Simulation simulation;
+  const int count = simulation.run(edges, 10, 1000, events);
+  // Times come from the last edge before the level settled
+  const Event expected[] = {{258 + GAP_MS, ButtonEvent::PRESS}};
+  expect("Bouncing contacts make one press", events, count, expected, 1);
+}
+
+
+static void glitch() {
+  const Edge edges[] = {{100, true}, {105, false}, {300, true}, {300 + DEBOUNCE_MS - 2, false}};
+  Event events[8];
+  Simulation simulation;
+  const int count = simulation.run(edges, 4, 1000, events);
+  expect("Blips shorter than the debounce time are ignored", events, count, nullptr, 0);
+}
+
+
+static void longPress() {
+  const Edge edges[] = {{100, true}, {101, false}, {102, true}, {1200, false}};
+  Event events[8];
+  Simulation simulation;
+  const int count = simulation.run(edges, 4, 2000, events);
+  // Reported while it's still held, and letting go doesn't add anything
+  const Event expected[] = {{102 + LONG_PRESS_MS, ButtonEvent::LONG_PRESS}};
+  expect("Long press is reported while it's held", events, count, expected, 1);
+}
+
+
+static void doublePress() {
+  const Edge edges[] = {
+    {100, true}, {102, false}, {103, true},
+    {200, false}, {201, true}, {202, false},
+    {200 + GAP_MS - 30, true}, {200 + GAP_MS + 60, false}, {200 + GAP_MS + 61, true}, {200 + GAP_MS + 62, false},
+  };
+  Event events[8];
+  Simulation simulation;
+  const int count = simulation.run(edges, 10, 1500, events);
+  const Event expected[] = {{200 + GAP_MS + 62 + DEBOUNCE_MS, ButtonEvent::DOUBLE_PRESS}};
+  expect("Second press inside the gap makes a double press", events, count, expected, 1);
+}
+
+
+static void twoPresses() {
+  const Edge edges[] = {{100, true}, {200, false}, {200 + GAP_MS + 10, true}, {200 + GAP_MS + 100, false}};
+  Event events[8];
+  Simulation simulation;
+  const int count = simulation.run(edges, 4, 1500, events);
+  const Event expected[] = {
+    {200 + GAP_MS, ButtonEvent::PRESS},
+    {200 + GAP_MS + 100 + GAP_MS, ButtonEvent::PRESS},
+  };
+  expect("Second press after the gap makes two presses", events, count, expected, 2);
+}
+
+
+static void lateTimer() {
+  // The timer that would end the gap runs 40 ms late, so the second press
+  // starts before it fires. The first press still counts as a single.
+  const Edge edges[] = {{100, true}, {200, false}, {200 + GAP_MS + 10, true}, {200 + GAP_MS + 100, false}};
+  Event events[8];
+  Simulation simulation(0, 40);
+  const int count = simulation.run(edges, 4, 1500, events);
+  const Event expected[] = {
+    {200 + GAP_MS + 10 + DEBOUNCE_MS, ButtonEvent::PRESS},
+    {200 + GAP_MS + 100 + GAP_MS, ButtonEvent::PRESS},
+  };
+  expect("A late timer doesn't turn presses into a double press", events, count, expected, 2, 40);
+}
+
+
+static void isDown() {
+  const Edge edges[] = {{100, true}, {101, false}, {102, true}};
+  Event events[8];
+  Simulation simulation;
+  bool ok = true;
+  simulation.run(edges, 3, 110, events);
+  ok = ok && !simulation.tracker.isDown();
+  simulation.run(nullptr, 0, 20, events);
+  ok = ok && simulation.tracker.isDown();
+  printf("%s: %s\n", ok ? "ok  " : "FAIL", "isDown() waits for the bouncing to stop");
+  failures += !ok;
+}
+
+
+static void earlyTimer() {
+  // In case the timer fires from an old schedule before the edge restarts
+  // it, update() has to notice the bouncing by itself
+  ButtonTracker tracker;
+  bool ok = tracker.edge(100) == DEBOUNCE_MS;
+  ok = ok && tracker.update(true, 105) == DEBOUNCE_MS - 5;
+  ok = ok && !tracker.isDown();
+  ok = ok && tracker.update(true, 100 + DEBOUNCE_MS) == LONG_PRESS_MS - DEBOUNCE_MS;
+  ok = ok && tracker.isDown();
+  printf("%s: %s\n", ok ? "ok  " : "FAIL", "A timer that fires while bouncing waits for it to stop");
+  failures += !ok;
+}
+
+
+static void fullQueue() {
+  // 10 presses and nobody taking them. The queue holds 7.
+  Edge edges[20];
+  for (int i = 0; i < 10; ++i) {
+    edges[2 * i].time_ms = 100 + i * 500;
+    edges[2 * i].down = true;
+    edges[2 * i + 1].time_ms = 150 + i * 500;
+    edges[2 * i + 1].down = false;
+  }
+  Event events[8];
+  Simulation simulation;
+  simulation.run(edges, 20, 6000, events, false);
+  int count = 0;
+  ButtonEvent event;
+  while (simulation.tracker.take(&event)) {
+    ++count;
+  }
+  const bool ok = count == 7 && simulation.tracker.dropCount() == 3;
+  printf("%s: %s\n", ok ? "ok  " : "FAIL", "A full queue drops presses and counts them");
+  if (!ok) {
+    printf("    %d queued, %u dropped\n", count, simulation.tracker.dropCount());
+  }
+  failures += !ok;
+}
+
+
+static void wrap() {
+  const Edge edges[] = {{100, true}, {103, false}, {105, true}, {900, false}};
+  Event events[8];
+  // millis() wraps in the middle of the press
+  Simulation simulation(0xFFFFFFFF - 300);
+  const int count = simulation.run(edges, 4, 2000, events);
+  const Event expected[] = {{105 + LONG_PRESS_MS, ButtonEvent::LONG_PRESS}};
+  expect("Presses work when millis() wraps", events, count, expected, 1);
+}
+
+
+int main() {
+  shortPress();
+  bouncyPress();
+  glitch();
+  longPress();
+  doublePress();
+  twoPresses();
+  lateTimer();
+  isDown();
+  earlyTimer();
+  fullQueue();
+  wrap();
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+// Compares FixedFft against a double-precision DFT of the same windowed
+// blocks, and times it. The blocks are noisy sines from 40 Hz to 2.4 kHz at
+// all sorts of volumes, rounded to 10 bits like the ADC's readings. Exits
+// with 1 if the fixed-point magnitudes are too far off.
+//
+//     ./fft
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "../fixedFft.hpp"
+
+static const int SAMPLE_COUNT = 128;
+static const int SAMPLING_FREQUENCY_HZ = 5000;
+static const int BLOCK_COUNT = 2000;
+static const int BENCHMARK_COUNT = 200000;
+// FixedFft's output is the FFT times this
+static const double OUTPUT_SCALE = 16.0 / SAMPLE_COUNT;
+// Mean error over every bin, as a fraction of the mean magnitude. The
+// magnitude approximation alone is off by up to 4% in each bin, and quiet
+// blocks lose a few more bits to rounding.
+static const double ERROR_LIMIT = 0.05;
+
+static uint32_t randomState = 1;
+
+// 0 to 1
+static double randomDouble() {
+  randomState = randomState * 1103515245 + 12345;
+  return static_cast<double>((randomState >> 8) & 0xFFFF) / 0xFFFF;
+}
+
+// What the ADC would read for a sine at hz with some noise, centered on 512
+static void makeBlock(const double hz, const double amplitude, const double noise, int16_t* const samples) {
+  const double phase = randomDouble() * 2 * M_PI;
+  for (int i = 0; i < SAMPLE_COUNT; ++i) {
+    const double value = 512 + amplitude * sin(2 * M_PI * hz * i / SAMPLING_FREQUENCY_HZ + phase)
+      + noise * (randomDouble() - 0.5);
+    const long rounded = lround(value);
+    samples[i] = rounded < 0 ? 0 : rounded > 1023 ? 1023 : rounded;
+  }
+}
+
+// The same steps as FixedFft, in doubles. The magnitudes are exact, or use
+// FixedFft's approximation if approximate is set.
+static void referenceMagnitudes(const int16_t* const samples, double* const output, const bool approximate = false) {
+  double mean = 0;
+  for (int i = 0; i < SAMPLE_COUNT; ++i) {
+    mean += samples[i];
+  }
+  mean /= SAMPLE_COUNT;
+  double windowed[SAMPLE_COUNT];
+  for (int i = 0; i < SAMPLE_COUNT; ++i) {
+    windowed[i] = (samples[i] - mean) * (0.54 - 0.46 * cos(2 * M_PI * i / (SAMPLE_COUNT - 1)));
+  }
+  for (int k = 0; k < SAMPLE_COUNT / 2; ++k) {
+    double real = 0, imaginary = 0;
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+      real += windowed[i] * cos(2 * M_PI * k * i / SAMPLE_COUNT);
+      imaginary -= windowed[i] * sin(2 * M_PI * k * i / SAMPLE_COUNT);
+    }
+    const double larger = fmax(fabs(real), fabs(imaginary));
+    const double smaller = fmin(fabs(real), fabs(imaginary));
+    const double magnitude = approximate ? (larger * 123 + smaller * 51) / 128 : sqrt(real * real + imaginary * imaginary);
+    output[k] = magnitude * OUTPUT_SCALE;
+  }
+}
+
+
+int main() {
+  FixedFft<SAMPLE_COUNT> fft;
+  int16_t samples[SAMPLE_COUNT];
+  uint16_t magnitudes[SAMPLE_COUNT / 2];
+  double reference[SAMPLE_COUNT / 2];
+  double approximated[SAMPLE_COUNT / 2];
+
+  double totalError = 0, totalApproximationError = 0, totalMagnitude = 0, worstBlock = 0;
+  for (int block = 0; block < BLOCK_COUNT; ++block) {
+    const double hz = 40 + randomDouble() * (2400 - 40);
+    // From barely there to clipping a little
+    const double amplitude = 2 + randomDouble() * randomDouble() * 520;
+    makeBlock(hz, amplitude, 4 + amplitude * 0.1, samples);
+    fft.magnitudes(samples, magnitudes);
+    referenceMagnitudes(samples, reference);
+    referenceMagnitudes(samples, approximated, true);
+    double blockError = 0, blockMagnitude = 0;
+    for (int k = 0; k < SAMPLE_COUNT / 2; ++k) {
+      blockError += fabs(magnitudes[k] - reference[k]);
+      totalApproximationError += fabs(approximated[k] - reference[k]);
+      blockMagnitude += reference[k];
+    }
+    totalError += blockError;
+    totalMagnitude += blockMagnitude;
+    worstBlock = fmax(worstBlock, blockError / blockMagnitude);
+  }
+  const double error = totalError / totalMagnitude;
+  printf(
+    "Mean error %.1f%% of the mean magnitude over %d blocks, worst block %.1f%%\n",
+    error * 100,
+    BLOCK_COUNT,
+    worstBlock * 100);
+  printf(
+    "The magnitude approximation alone is off by %.1f%%\n",
+    totalApproximationError / totalMagnitude * 100);
+
+  // A full scale sine in the middle of a bin
+  const double binHz = static_cast<double>(SAMPLING_FREQUENCY_HZ) / SAMPLE_COUNT;
+  makeBlock(binHz * 10, 511, 0, samples);
+  fft.magnitudes(samples, magnitudes);
+  referenceMagnitudes(samples, reference);
+  printf("Full scale sine peaks at %u, %.0f expected\n", magnitudes[10], reference[10]);
+  const double peakError = fabs(magnitudes[10] - reference[10]) / reference[10];
+
+  // Vary the blocks so the compiler can't hoist anything out of the loop
+  int16_t blocks[16][SAMPLE_COUNT];
+  for (int i = 0; i < 16; ++i) {
+    makeBlock(100 + i * 130, 300, 40, blocks[i]);
+  }
+  uint32_t checksum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCHMARK_COUNT; ++i) {
+    fft.magnitudes(blocks[i & 15], magnitudes);
+    checksum += magnitudes[i & 63];
+  }
+  const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  printf(
+    "%.2f us per %d-point transform (checksum %u), %zu bytes\n",
+    elapsed.count() / BENCHMARK_COUNT,
+    SAMPLE_COUNT,
+    checksum,
+    sizeof(fft));
+
+  bool ok = true;
+  if (error > ERROR_LIMIT) {
+    printf("Mean error should be under %.0f%%\n", ERROR_LIMIT * 100);
+    ok = false;
+  }
+  if (peakError > ERROR_LIMIT) {
+    printf("Full scale sine should be within %.0f%%\n", ERROR_LIMIT * 100);
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
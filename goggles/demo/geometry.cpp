@@ -0,0 +1,86 @@
+// Checks geometry.hpp's lookup tables against the % arithmetic that
+// animations.cpp used before there was a geometry.hpp: every angle on both
+// lenses, and copyLens and mirrorLens at every rotation. Exits with 1 if any
+// pixel lands somewhere else.
+//
+//     ./geometry
+
+#include <cstdint>
+#include <cstdio>
+
+#include "../geometry.hpp"
+
+static const int PIXEL_COUNT = 2 * PIXEL_RING_COUNT;
+
+// From the old animations.cpp. The right lens is mounted 2 pixels around
+// from the left one.
+static void oldCopyLens(CRGB* const pixels, const uint8_t rotate) {
+  const int OFFSET = 2;
+  for (int i = 0; i < PIXEL_RING_COUNT; ++i) {
+    pixels[((i + rotate + PIXEL_RING_COUNT - OFFSET) % PIXEL_RING_COUNT + PIXEL_RING_COUNT)] = pixels[i];
+  }
+}
+
+static void oldMirrorLens(CRGB* const pixels, const uint8_t rotate) {
+  const int OFFSET = 2;
+  for (int i = 0; i < PIXEL_RING_COUNT; ++i) {
+    pixels[((PIXEL_RING_COUNT * 2 - i + rotate - OFFSET) % PIXEL_RING_COUNT + PIXEL_RING_COUNT)] = pixels[i];
+  }
+}
+
+// Every pixel a different color, so a pixel in the wrong place shows up
+static void fillDistinct(CRGB* const pixels) {
+  for (int i = 0; i < PIXEL_COUNT; ++i) {
+    pixels[i] = CRGB(i, 255 - i, i * 3);
+  }
+}
+
+static int failures = 0;
+
+static void check(const bool ok, const char* const what, const int lens, const int angle) {
+  if (!ok) {
+    printf("%s is wrong for lens %d at %d\n", what, lens, angle);
+    ++failures;
+  }
+}
+
+
+int main() {
+  int checks = 0;
+  for (int angle = 0; angle < 2 * PIXEL_RING_COUNT; ++angle) {
+    // The left lens's angles are its pixels, and the old copyLens put the
+    // left lens's pixel i at this pixel on the right lens
+    const int left = angle % PIXEL_RING_COUNT;
+    const int right = (angle + PIXEL_RING_COUNT - 2) % PIXEL_RING_COUNT + PIXEL_RING_COUNT;
+    check(lensPixel(0, angle) == left, "lensPixel", 0, angle);
+    check(lensPixel(1, angle) == right, "lensPixel", 1, angle);
+    check(pixelAt(0, angle) == left, "pixelAt", 0, angle);
+    check(pixelAt(1, angle) == right, "pixelAt", 1, angle);
+    checks += 4;
+  }
+
+  for (int rotate = 0; rotate < PIXEL_RING_COUNT; ++rotate) {
+    CRGB before[PIXEL_COUNT];
+    CRGB after[PIXEL_COUNT];
+
+    fillDistinct(before);
+    fillDistinct(after);
+    oldCopyLens(before, rotate);
+    copyLens(after, rotate);
+    for (int i = 0; i < PIXEL_COUNT; ++i) {
+      check(before[i] == after[i], "copyLens", i / PIXEL_RING_COUNT, rotate);
+    }
+
+    fillDistinct(before);
+    fillDistinct(after);
+    oldMirrorLens(before, rotate);
+    mirrorLens(after, rotate);
+    for (int i = 0; i < PIXEL_COUNT; ++i) {
+      check(before[i] == after[i], "mirrorLens", i / PIXEL_RING_COUNT, rotate);
+    }
+    checks += 2 * PIXEL_COUNT;
+  }
+
+  printf("%d of %d pixel mappings match the old code\n", checks - failures, checks);
+  return failures == 0 ? 0 : 1;
+}
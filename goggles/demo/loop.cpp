@@ -0,0 +1,295 @@
+// Simulates pressing the goggles' button while loop() is drawing, to check
+// that no press gets lost. The button interrupts drive ButtonTracker the way
+// button.cpp does, and loop() runs the deadline scheduler from goggles.ino,
+// taking one event per pass. For comparison, it also runs the old kind of
+// loop, which delay()ed inside each frame and only ran the button's state
+// machine in between. The pretend millis() starts just before it wraps.
+// Exits with 1 if the interrupt driven button misses or mixes up a press.
+//
+//     ./loop
+
+#include <cstdint>
+#include <cstdio>
+
+#include "../button.hpp"
+
+// The simulation steps this often, and interrupts are handled on each step
+static const uint32_t STEP_US = 100;
+// Presses from 30 ms to 705 ms, at a bunch of phases relative to the frames.
+// None are right on LONG_PRESS_MS, where either answer would be fine.
+static const uint32_t SHORTEST_PRESS_MS = 30;
+static const uint32_t LONGEST_PRESS_MS = 705;
+static const uint32_t PRESS_STEP_MS = 25;
+static const uint32_t PHASE_COUNT = 23;
+// Long enough between presses that they can't turn into a double press
+static const uint32_t BETWEEN_PRESSES_MS = 800;
+// Starts a few seconds before millis() wraps
+static const uint32_t START_MS = 0xFFFFFFFF - 5000;
+
+static uint32_t randomState = 1;
+
+static uint32_t random32() {
+  randomState = randomState * 1103515245 + 12345;
+  return randomState >> 8;
+}
+
+// Same as goggles.ino
+static bool isDue(const uint32_t now_ms, const uint32_t deadline_ms) {
+  return static_cast<int32_t>(now_ms - deadline_ms) >= 0;
+}
+
+struct Press {
+  uint64_t start_us;
+  uint64_t end_us;
+};
+
+// Fills presses and returns how many there are
+static int makePresses(Press* const presses, const int maximum) {
+  int count = 0;
+  uint64_t start_us = 100000;
+  for (uint32_t phase = 0; phase < PHASE_COUNT; ++phase) {
+    for (uint32_t length_ms = SHORTEST_PRESS_MS; length_ms <= LONGEST_PRESS_MS; length_ms += PRESS_STEP_MS) {
+      if (count == maximum) {
+        return count;
+      }
+      // Odd phases so presses land everywhere in the frames
+      start_us += phase * 7300 + 13;
+      presses[count].start_us = start_us;
+      presses[count].end_us = start_us + length_ms * 1000;
+      start_us = presses[count].end_us + BETWEEN_PRESSES_MS * 1000;
+      ++count;
+    }
+  }
+  return count;
+}
+
+static bool isPinDown(const Press* const presses, const int count, const uint64_t now_us) {
+  for (int i = 0; i < count; ++i) {
+    if (now_us >= presses[i].start_us && now_us < presses[i].end_us) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint32_t millis(const uint64_t now_us) {
+  return START_MS + static_cast<uint32_t>(now_us / 1000);
+}
+
+// How long an animation frame takes to draw and show, and the delay it
+// returns. Some return 0 because they're waiting for audio.
+static void makeFrame(uint32_t* const cost_us, uint16_t* const delay_ms) {
+  *cost_us = 300 + random32() % 2700;
+  *delay_ms = random32() % 4 == 0 ? 0 : 10 + random32() % 91;
+}
+
+struct Result {
+  int presses;
+  int longPresses;
+  int doublePresses;
+  uint32_t worstLatency_ms;  // From letting go to loop() getting the press
+  uint32_t longestFrameGap_ms;
+  int earlyFrames;  // Drawn before the animation asked to be
+};
+
+
+// The current goggles: the pin change interrupt and the timer drive the
+// tracker, and loop() takes an event each pass and draws when a frame is due
+static Result interruptLoop(const Press* const presses, const int count, const uint64_t end_us) {
+  ButtonTracker tracker;
+  bool timerRunning = false;
+  uint64_t timer_us = 0;
+  bool pinDown = false;
+
+  uint64_t nextPass_us = 0;
+  uint32_t frame_ms = millis(0);
+  uint64_t lastFrame_us = 0;
+  uint64_t frame_us = 0;
+  int pressIndex = 0;
+  Result result = {};
+
+  randomState = 1;
+  for (uint64_t now_us = 0; now_us < end_us; now_us += STEP_US) {
+    const uint32_t now_ms = millis(now_us);
+    // Interrupts happen whatever loop() is doing
+    const bool down = isPinDown(presses, count, now_us);
+    if (down != pinDown) {
+      pinDown = down;
+      timer_us = now_us + tracker.edge(now_ms) * 1000ULL;
+      timerRunning = true;
+    }
+    if (timerRunning && now_us >= timer_us) {
+      const uint16_t delay_ms = tracker.update(pinDown, now_ms);
+      timerRunning = delay_ms != 0;
+      timer_us = now_us + delay_ms * 1000ULL;
+    }
+
+    if (now_us < nextPass_us) {
+      continue;
+    }
+    ButtonEvent event;
+    if (tracker.take(&event)) {
+      if (event == ButtonEvent::PRESS) {
+        while (pressIndex < count - 1 && presses[pressIndex + 1].end_us < now_us) {
+          ++pressIndex;
+        }
+        const uint32_t latency_ms = (now_us - presses[pressIndex].end_us) / 1000;
+        result.worstLatency_ms = latency_ms > result.worstLatency_ms ? latency_ms : result.worstLatency_ms;
+      }
+      result.presses += event == ButtonEvent::PRESS;
+      result.longPresses += event == ButtonEvent::LONG_PRESS;
+      result.doublePresses += event == ButtonEvent::DOUBLE_PRESS;
+    }
+    uint32_t cost_us = 20;
+    if (isDue(now_ms, frame_ms)) {
+      uint16_t delay_ms;
+      // millis() only counts whole ms, so drawing in the deadline's ms is fine
+      result.earlyFrames += millis(now_us) != millis(frame_us) && now_us < frame_us;
+      makeFrame(&cost_us, &delay_ms);
+      frame_ms = now_ms + delay_ms;
+      frame_us = now_us + delay_ms * 1000ULL;
+      const uint32_t gap_ms = (now_us - lastFrame_us) / 1000;
+      result.longestFrameGap_ms = gap_ms > result.longestFrameGap_ms ? gap_ms : result.longestFrameGap_ms;
+      lastFrame_us = now_us;
+    }
+    nextPass_us = now_us + cost_us;
+  }
+  return result;
+}
+
+
+// The button state machine from before ButtonTracker, copied from the old
+// goggles.ino. The pin change interrupt only recorded the level, and loop()
+// ran this between frames.
+struct OldButton {
+  enum class ButtonState_t {
+    UP,
+    DEBOUNCE_DOWN,
+    DOWN,
+    LONG_BUTTON_PRESS,
+    BUTTON_PRESS,
+    AFTER_BUTTON_PRESS,
+  };
+  uint32_t buttonDownTime = 0;
+  ButtonState_t buttonState = ButtonState_t::UP;
+  bool buttonDown = false;
+
+  void updateButtonState(const uint32_t now) {
+    switch (buttonState) {
+      case ButtonState_t::UP:
+        if (buttonDown) {
+          buttonState = ButtonState_t::DEBOUNCE_DOWN;
+          buttonDownTime = now;
+        }
+        break;
+      case ButtonState_t::DEBOUNCE_DOWN:
+        if (buttonDown && now - buttonDownTime > 20) {
+          buttonState = ButtonState_t::DOWN;
+        } else if (!buttonDown) {
+          buttonState = ButtonState_t::UP;
+        }
+        break;
+      case ButtonState_t::DOWN:
+        if (now - buttonDownTime > 500) {
+          buttonState = ButtonState_t::LONG_BUTTON_PRESS;
+        } else if (!buttonDown) {
+          buttonState = ButtonState_t::BUTTON_PRESS;
+        }
+        break;
+      case ButtonState_t::LONG_BUTTON_PRESS:
+        buttonState = ButtonState_t::AFTER_BUTTON_PRESS;
+        break;
+      case ButtonState_t::BUTTON_PRESS:
+        buttonState = ButtonState_t::AFTER_BUTTON_PRESS;
+        break;
+      case ButtonState_t::AFTER_BUTTON_PRESS:
+        if (!buttonDown) {
+          buttonState = ButtonState_t::UP;
+        }
+        break;
+    }
+  }
+};
+
+
+// The goggles before animations returned their delays: each frame delay()ed
+// until the next one, and the button was only looked at in between
+static Result pollingLoop(const Press* const presses, const int count, const uint64_t end_us) {
+  OldButton button;
+  uint64_t nextPass_us = 0;
+  Result result = {};
+
+  randomState = 1;
+  for (uint64_t now_us = 0; now_us < end_us; now_us += STEP_US) {
+    // The interrupt kept this up to date
+    button.buttonDown = isPinDown(presses, count, now_us);
+    if (now_us < nextPass_us) {
+      continue;
+    }
+    button.updateButtonState(millis(now_us));
+    result.presses += button.buttonState == OldButton::ButtonState_t::BUTTON_PRESS;
+    result.longPresses += button.buttonState == OldButton::ButtonState_t::LONG_BUTTON_PRESS;
+    uint32_t cost_us;
+    uint16_t delay_ms;
+    makeFrame(&cost_us, &delay_ms);
+    // The old animations always waited, 50-100 ms for most of them
+    nextPass_us = now_us + cost_us + (delay_ms == 0 ? 50 : delay_ms) * 1000ULL;
+  }
+  return result;
+}
+
+
+int main() {
+  static Press presses[1000];
+  const int count = makePresses(presses, 1000);
+  int expectedPresses = 0, expectedLongPresses = 0;
+  for (int i = 0; i < count; ++i) {
+    const uint64_t length_us = presses[i].end_us - presses[i].start_us;
+    if (length_us >= ButtonTracker::LONG_PRESS_MS * 1000ULL) {
+      ++expectedLongPresses;
+    } else {
+      ++expectedPresses;
+    }
+  }
+  const uint64_t end_us = presses[count - 1].end_us + 2000000;
+
+  const Result polled = pollingLoop(presses, count, end_us);
+  printf(
+    "Polling between frames: %d of %d presses and %d of %d long presses\n",
+    polled.presses,
+    expectedPresses,
+    polled.longPresses,
+    expectedLongPresses);
+
+  const Result interrupts = interruptLoop(presses, count, end_us);
+  printf(
+    "Interrupts: %d of %d presses and %d of %d long presses, %d bogus double presses, at most %u ms after letting go\n",
+    interrupts.presses,
+    expectedPresses,
+    interrupts.longPresses,
+    expectedLongPresses,
+    interrupts.doublePresses,
+    interrupts.worstLatency_ms);
+  printf(
+    "Longest time between frames: %u ms, %d frames drawn early\n",
+    interrupts.longestFrameGap_ms,
+    interrupts.earlyFrames);
+
+  // A press is reported once the double press gap runs out, and loop() might
+  // be in the middle of a frame
+  const uint32_t latencyLimit_ms = ButtonTracker::DEBOUNCE_MS + ButtonTracker::DOUBLE_PRESS_GAP_MS + 5;
+  const bool ok = interrupts.presses == expectedPresses && interrupts.longPresses == expectedLongPresses
+    && interrupts.doublePresses == 0 && interrupts.worstLatency_ms <= latencyLimit_ms;
+  if (!ok) {
+    printf("Every press should get to loop() within %u ms\n", latencyLimit_ms);
+  }
+  // The longest delay an animation returns, plus the longest frame. If the
+  // deadlines broke when millis() wrapped, the frames would stop or run
+  // early.
+  const uint32_t frameGapLimit_ms = 100 + 3 + 1;
+  const bool onTime = interrupts.longestFrameGap_ms <= frameGapLimit_ms && interrupts.earlyFrames == 0;
+  if (!onTime) {
+    printf("Frames should be on time and at most %u ms apart\n", frameGapLimit_ms);
+  }
+  return ok && onTime ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// Runs each goggles animation for an hour on a pretend clock through
+// PowerGovernor, and reports how many mAh it would take out of the battery
+// with and without the governor. The budget is the one in goggles.ino.
+// Exits with 1 if an animation goes over budget while the governor still
+// had room to turn it down, or if the governor's own average is far off.
+//
+//     ./power                 # At the goggles' starting brightness
+//     ./power 100             # At some other brightness
+//
+// The audio animations need the microphone, so they aren't here.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../constants.hpp"
+#include "../powerGovernor.hpp"
+
+// Same as goggles.ino
+static const uint16_t BATTERY_CAPACITY_MAH = 500;
+static const uint16_t BATTERY_LIFE_HOURS = 6;
+static const uint16_t BUDGET_MA = BATTERY_CAPACITY_MAH / BATTERY_LIFE_HOURS;
+static const uint8_t INITIAL_BRIGHTNESS = 20;
+static const CRGB COLOR_CORRECTION = CRGB(0, 255, 255);
+
+static const int PIXEL_COUNT = PIXEL_RING_COUNT * 2;
+static const uint32_t RUN_MS = 60ul * 60 * 1000;
+// The governor never turns the brightness down further than 1/8
+static const uint8_t MINIMUM_SCALING = 256 / 8;
+
+// The animations read these
+bool reset;
+static uint32_t now_ms = 0;
+
+unsigned long millis() {
+  return now_ms;
+}
+
+long random(const long maximum) {
+  return rand() % maximum;
+}
+
+#define ANIM(name) uint16_t name(uint8_t hue, CRGB* pixels)
+ANIM(binaryClock);
+ANIM(circularWipe);
+ANIM(fadingSparks);
+ANIM(lookAround);
+ANIM(newtonsCradle);
+ANIM(pacMan);
+ANIM(rainbowSwirls);
+ANIM(randomSparks);
+ANIM(ripples);
+ANIM(shimmer);
+ANIM(spinnyWheels);
+ANIM(swirls);
+
+struct Animation {
+  const char* name;
+  uint16_t (*draw)(uint8_t hue, CRGB* pixels);
+};
+
+const Animation ANIMATIONS[] = {
+  {"binaryClock", binaryClock},
+  {"circularWipe", circularWipe},
+  {"fadingSparks", fadingSparks},
+  {"lookAround", lookAround},
+  {"newtonsCradle", newtonsCradle},
+  {"pacMan", pacMan},
+  {"rainbowSwirls", rainbowSwirls},
+  {"randomSparks", randomSparks},
+  {"ripples", ripples},
+  {"shimmer", shimmer},
+  {"spinnyWheels", spinnyWheels},
+  {"swirls", swirls},
+};
+
+// What the pixels draw at this brightness, in mA. This is worked out
+// separately from PowerGovernor's estimate, from the same numbers: 20 mA per
+// color at full brightness, 1 mA per pixel, and 10 mA for the Trinket.
+static double current_mA(const CRGB* const pixels, const uint8_t brightness) {
+  double total = 10 + PIXEL_COUNT;
+  for (int i = 0; i < PIXEL_COUNT; ++i) {
+    const double channels = pixels[i].r * (COLOR_CORRECTION.r / 255.0)
+      + pixels[i].g * (COLOR_CORRECTION.g / 255.0)
+      + pixels[i].b * (COLOR_CORRECTION.b / 255.0);
+    total += channels / 255.0 * brightness / 255.0 * 20;
+  }
+  return total;
+}
+
+
+int main(const int argc, const char* const argv[]) {
+  const uint8_t brightness = argc > 1 ? atoi(argv[1]) : INITIAL_BRIGHTNESS;
+  printf("Budget %u mA at brightness %u\n", BUDGET_MA, brightness);
+  printf("%-14s %12s %12s %12s %8s %10s\n", "", "ungoverned", "governed", "reported", "scaling", "runtime");
+
+  bool ok = true;
+  for (const Animation& animation : ANIMATIONS) {
+    srand(1);
+    CRGB pixels[PIXEL_COUNT] = {};
+    PowerGovernor<PIXEL_COUNT> governor(BUDGET_MA, COLOR_CORRECTION);
+    double ungoverned_mAms = 0, governed_mAms = 0;
+    double ungoverned_mA = 0, governed_mA = 0;
+    uint32_t lastFrame_ms = 0;
+
+    reset = true;
+    now_ms = 0;
+    while (now_ms < RUN_MS) {
+      const uint8_t hue = (now_ms % 20000) * 0xFFFF / 20000 >> 8;
+      const uint16_t delay_ms = animation.draw(hue, pixels);
+      reset = false;
+      // The previous frame was showing until now
+      ungoverned_mAms += ungoverned_mA * (now_ms - lastFrame_ms);
+      governed_mAms += governed_mA * (now_ms - lastFrame_ms);
+      lastFrame_ms = now_ms;
+
+      const uint8_t governed = governor.update(pixels, brightness, now_ms);
+      ungoverned_mA = current_mA(pixels, brightness);
+      governed_mA = current_mA(pixels, governed);
+      now_ms += delay_ms == 0 ? 1 : delay_ms;
+    }
+    ungoverned_mAms += ungoverned_mA * (RUN_MS - lastFrame_ms);
+    governed_mAms += governed_mA * (RUN_MS - lastFrame_ms);
+
+    // mAh in an hour is just the average mA
+    const double ungoverned_mAh = ungoverned_mAms / RUN_MS;
+    const double governed_mAh = governed_mAms / RUN_MS;
+    printf(
+      "%-14s %8.0f mAh %8.0f mAh %9u mA %8u %6.1f h\n",
+      animation.name,
+      ungoverned_mAh,
+      governed_mAh,
+      governor.averageCurrent_mA(),
+      governor.scaling(),
+      BATTERY_CAPACITY_MAH / governed_mAh);
+
+    // Brief bursts are allowed, and the governor takes a few seconds to catch
+    // up, so leave a little room
+    if (governed_mAh > BUDGET_MA * 1.05 && governor.scaling() > MINIMUM_SCALING) {
+      printf("  Over budget, but the governor didn't turn it all the way down\n");
+      ok = false;
+    }
+    if (fabs(governor.averageCurrent_mA() - governed_mAh) > governed_mAh * 0.1 + 1) {
+      printf("  The governor's average is off\n");
+      ok = false;
+    }
+  }
+  return ok ? 0 : 1;
+}
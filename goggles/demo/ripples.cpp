@@ -0,0 +1,197 @@
+// Compares Ripples with the per-pixel state machine that it replaced, for a
+// single drop on one lens, and then times a frame of each. Prints a few
+// frames side by side. Exits with 1 if any pixel's peak brightness is off by
+// more than 1, or if the new ripple looks too different overall.
+//
+//     ./ripples
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../ripples.hpp"
+
+static const int PIXEL_RING_COUNT = 20;
+static const int DROPS_PER_LENS = 3;
+static const int FRAME_COUNT = 150;
+static const int BENCHMARK_FRAMES = 200000;
+// Far pixels keep the whole bounce now instead of a shortened one, so they
+// don't match frame for frame
+static const double MEAN_DIFFERENCE_LIMIT = 10.0;
+
+// The old ripples.cpp, minus the drawing, random() and delay(). A new drop
+// could only start once the whole lens had gone dark.
+struct OldRipples {
+  uint8_t brightnesses[2][PIXEL_RING_COUNT] = {};
+  int8_t directions[2][PIXEL_RING_COUNT] = {};
+  uint8_t delays[2][PIXEL_RING_COUNT] = {};
+  uint8_t maxBrightnesses[2][PIXEL_RING_COUNT] = {};
+  static const int DROP_OFF = 5;
+  static const int MAX_DROP_OFF = 15;
+  static const int INCREMENT = 20;
+  static const int MAX_BRIGHTNESS = 100;
+  static const int INITIAL_DELAY = 3;
+  static const int RIPPLE_DELAY = 3;
+
+  void ripple(const int lens, const int i) {
+    if (delays[lens][i] == 0) {
+      // Increase toward the max
+      if (directions[lens][i] > 0) {
+        if (brightnesses[lens][i] + INCREMENT <= maxBrightnesses[lens][i]) {
+          brightnesses[lens][i] += INCREMENT;
+        } else {
+          // Decrease max brightness if we can
+          if (maxBrightnesses[lens][i] - MAX_DROP_OFF > 0) {
+            brightnesses[lens][i] = maxBrightnesses[lens][i];
+            maxBrightnesses[lens][i] -= MAX_DROP_OFF;
+            directions[lens][i] = -1;
+          } else {
+            // All done
+            maxBrightnesses[lens][i] = 0;
+            brightnesses[lens][i] = 0;
+            directions[lens][i] = 0;
+          }
+        }
+        // Decrease toward zero
+      } else if (directions[lens][i] < 0) {
+        if (brightnesses[lens][i] < INCREMENT) {
+          // Turn around
+          directions[lens][i] = 1;
+          brightnesses[lens][i] = 0;
+          // Also add a delay to get a better ripple effect
+          delays[lens][i] = RIPPLE_DELAY;
+        } else {
+          brightnesses[lens][i] -= INCREMENT;
+        }
+      }
+    } else {
+      --delays[lens][i];
+    }
+  }
+
+  void resetLens(const int lens, const uint8_t drop) {
+    for (auto& d : directions[lens]) {
+      d = 1;
+    }
+    delays[lens][drop] = 0;
+    maxBrightnesses[lens][drop] = MAX_BRIGHTNESS;
+    brightnesses[lens][drop] = 1;
+    // Prepare the other drops
+    for (uint8_t i = 1; i < PIXEL_RING_COUNT / 2 + 1; ++i) {
+      const int index1 = (PIXEL_RING_COUNT * 2 + drop - i) % PIXEL_RING_COUNT;
+      const int index2 = (PIXEL_RING_COUNT + drop + i) % PIXEL_RING_COUNT;
+      delays[lens][index1] = i * INITIAL_DELAY;
+      delays[lens][index2] = i * INITIAL_DELAY;
+      maxBrightnesses[lens][index1] = MAX_BRIGHTNESS - i * DROP_OFF;
+      maxBrightnesses[lens][index2] = MAX_BRIGHTNESS - i * DROP_OFF;
+    }
+  }
+
+  void update() {
+    for (int lens = 0; lens < 2; ++lens) {
+      for (int i = 0; i < PIXEL_RING_COUNT; ++i) {
+        ripple(lens, i);
+      }
+    }
+  }
+};
+
+
+static void printRow(const char* const name, const uint8_t* const row) {
+  printf("%s", name);
+  for (int i = 0; i < PIXEL_RING_COUNT; ++i) {
+    printf("%4d", row[i]);
+  }
+  printf("\n");
+}
+
+
+int main() {
+  const uint8_t DROP = 5;
+
+  static OldRipples old;
+  static Ripples<2, PIXEL_RING_COUNT, DROPS_PER_LENS> ripples;
+  old.resetLens(0, DROP);
+  ripples.drop(0, DROP);
+
+  int oldPeaks[PIXEL_RING_COUNT] = {};
+  int newPeaks[PIXEL_RING_COUNT] = {};
+  int oldLastLit = 0, newLastLit = 0;
+  long difference = 0;
+  for (int frame = 0; frame < FRAME_COUNT; ++frame) {
+    uint8_t brightnesses[2 * PIXEL_RING_COUNT];
+    ripples.update(brightnesses);
+    old.update();
+    for (int i = 0; i < PIXEL_RING_COUNT; ++i) {
+      const int before = old.brightnesses[0][i];
+      const int after = brightnesses[i];
+      oldPeaks[i] = before > oldPeaks[i] ? before : oldPeaks[i];
+      newPeaks[i] = after > newPeaks[i] ? after : newPeaks[i];
+      oldLastLit = before > 0 ? frame : oldLastLit;
+      newLastLit = after > 0 ? frame : newLastLit;
+      difference += abs(before - after);
+    }
+    if (frame < 40 && frame % 4 == 0) {
+      printf("Frame %d\n", frame);
+      printRow("  old:", old.brightnesses[0]);
+      printRow("  new:", brightnesses);
+    }
+  }
+
+  bool ok = true;
+  printf("Peaks (old/new):");
+  for (int i = 0; i < PIXEL_RING_COUNT; ++i) {
+    printf(" %d/%d", oldPeaks[i], newPeaks[i]);
+    if (abs(oldPeaks[i] - newPeaks[i]) > 1) {
+      ok = false;
+    }
+  }
+  const double meanDifference = static_cast<double>(difference) / (FRAME_COUNT * PIXEL_RING_COUNT);
+  printf(
+    "\nMean difference %.1f out of %d, last lit at frame %d (old) and %d (new)\n",
+    meanDifference,
+    OldRipples::MAX_BRIGHTNESS,
+    oldLastLit,
+    newLastLit);
+  if (!ok) {
+    printf("Every pixel's peak should match within 1\n");
+  }
+  if (meanDifference > MEAN_DIFFERENCE_LIMIT) {
+    printf("Mean difference should be under %.0f\n", MEAN_DIFFERENCE_LIMIT);
+    ok = false;
+  }
+
+  // The new one gets a drop every 30 frames per lens and keeps DROPS_PER_LENS
+  // going. The old one could only run one at a time.
+  uint8_t brightnesses[2 * PIXEL_RING_COUNT];
+  uint32_t checksum = 0;
+  const auto newStart = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame) {
+    if (frame % 30 == 0) {
+      ripples.drop(frame & 1, frame % PIXEL_RING_COUNT);
+    }
+    ripples.update(brightnesses);
+    checksum += brightnesses[frame % (2 * PIXEL_RING_COUNT)];
+  }
+  const auto oldStart = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame) {
+    if (frame % 60 == 0) {
+      old.resetLens(0, frame % PIXEL_RING_COUNT);
+      old.resetLens(1, frame % PIXEL_RING_COUNT);
+    }
+    old.update();
+    checksum += old.brightnesses[0][frame % PIXEL_RING_COUNT];
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const std::chrono::duration<double, std::nano> newElapsed = oldStart - newStart;
+  const std::chrono::duration<double, std::nano> oldElapsed = end - oldStart;
+  printf(
+    "%.0f ns per frame with %d drops per lens, %.0f ns for the old one with 1 (checksum %u)\n",
+    newElapsed.count() / BENCHMARK_FRAMES,
+    DROPS_PER_LENS,
+    oldElapsed.count() / BENCHMARK_FRAMES,
+    checksum);
+
+  return ok ? 0 : 1;
+}
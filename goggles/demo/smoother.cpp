@@ -0,0 +1,140 @@
+// Runs the same bands through SpectrumSmoother at 30, 60 and 120 frames per
+// second and checks that the levels and peaks come out the same, since it's
+// supposed to work in milliseconds rather than frames. The bands change
+// every 100 ms, which lands on a frame at all three rates. Then it checks
+// that a long gap between updates, like when the animation switches away and
+// back, is quick and ends up in the same place as a short one. Exits with 1
+// if anything is off by more than a little rounding. The mask has the same
+// spectrumSmoother.hpp, so this covers it too.
+//
+//     ./smoother
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../spectrumSmoother.hpp"
+
+// A few bands is plenty; each one is smoothed on its own
+static const int BAND_COUNT = 8;
+static const uint16_t QUIET_MAXIMUM = 50;
+static const int SEGMENT_MS = 100;
+static const int SEGMENT_COUNT = 300;
+// Out of 255. The decay factors are rounded to 15 bits, and the rounding adds
+// up differently over 3 frames than over 12.
+static const int LEVEL_LIMIT = 2;
+static const int PEAK_LIMIT = 1;
+static const int FPS[] = {30, 60, 120};
+static const int RATE_COUNT = sizeof(FPS) / sizeof(FPS[0]);
+
+// Same as spectrumAnalyzer.cpp
+static SpectrumSmoother<BAND_COUNT> makeSmoother(const uint16_t* const loudness) {
+  return SpectrumSmoother<BAND_COUNT>(loudness, 10, 80, 50, 250);
+}
+
+// Random loudness in each segment, with quiet stretches and a band that's
+// always loud so the scaling doesn't jump around
+static void makeSegments(uint16_t segments[][BAND_COUNT]) {
+  srand(1);
+  for (int s = 0; s < SEGMENT_COUNT; ++s) {
+    const bool quiet = s % 20 >= 15;
+    for (int b = 0; b < BAND_COUNT - 1; ++b) {
+      segments[s][b] = quiet ? 0 : rand() % 1000;
+    }
+    segments[s][BAND_COUNT - 1] = 1000;
+  }
+}
+
+
+int main() {
+  uint16_t loudness[BAND_COUNT];
+  for (auto& l : loudness) {
+    l = 1 << 15;
+  }
+  static uint16_t segments[SEGMENT_COUNT][BAND_COUNT];
+  makeSegments(segments);
+
+  // Levels and peaks at the end of each segment, for each rate
+  static uint8_t levels[RATE_COUNT][SEGMENT_COUNT][BAND_COUNT];
+  static uint8_t peaks[RATE_COUNT][SEGMENT_COUNT][BAND_COUNT];
+  for (int r = 0; r < RATE_COUNT; ++r) {
+    SpectrumSmoother<BAND_COUNT> smoother = makeSmoother(loudness);
+    for (int frame = 0; ; ++frame) {
+      const uint32_t now_ms = lround(frame * 1000.0 / FPS[r]);
+      const int segment = now_ms / SEGMENT_MS;
+      if (segment >= SEGMENT_COUNT) {
+        break;
+      }
+      smoother.update(segments[segment], QUIET_MAXIMUM, now_ms);
+      if (now_ms % SEGMENT_MS == 0) {
+        for (int b = 0; b < BAND_COUNT; ++b) {
+          levels[r][segment][b] = smoother.level(b);
+          peaks[r][segment][b] = smoother.peak(b);
+        }
+      }
+    }
+  }
+
+  int worstLevel = 0, worstPeak = 0;
+  for (int r = 1; r < RATE_COUNT; ++r) {
+    for (int s = 0; s < SEGMENT_COUNT; ++s) {
+      for (int b = 0; b < BAND_COUNT; ++b) {
+        const int level = abs(levels[r][s][b] - levels[0][s][b]);
+        const int peak = abs(peaks[r][s][b] - peaks[0][s][b]);
+        worstLevel = level > worstLevel ? level : worstLevel;
+        worstPeak = peak > worstPeak ? peak : worstPeak;
+      }
+    }
+  }
+  printf("Band 0 (level/peak at");
+  for (int r = 0; r < RATE_COUNT; ++r) {
+    printf(" %d", FPS[r]);
+  }
+  printf(" fps):\n");
+  for (int s = 0; s < 20; ++s) {
+    printf("  %4d ms", s * SEGMENT_MS);
+    for (int r = 0; r < RATE_COUNT; ++r) {
+      printf("  %3d/%3d", levels[r][s][0], peaks[r][s][0]);
+    }
+    printf("\n");
+  }
+  printf("Largest difference from 30 fps: level %d, peak %d\n", worstLevel, worstPeak);
+
+  bool ok = true;
+  if (worstLevel > LEVEL_LIMIT || worstPeak > PEAK_LIMIT) {
+    printf("Levels should match within %d and peaks within %d\n", LEVEL_LIMIT, PEAK_LIMIT);
+    ok = false;
+  }
+
+  // Everything has decayed all the way after a second, so a day's gap should
+  // end up in the same place
+  const uint32_t GAPS_MS[] = {1000, 24ul * 60 * 60 * 1000};
+  uint8_t afterGap[2][BAND_COUNT];
+  double gapUpdate_ns = 0;
+  for (int g = 0; g < 2; ++g) {
+    SpectrumSmoother<BAND_COUNT> smoother = makeSmoother(loudness);
+    uint32_t now_ms = 0;
+    smoother.update(segments[0], QUIET_MAXIMUM, now_ms);
+    smoother.update(segments[1], QUIET_MAXIMUM, now_ms += 10);
+    const int REPEATS = 1000;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < REPEATS; ++i) {
+      smoother.update(segments[i & 1], QUIET_MAXIMUM, now_ms += GAPS_MS[g]);
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    gapUpdate_ns = elapsed.count() / REPEATS;
+    for (int b = 0; b < BAND_COUNT; ++b) {
+      afterGap[g][b] = smoother.level(b);
+    }
+  }
+  printf("%.0f ns per update after a day's gap\n", gapUpdate_ns);
+  for (int b = 0; b < BAND_COUNT; ++b) {
+    if (afterGap[0][b] != afterGap[1][b]) {
+      printf("Band %d is at %d after a long gap and %d after a short one\n", b, afterGap[1][b], afterGap[0][b]);
+      ok = false;
+    }
+  }
+  return ok ? 0 : 1;
+}
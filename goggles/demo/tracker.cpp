@@ -0,0 +1,105 @@
+// Times BeatTracker::update(), which the goggles run once per envelope
+// sample (25 times a second), and throws random envelopes at it to make sure
+// the tempo and phase stay sane no matter what the microphone hears. Exits
+// with 1 if they don't.
+//
+//     ./tracker
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "../beatTracker.hpp"
+
+static const int RATE_HZ = 25;
+static const int SEED_COUNT = 200;
+static const int SAMPLES_PER_SEED = 20000;
+static const int BENCHMARK_SAMPLES = 1000000;
+
+static uint32_t randomState = 1;
+
+static uint32_t random32() {
+  randomState = randomState * 1103515245 + 12345;
+  return randomState >> 8;
+}
+
+// 0 to 1
+static float randomFloat() {
+  return static_cast<float>(random32() & 0xFFFF) / 0xFFFF;
+}
+
+// Different kinds of junk: noise, silence with spikes, huge values, and
+// something that's almost a beat
+static float envelope(const int kind, const int i) {
+  switch (kind % 4) {
+    case 0:
+      return randomFloat() * 100.0f;
+    case 1:
+      return random32() % 37 == 0 ? randomFloat() * 1000.0f : 0.0f;
+    case 2:
+      return randomFloat() * 1e6f;
+    default: {
+      const int period = 7 + kind % 20;
+      return (i % period == 0 ? 50.0f : 5.0f) + randomFloat() * 40.0f;
+    }
+  }
+}
+
+
+int main() {
+  // The period is kept between these
+  const float slowest = 60.0f * RATE_HZ / (60 * RATE_HZ / BeatTracker<RATE_HZ>::MINIMUM_BPM + 1);
+  const float fastest = 60.0f * RATE_HZ / (60 * RATE_HZ / BeatTracker<RATE_HZ>::MAXIMUM_BPM);
+
+  int failures = 0;
+  for (int seed = 0; seed < SEED_COUNT; ++seed) {
+    randomState = seed + 1;
+    BeatTracker<RATE_HZ> tracker;
+    for (int i = 0; i < SAMPLES_PER_SEED; ++i) {
+      tracker.update(envelope(seed, i));
+      const float bpm = tracker.bpm();
+      // phase() used to cast ratios over 1 to uint8_t. Build with
+      // -fsanitize=float-cast-overflow to check that it doesn't.
+      tracker.phase();
+      if (!std::isfinite(bpm) || bpm < slowest - 0.01f || bpm > fastest + 0.01f) {
+        printf("Seed %d went to %.1f BPM after %d samples\n", seed, bpm, i + 1);
+        ++failures;
+        break;
+      }
+      if (tracker.millisToNextBeat() > 1000 * 60 / slowest + 1) {
+        printf("Seed %d predicted a beat %u ms out after %d samples\n", seed, tracker.millisToNextBeat(), i + 1);
+        ++failures;
+        break;
+      }
+    }
+  }
+  printf(
+    "%d of %d random envelopes stayed between %.1f and %.1f BPM\n",
+    SEED_COUNT - failures,
+    SEED_COUNT,
+    slowest,
+    fastest);
+
+  // Something like music, so the time isn't just the easy path
+  BeatTracker<RATE_HZ> tracker;
+  randomState = 1;
+  float envelopes[1024];
+  for (int i = 0; i < 1024; ++i) {
+    envelopes[i] = (i % 12 == 0 ? 60.0f : 10.0f) + randomFloat() * 20.0f;
+  }
+  int beats = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCHMARK_SAMPLES; ++i) {
+    beats += tracker.update(envelopes[i & 1023]);
+  }
+  const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  printf(
+    "%.0f ns per envelope sample, %d beats at %.1f BPM, %zu bytes\n",
+    elapsed.count() / BENCHMARK_SAMPLES,
+    beats,
+    tracker.bpm(),
+    sizeof(tracker));
+
+  return failures == 0 ? 0 : 1;
+}
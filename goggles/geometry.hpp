@@ -0,0 +1,73 @@
+#ifndef GEOMETRY_HPP
+#define GEOMETRY_HPP
+
+#include <cstdint>
+#include <FastLED.h>
+
+#include "constants.hpp"
+
+// Where each lens's pixels are. Angles are in pixels, counted the same way on
+// both lenses, starting from the left lens's first pixel. I didn't mount the
+// lenses the same, so the right lens's first pixel is 2 pixels further around
+// than the left lens's.
+struct Lens {
+  uint8_t firstPixel;
+  uint8_t offset;  // Pixel that angle 0 is at, relative to firstPixel
+  int8_t direction;  // 1 if the pixels go the same way as the angles
+};
+
+constexpr Lens LENSES[] = {
+  {0, 0, 1},
+  {PIXEL_RING_COUNT, PIXEL_RING_COUNT - 2, 1},
+};
+const int LENS_COUNT = sizeof(LENSES) / sizeof(LENSES[0]);
+
+// Pixel index for an angle on a lens. Angle can be anything >= 0.
+constexpr uint8_t lensPixel(const int lens, const int angle) {
+  return LENSES[lens].firstPixel
+    + (LENSES[lens].offset + LENSES[lens].direction * (angle % PIXEL_RING_COUNT) + PIXEL_RING_COUNT) % PIXEL_RING_COUNT;
+}
+
+// The compiler fills these tables in from lensPixel, so nothing gets
+// computed on the Trinket. They cover 2 full turns, so that rotating or
+// mirroring an angle only needs an addition instead of a %.
+template <int... Angles>
+struct LensTables {
+  static const uint8_t pixels[LENS_COUNT][sizeof...(Angles)];
+};
+template <int... Angles>
+const uint8_t LensTables<Angles...>::pixels[LENS_COUNT][sizeof...(Angles)] = {
+  {lensPixel(0, Angles)...},
+  {lensPixel(1, Angles)...},
+};
+static_assert(LENS_COUNT == 2, "Add a row to LensTables::pixels");
+
+template <int COUNT, int... Angles>
+struct MakeLensTables : MakeLensTables<COUNT - 1, COUNT - 1, Angles...> {};
+template <int... Angles>
+struct MakeLensTables<0, Angles...> {
+  typedef LensTables<Angles...> type;
+};
+typedef MakeLensTables<2 * PIXEL_RING_COUNT>::type LensTable;
+
+// Pixel index for an angle on a lens. Angle must be < 2 * PIXEL_RING_COUNT.
+inline uint8_t pixelAt(const int lens, const uint8_t angle) {
+  return LensTable::pixels[lens][angle];
+}
+
+// Copies the left lens to the right lens, rotated by rotate pixels
+inline void copyLens(CRGB* const pixels, const uint8_t rotate = 0) {
+  for (int i = 0; i < PIXEL_RING_COUNT; ++i) {
+    pixels[pixelAt(1, i + rotate)] = pixels[pixelAt(0, i)];
+  }
+}
+
+// Copies the left lens to the right lens, flipped and then rotated by rotate
+// pixels, so it looks like the lenses are going opposite directions
+inline void mirrorLens(CRGB* const pixels, const uint8_t rotate = 0) {
+  for (int i = 0; i < PIXEL_RING_COUNT; ++i) {
+    pixels[pixelAt(1, PIXEL_RING_COUNT + rotate - i)] = pixels[pixelAt(0, i)];
+  }
+}
+
+#endif  // GEOMETRY_HPP
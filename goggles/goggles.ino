@@ -1,25 +1,25 @@
 #include <FastLED.h>
 
+#include "button.hpp"
+#include "compositor.hpp"
 #include "constants.hpp"
+#include "powerGovernor.hpp"
 
 // On Uno, if you're using Serial, this needs to be > 1. On Trinket it should be 0.
 const int LED_PIN = 0;
 const int BUTTON_PIN = 4;
 const int MODE_TIME_MS = 8000;
+const int FADE_TIME_MS = 1000;
 const int INITIAL_BRIGHTNESS = 20;
-
-// State machine for button presses
-enum class ButtonState_t {
-  UP,
-  DEBOUNCE_DOWN,
-  DOWN,
-  LONG_BUTTON_PRESS,
-  BUTTON_PRESS,
-  AFTER_BUTTON_PRESS,
-};
-static decltype(millis()) buttonDownTime = 0;
-static ButtonState_t buttonState = ButtonState_t::UP;
-static bool buttonDown = false;
+// Disable the red channel completely
+const CRGB COLOR_CORRECTION = CRGB(0, 255, 255);
+// The brightness gets turned down if the animations would run the battery
+// down faster than this. Set these for the battery you're using.
+const uint16_t BATTERY_CAPACITY_MAH = 500;
+const uint16_t BATTERY_LIFE_HOURS = 6;
+// Prints the governor's average current and the runtime it works out to
+static const bool DEBUG_POWER_GOVERNOR = false;
+static const int DEBUG_INTERVAL_MS = 5000;
 
 // Start the hue red. The Adafruit library expected a 16-bit hue, but FastLED
 // 16-but but convert to 8 it when I need to.
@@ -29,65 +29,29 @@ bool reset;  // Indicates that an animation should clear its state
 CRGB pixels[PIXEL_RING_COUNT * 2];
 CRGB dotStar;
 
+static Compositor<PIXEL_RING_COUNT * 2> compositor;
+static PowerGovernor<PIXEL_RING_COUNT * 2> governor(BATTERY_CAPACITY_MAH / BATTERY_LIFE_HOURS, COLOR_CORRECTION);
+// What configureBrightness set, before the governor turns it down
+static uint8_t brightness = INITIAL_BRIGHTNESS;
+
 void setup() {
+  if (DEBUG_POWER_GOVERNOR) {
+    Serial.begin(9600);
+  }
+
   FastLED.addLeds<NEOPIXEL, LED_PIN>(pixels, PIXEL_RING_COUNT * 2);
   FastLED.addLeds<APA102, 7, 8, BGR>(&dotStar, 1);
   FastLED.setBrightness(INITIAL_BRIGHTNESS);
-  // Disable the red channel completely
-  FastLED.setCorrection(CRGB(0, 255, 255));
+  FastLED.setCorrection(COLOR_CORRECTION);
   FastLED.clear();
   FastLED.show();
 
   analogReference(AR_DEFAULT);
   pinMode(MICROPHONE_ANALOG_PIN, INPUT);
-  pinMode(BUTTON_PIN, INPUT_PULLUP);
   pinMode(LED_PIN, OUTPUT);
   pinMode(LED_BUILTIN, OUTPUT);
 
-  attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), setButtonDownState, CHANGE);
-}
-
-
-void setButtonDownState() {
-  buttonDown = (digitalRead(BUTTON_PIN) == LOW);
-}
-
-
-void updateButtonState() {
-  const auto now = millis();
-  switch (buttonState) {
-    case ButtonState_t::UP:
-      if (buttonDown) {
-        buttonState = ButtonState_t::DEBOUNCE_DOWN;
-        buttonDownTime = millis();
-      }
-      break;
-    case ButtonState_t::DEBOUNCE_DOWN:
-      if (buttonDown && now - buttonDownTime > 20) {
-        buttonState = ButtonState_t::DOWN;
-      } else if (!buttonDown) {
-        buttonState = ButtonState_t::UP;
-      }
-      break;
-    case ButtonState_t::DOWN:
-      if (now - buttonDownTime > 500) {
-        buttonState = ButtonState_t::LONG_BUTTON_PRESS;
-      } else if (!buttonDown) {
-        buttonState = ButtonState_t::BUTTON_PRESS;
-      }
-      break;
-    case ButtonState_t::LONG_BUTTON_PRESS:
-      buttonState = ButtonState_t::AFTER_BUTTON_PRESS;
-      break;
-    case ButtonState_t::BUTTON_PRESS:
-      buttonState = ButtonState_t::AFTER_BUTTON_PRESS;
-      break;
-    case ButtonState_t::AFTER_BUTTON_PRESS:
-      if (!buttonDown) {
-        buttonState = ButtonState_t::UP;
-      }
-      break;
-  }
+  startButton(BUTTON_PIN);
 }
 
 
@@ -104,7 +68,8 @@ void configureBrightness(const bool buttonPressed) {
     }
   }
 
-  FastLED.setBrightness(BRIGHTNESSES[brightnessIndex]);
+  brightness = BRIGHTNESSES[brightnessIndex];
+  FastLED.setBrightness(brightness);
   // Turn on an LED for each brightness
   const auto color = CRGB(0x007000);
   fill_solid(&pixels[0], brightnessIndex + 1, color);
@@ -114,10 +79,15 @@ void configureBrightness(const bool buttonPressed) {
 }
 
 
-typedef void (*animationFunction_t)(uint8_t hue);
+// Animations draw one frame into pixels and return how many milliseconds
+// until they want to draw the next one, like the vest's Animation::animate().
+// They return 0 if they didn't draw anything, e.g. when waiting for audio.
+// They must not delay(), so that loop() can keep checking the button in
+// between, and they don't call FastLED.show(), so that loop() can blend them.
+typedef uint16_t (*animationFunction_t)(uint8_t hue, CRGB* pixels);
 
 // Static animations
-#define ANIM(name) void name(uint8_t hue)
+#define ANIM(name) uint16_t name(uint8_t hue, CRGB* pixels)
 ANIM(binaryClock);
 ANIM(circularWipe);
 ANIM(fadingSparks);
@@ -168,58 +138,125 @@ typedef void (*configurationFunction_t)(bool buttonPressed);
 const configurationFunction_t CONFIGURATION_FUNCTIONS[] = {configureBrightness, nullptr};
 
 
+// Compare the difference so this still works when millis() wraps
+static bool isDue(const uint32_t now_ms, const uint32_t deadline_ms) {
+  return static_cast<int32_t>(now_ms - deadline_ms) >= 0;
+}
+
+
 void loop() {
   static auto modeStartTime_ms = millis();
-  static uint8_t mode = 0;  // Current animation effect
+  // The current animation, and the one we're fading to
+  static auto currentFrame_ms = millis();
+  static auto incomingFrame_ms = millis();
+  static uint8_t mode = 0;
+  static uint8_t incomingMode = 0;
+  static bool resetCurrent = true;
+  static bool resetIncoming = false;
   static uint8_t animationsIndex = 0;
   static uint8_t configurationsIndex = COUNT_OF(CONFIGURATION_FUNCTIONS) - 1;
 
-  setButtonDownState();
-  updateButtonState();
-  if (buttonState == ButtonState_t::BUTTON_PRESS) {
-    // If we're not configuring, go to the next animation set
-    if (CONFIGURATION_FUNCTIONS[configurationsIndex] == nullptr) {
-      ++animationsIndex;
-      if (animationsIndex == COUNT_OF(ANIMATIONS_LIST)) {
-        animationsIndex = 0;
-      }
-      mode = 0;
-    }
-  } else if (buttonState == ButtonState_t::LONG_BUTTON_PRESS) {
+  // The button interrupts queue up presses, so handle one per pass
+  ButtonEvent buttonEvent;
+  const bool hasButtonEvent = takeButtonEvent(&buttonEvent);
+  if (hasButtonEvent && buttonEvent == ButtonEvent::LONG_PRESS) {
     ++configurationsIndex;
     if (configurationsIndex == COUNT_OF(CONFIGURATION_FUNCTIONS)) {
       configurationsIndex = 0;
     }
     FastLED.clear();
+    currentFrame_ms = millis();
+  } else if (hasButtonEvent && CONFIGURATION_FUNCTIONS[configurationsIndex] == nullptr) {
+    // If we're not configuring, go to the next animation set, or back one
+    // for a double press. Don't fade, so it's obvious that the button did
+    // something.
+    if (buttonEvent == ButtonEvent::DOUBLE_PRESS) {
+      animationsIndex = (animationsIndex == 0 ? COUNT_OF(ANIMATIONS_LIST) : animationsIndex) - 1;
+    } else {
+      ++animationsIndex;
+      if (animationsIndex == COUNT_OF(ANIMATIONS_LIST)) {
+        animationsIndex = 0;
+      }
+    }
+    mode = 0;
+    compositor.cut();
+    resetCurrent = true;
+    currentFrame_ms = millis();
+    modeStartTime_ms = millis();
   }
 
   if (CONFIGURATION_FUNCTIONS[configurationsIndex] != nullptr) {
-    CONFIGURATION_FUNCTIONS[configurationsIndex](buttonState == ButtonState_t::BUTTON_PRESS);
-  } else {
-    // Do a regular animation
-    const auto startAnimation_ms = millis();
-    const animationFunction_t* animations = ANIMATIONS_LIST[animationsIndex];
-    // To keep the transitions smooth, we track hue using a 16-bit number, but
-    // FastLED expects an 8-bit hue, so convert
-    animations[mode](hue >> 8);
-
-    // Update the color
-    const auto now_ms = millis();
-    // We want to complete a full hue color cycle about every X seconds
-    const int hueCycle_ms = 20000;
-    const int hueCycleLimit = 0xFFFF;
-    hue += (now_ms - startAnimation_ms) * hueCycleLimit / hueCycle_ms;
-
-    if ((now_ms - modeStartTime_ms) > MODE_TIME_MS) {
-      ++mode;
-      if (animations[mode] == nullptr) {
-        mode = 0;
-      }
-      FastLED.clear();
-      reset = true;
-      modeStartTime_ms = now_ms;
-    } else {
-      reset = false;
+    CONFIGURATION_FUNCTIONS[configurationsIndex](hasButtonEvent && buttonEvent == ButtonEvent::PRESS);
+    return;
+  }
+
+  const auto now_ms = millis();
+  const animationFunction_t* animations = ANIMATIONS_LIST[animationsIndex];
+
+  // We want to complete a full hue color cycle about every X seconds. Take
+  // it from the clock instead of adding up frame times, because short frames
+  // would round down to no change at all.
+  const uint32_t hueCycle_ms = 20000;
+  const uint32_t hueCycleLimit = 0xFFFF;
+  hue = (now_ms % hueCycle_ms) * hueCycleLimit / hueCycle_ms;
+
+  // Do the regular animations. To keep the transitions smooth, we track hue
+  // using a 16-bit number, but FastLED expects an 8-bit hue, so convert.
+  bool drew = false;
+  if (isDue(now_ms, currentFrame_ms)) {
+    reset = resetCurrent;
+    const uint16_t delay_ms = animations[mode](hue >> 8, compositor.current());
+    resetCurrent = reset = false;
+    currentFrame_ms = now_ms + delay_ms;
+    drew = drew || delay_ms != 0;
+  }
+  if (compositor.isFading() && isDue(now_ms, incomingFrame_ms)) {
+    reset = resetIncoming;
+    const uint16_t delay_ms = animations[incomingMode](hue >> 8, compositor.incoming());
+    resetIncoming = reset = false;
+    incomingFrame_ms = now_ms + delay_ms;
+    drew = drew || delay_ms != 0;
+  }
+  if (drew) {
+    if (compositor.compose(now_ms, pixels)) {
+      // The fade is done
+      mode = incomingMode;
+      currentFrame_ms = incomingFrame_ms;
+    }
+    FastLED.setBrightness(governor.update(pixels, brightness, now_ms));
+    FastLED.show();
+    if (DEBUG_POWER_GOVERNOR) {
+      printPowerGovernorStats(now_ms);
+    }
+  }
+
+  if (!compositor.isFading() && (now_ms - modeStartTime_ms) > MODE_TIME_MS) {
+    uint8_t nextMode = mode + 1;
+    if (animations[nextMode] == nullptr) {
+      nextMode = 0;
     }
+    // Sets with 1 animation just keep going
+    if (nextMode != mode) {
+      incomingMode = nextMode;
+      resetIncoming = true;
+      incomingFrame_ms = now_ms;
+      compositor.startFade(now_ms, FADE_TIME_MS);
+    }
+    modeStartTime_ms = now_ms;
+  }
+}
+
+
+void printPowerGovernorStats(const uint32_t now_ms) {
+  static uint32_t lastPrint_ms = 0;
+  if (now_ms - lastPrint_ms < DEBUG_INTERVAL_MS) {
+    return;
   }
+  lastPrint_ms = now_ms;
+  Serial.printf(
+    "%u mA average, %u minutes of battery, brightness %u scaled to %u/255\n",
+    governor.averageCurrent_mA(),
+    governor.runtime_minutes(BATTERY_CAPACITY_MAH),
+    brightness,
+    governor.scaling());
 }
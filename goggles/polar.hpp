@@ -0,0 +1,114 @@
+#ifndef POLAR_HPP
+#define POLAR_HPP
+
+#include <cstdint>
+
+// Draws effects on rings of LEDs from functions of angle and time, kind of
+// like shaders. Instead of every animation working out angles from pixel
+// indexes on its own, it writes a function that returns a brightness for an
+// angle, and the ring samples that a few times across each pixel and
+// averages them. That way things can move by less than a pixel per frame,
+// and edges fade between neighboring pixels instead of jumping.
+//
+// Angles are fractions of a turn, where 0x10000 is a full turn, so they wrap
+// around for free as uint16_t. The angle of each pixel is in a table that the
+// compiler fills in for whatever ring sizes get used (the goggles have 20,
+// the monk mask 45, and the 24 pixel rings work too), so nothing gets
+// computed on the Trinket.
+//
+// This doesn't use Arduino or FastLED, so effects can be built and timed on a
+// computer. The goggles and the monk mask both use this. Arduino won't
+// compile files from outside the sketch directory, so each has a copy; keep
+// them in sync.
+typedef uint16_t angle_t;
+
+const uint32_t FULL_TURN = 0x10000;
+
+template <int... Pixels>
+struct PolarPixels {};
+template <int COUNT, int... Pixels>
+struct MakePolarPixels : MakePolarPixels<COUNT - 1, COUNT - 1, Pixels...> {};
+template <int... Pixels>
+struct MakePolarPixels<0, Pixels...> {
+  typedef PolarPixels<Pixels...> type;
+};
+
+template <int PIXEL_COUNT, typename Pixels>
+struct PolarTable;
+template <int PIXEL_COUNT, int... Pixels>
+struct PolarTable<PIXEL_COUNT, PolarPixels<Pixels...>> {
+  static const angle_t angles[PIXEL_COUNT];
+};
+template <int PIXEL_COUNT, int... Pixels>
+const angle_t PolarTable<PIXEL_COUNT, PolarPixels<Pixels...>>::angles[PIXEL_COUNT] = {
+  static_cast<angle_t>((Pixels * FULL_TURN + PIXEL_COUNT / 2) / PIXEL_COUNT)...
+};
+
+template <int PIXEL_COUNT, int SUBSAMPLES = 4>
+class PolarRing {
+  public:
+    static_assert(PIXEL_COUNT > 0 && PIXEL_COUNT <= 256, "Pixel indexes are 8 bits");
+    static_assert(SUBSAMPLES > 0 && SUBSAMPLES <= 256, "Sums are 16 bits");
+
+    // How much of a turn each pixel covers
+    static const angle_t PIXEL_WIDTH = FULL_TURN / PIXEL_COUNT;
+
+    // Angle of the center of a pixel. Pixel 0 is at angle 0.
+    static angle_t angle(const int pixel) {
+      return Table::angles[pixel];
+    }
+
+    // Writes PIXEL_COUNT values. shader is called like
+    // uint8_t shader(angle_t angle, uint32_t time_ms), SUBSAMPLES times for
+    // each pixel, spread evenly across the pixel.
+    template <typename Shader>
+    static void render(const Shader& shader, const uint32_t time_ms, uint8_t* const values) {
+      for (int i = 0; i < PIXEL_COUNT; ++i) {
+        angle_t angle = Table::angles[i] - PIXEL_WIDTH / 2 + SUBSAMPLE_WIDTH / 2;
+        uint16_t total = 0;
+        for (int j = 0; j < SUBSAMPLES; ++j) {
+          total += shader(angle, time_ms);
+          angle += SUBSAMPLE_WIDTH;
+        }
+        values[i] = total / SUBSAMPLES;
+      }
+    }
+
+  private:
+    static const angle_t SUBSAMPLE_WIDTH = PIXEL_WIDTH / SUBSAMPLES;
+    typedef PolarTable<PIXEL_COUNT, typename MakePolarPixels<PIXEL_COUNT>::type> Table;
+};
+
+// Some building blocks for shaders
+
+// Angle that something going around once every period_ms is at
+inline angle_t spinAngle(const uint32_t time_ms, const uint32_t period_ms) {
+  return (time_ms % period_ms) * FULL_TURN / period_ms;
+}
+
+// How far angle is behind head, going backwards around the ring
+inline angle_t behind(const angle_t head, const angle_t angle) {
+  return head - angle;
+}
+
+// Full brightness at the head of a swirl, halving every halfLength behind it
+inline uint8_t fadingTail(const angle_t distance, const angle_t halfLength) {
+  const int halvings = distance / halfLength;
+  if (halvings >= 8) {
+    return 0;
+  }
+  const uint8_t brightness = 0xFF >> halvings;
+  // Slide between the halvings so that the tail moves smoothly
+  return brightness - static_cast<uint32_t>(brightness / 2) * (distance % halfLength) / halfLength;
+}
+
+// brightest at the head of a swirl, going down in a straight line to 0 at
+// length behind it
+inline uint8_t linearTail(const angle_t distance, const angle_t length, const uint8_t brightest) {
+  if (distance >= length) {
+    return 0;
+  }
+  return brightest - static_cast<uint32_t>(brightest) * distance / length;
+}
+
+#endif  // POLAR_HPP
@@ -0,0 +1,134 @@
+#ifndef POWER_GOVERNOR_HPP
+#define POWER_GOVERNOR_HPP
+
+#include <cstdint>
+#include <FastLED.h>
+
+// Keeps the goggles inside a battery budget. Some animations light every
+// pixel and some only light a few, so a fixed brightness either wastes the
+// dim ones or runs the battery down on the bright ones. This estimates how
+// much current each frame draws and turns the brightness down when the
+// average over the last several seconds is over the budget. Short bright
+// bursts are fine, because only the average matters for battery life.
+//
+// The brightness slides toward the target instead of jumping, so you don't
+// see it working. It also keeps a longer running average of what was
+// actually drawn, so that I can tell how long the battery will last.
+template <int PIXEL_COUNT>
+class PowerGovernor {
+  public:
+    // correction should match FastLED.setCorrection(), because channels that
+    // are corrected down draw less
+    PowerGovernor(const uint16_t budget_mA, const CRGB& correction) :
+      budget(static_cast<uint32_t>(budget_mA) << FRACTION_BITS),
+      correction(correction),
+      requestedAverage(0),
+      drawnAverage(static_cast<uint32_t>(IDLE_MA) << FRACTION_BITS),
+      scale(FULL_SCALE),
+      lastUpdate_ms(0),
+      started(false)
+    {}
+
+    // Call this with each frame right before showing it. brightness is the
+    // brightness that was asked for. Returns the brightness to show it at.
+    uint8_t update(const CRGB* const pixels, const uint8_t brightness, const uint32_t now_ms) {
+      const uint32_t requested = ledCurrent(pixels, brightness);
+      const uint32_t elapsed_ms = now_ms - lastUpdate_ms;
+      lastUpdate_ms = now_ms;
+      if (started) {
+        requestedAverage = average(requestedAverage, requested, elapsed_ms, BUDGET_WINDOW_MS);
+      } else {
+        requestedAverage = requested;
+        started = true;
+      }
+
+      // Scale the LED part of the current so the average fits in the budget.
+      // The board and idle pixels draw the same no matter what.
+      const uint32_t idle = static_cast<uint32_t>(IDLE_MA) << FRACTION_BITS;
+      const uint32_t available = budget > idle ? budget - idle : 0;
+      uint32_t target = FULL_SCALE;
+      if (requestedAverage > available) {
+        target = static_cast<uint64_t>(available) * FULL_SCALE / requestedAverage;
+        target = target < MINIMUM_SCALE ? MINIMUM_SCALE : target;
+      }
+      const uint32_t step = elapsed_ms * FULL_SCALE / SLEW_MS;
+      if (scale < target) {
+        scale = target - scale < step ? target : scale + step;
+      } else {
+        scale = scale - target < step ? target : scale - step;
+      }
+
+      uint8_t governed = (static_cast<uint32_t>(brightness) * scale) >> SCALE_BITS;
+      if (governed == 0 && brightness > 0) {
+        governed = 1;
+      }
+      const uint32_t drawn = idle + (brightness > 0 ? static_cast<uint64_t>(requested) * governed / brightness : 0);
+      drawnAverage = average(drawnAverage, drawn, elapsed_ms, REPORT_WINDOW_MS);
+      return governed;
+    }
+
+    // Average current over about the last minute, including the board
+    uint16_t averageCurrent_mA() const {
+      return drawnAverage >> FRACTION_BITS;
+    }
+
+    // How long a full battery would last at the average current
+    uint16_t runtime_minutes(const uint16_t capacity_mAh) const {
+      return (static_cast<uint64_t>(capacity_mAh) * 60 << FRACTION_BITS) / drawnAverage;
+    }
+
+    // How much the brightness is being turned down, 255 for not at all
+    uint8_t scaling() const {
+      return scale >= FULL_SCALE ? 255 : scale >> (SCALE_BITS - 8);
+    }
+
+  private:
+    // WS2812s draw about 20 mA per color at full brightness and about 1 mA
+    // when they're off, and the Trinket draws about 10 mA
+    static const uint16_t CHANNEL_MA = 20;
+    static const uint16_t IDLE_MA = 10 + PIXEL_COUNT;
+    // Currents are in 1/65536 mA, so that the averages still move when a
+    // frame only changes them by a tiny bit
+    static const int FRACTION_BITS = 16;
+    // Scales are in 1/65536
+    static const int SCALE_BITS = 16;
+    static const uint32_t FULL_SCALE = 1ul << SCALE_BITS;
+    // Never go darker than this, or it looks like it's off
+    static const uint32_t MINIMUM_SCALE = FULL_SCALE / 8;
+
+    static const uint32_t BUDGET_WINDOW_MS = 10000;
+    static const uint32_t REPORT_WINDOW_MS = 60000;
+    // How long the brightness takes to go all the way up or down
+    static const uint32_t SLEW_MS = 5000;
+
+    const uint32_t budget;
+    const CRGB correction;
+    uint32_t requestedAverage;
+    uint32_t drawnAverage;
+    uint32_t scale;
+    uint32_t lastUpdate_ms;
+    bool started;
+
+    // Current that the LEDs draw
+    uint32_t ledCurrent(const CRGB* const pixels, const uint8_t brightness) const {
+      uint32_t red = 0;
+      uint32_t green = 0;
+      uint32_t blue = 0;
+      for (int i = 0; i < PIXEL_COUNT; ++i) {
+        red += pixels[i].r;
+        green += pixels[i].g;
+        blue += pixels[i].b;
+      }
+      const uint32_t total = (red * correction.r + green * correction.g + blue * correction.b) >> 8;
+      return (static_cast<uint64_t>(total * brightness / 255 * CHANNEL_MA) << FRACTION_BITS) / 255;
+    }
+
+    // Exponential moving average that doesn't depend on the frame rate
+    static uint32_t average(const uint32_t previous, const uint32_t value, uint32_t elapsed_ms, const uint32_t window_ms) {
+      elapsed_ms = elapsed_ms < window_ms ? elapsed_ms : window_ms;
+      const int64_t difference = static_cast<int64_t>(value) - previous;
+      return previous + difference * static_cast<int32_t>(elapsed_ms) / static_cast<int32_t>(window_ms);
+    }
+};
+
+#endif  // POWER_GOVERNOR_HPP
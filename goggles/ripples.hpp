@@ -0,0 +1,156 @@
+#ifndef RIPPLES_HPP
+#define RIPPLES_HPP
+
+#include <cstdint>
+
+// Water drop ripples on rings of LEDs.
+//
+// Every pixel does the same thing after a drop: it bounces up and down a few
+// times, getting dimmer each time, starting later and peaking lower the
+// further it is from the drop. So instead of running a state machine for
+// every pixel, we record one bounce sequence in a table, and a pixel's
+// brightness is just a lookup by how long ago the drop reached it. Each ring
+// can have several drops going at once, and they add together.
+//
+// The lookup indexes wrap around as uint8_t, so pixels the ripple hasn't
+// reached yet and drops that are finished both land on zeros in the table,
+// and the pixel loop doesn't need any special cases. This doesn't use
+// Arduino or FastLED, so it can be built on a computer.
+template <int RING_COUNT, int PIXELS_PER_RING, int DROPS_PER_RING>
+class Ripples {
+  public:
+    static const int PIXEL_COUNT = RING_COUNT * PIXELS_PER_RING;
+
+    Ripples() : envelope(), delays(), gains(), drops() {
+      recordEnvelope();
+      for (int offset = 0; offset < 2 * PIXELS_PER_RING; ++offset) {
+        int distance = offset - PIXELS_PER_RING;
+        distance = distance < 0 ? -distance : distance;
+        distance = distance < PIXELS_PER_RING - distance ? distance : PIXELS_PER_RING - distance;
+        delays[offset] = distance * DELAY_PER_PIXEL;
+        gains[offset] = 255 - distance * DROP_OFF * 255 / MAX_BRIGHTNESS;
+      }
+      clear();
+    }
+
+    void clear() {
+      for (int ring = 0; ring < RING_COUNT; ++ring) {
+        for (int i = 0; i < DROPS_PER_RING; ++i) {
+          drops[ring][i].age = IDLE_AGE;
+          drops[ring][i].position = 0;
+        }
+      }
+    }
+
+    // Starts a new drop, replacing the oldest one on that ring
+    void drop(const int ring, const uint8_t position) {
+      Drop* oldest = &drops[ring][0];
+      for (int i = 1; i < DROPS_PER_RING; ++i) {
+        if (drops[ring][i].age > oldest->age) {
+          oldest = &drops[ring][i];
+        }
+      }
+      oldest->age = 0;
+      oldest->position = position;
+    }
+
+    // Frames since the most recent drop on the ring
+    uint8_t youngestAge(const int ring) const {
+      uint8_t youngest = IDLE_AGE;
+      for (int i = 0; i < DROPS_PER_RING; ++i) {
+        youngest = drops[ring][i].age < youngest ? drops[ring][i].age : youngest;
+      }
+      return youngest;
+    }
+
+    // Writes PIXEL_COUNT brightnesses and advances one frame
+    void update(uint8_t* const brightnesses) {
+      for (int ring = 0; ring < RING_COUNT; ++ring) {
+        const Drop* const ringDrops = drops[ring];
+        uint8_t* const ringBrightnesses = &brightnesses[ring * PIXELS_PER_RING];
+        for (int i = 0; i < PIXELS_PER_RING; ++i) {
+          uint16_t total = 0;
+          for (int j = 0; j < DROPS_PER_RING; ++j) {
+            const uint8_t offset = i + PIXELS_PER_RING - ringDrops[j].position;
+            const uint8_t age = ringDrops[j].age - delays[offset];
+            total += (envelope[age] * gains[offset]) >> 8;
+          }
+          ringBrightnesses[i] = total > 255 ? 255 : total;
+        }
+      }
+
+      for (int ring = 0; ring < RING_COUNT; ++ring) {
+        for (int i = 0; i < DROPS_PER_RING; ++i) {
+          Drop& drop = drops[ring][i];
+          drop.age += drop.age < IDLE_AGE;
+        }
+      }
+    }
+
+  private:
+    // These are the same numbers that the old per-pixel state machine used
+    static const int MAX_BRIGHTNESS = 100;
+    static const int INCREMENT = 20;
+    static const int MAX_DROP_OFF = 15;
+    static const int RIPPLE_DELAY = 3;
+    // How much later and dimmer the ripple is for each pixel further away
+    static const int DELAY_PER_PIXEL = 3;
+    static const int DROP_OFF = 5;
+
+    // Drops stop aging here. It has to be far enough past the end of the
+    // envelope that subtracting any delay still lands on a zero.
+    static const uint8_t IDLE_AGE = 200;
+    static_assert(PIXELS_PER_RING / 2 * DELAY_PER_PIXEL < 256 - IDLE_AGE, "Delays overlap the idle age");
+    static_assert(MAX_BRIGHTNESS > PIXELS_PER_RING / 2 * DROP_OFF, "");
+
+    struct Drop {
+      uint8_t age;  // Frames since the drop
+      uint8_t position;
+    };
+
+    // Brightness by frames since the ripple reached the pixel
+    uint8_t envelope[256];
+    // Indexed by pixel - drop position + PIXELS_PER_RING, so we don't need %
+    uint8_t delays[2 * PIXELS_PER_RING];
+    uint8_t gains[2 * PIXELS_PER_RING];
+    Drop drops[RING_COUNT][DROPS_PER_RING];
+
+    // Runs the old per-pixel bounce once and records it. The pixel increases
+    // up to some max brightness, then turns around and decreases to 0, pauses
+    // and increases again. Each time max is reached, the max is decreased.
+    void recordEnvelope() {
+      int brightness = 0;
+      int maxBrightness = MAX_BRIGHTNESS;
+      int direction = 1;
+      int delay = 0;
+      int frame = 0;
+      while (direction != 0) {
+        if (delay > 0) {
+          --delay;
+        } else if (direction > 0) {
+          if (brightness + INCREMENT <= maxBrightness) {
+            brightness += INCREMENT;
+          } else if (maxBrightness - MAX_DROP_OFF > 0) {
+            brightness = maxBrightness;
+            maxBrightness -= MAX_DROP_OFF;
+            direction = -1;
+          } else {
+            brightness = 0;
+            direction = 0;
+          }
+        } else {
+          if (brightness < INCREMENT) {
+            direction = 1;
+            brightness = 0;
+            delay = RIPPLE_DELAY;
+          } else {
+            brightness -= INCREMENT;
+          }
+        }
+        envelope[frame] = brightness;
+        ++frame;
+      }
+    }
+};
+
+#endif  // RIPPLES_HPP
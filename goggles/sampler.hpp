@@ -0,0 +1,78 @@
+#ifndef SAMPLER_HPP
+#define SAMPLER_HPP
+
+#include <cstdint>
+
+// Background ADC sampling. A timer interrupt reads the microphone at a fixed
+// rate and hands each sample to a callback, so nothing has to busy wait in
+// loop() to keep the sample rate steady.
+//
+// The goggles and the monk mask both use this. Arduino won't compile files
+// from outside the sketch directory, so each has a copy; keep them in sync.
+
+typedef void (*sampleCallback_t)(int16_t sample);
+
+// Starts sampling pin at rate_hz, calling callback from the interrupt with
+// the raw 10-bit reading. Calling this again with a different callback just
+// switches who receives the samples.
+void startSampling(uint8_t pin, uint16_t rate_hz, sampleCallback_t callback);
+void stopSampling();
+// Number of sample periods that didn't get a sample, because something like
+// FastLED.show() held off interrupts for longer than a period. The blocks
+// don't have gaps in them, so time skips ahead wherever these were.
+uint16_t droppedSampleCount();
+
+
+// Collects samples from the interrupt into blocks of BLOCK_SIZE. While the
+// main loop is working on one block, the interrupt fills the other one.
+template <typename T, int BLOCK_SIZE>
+class SampleBlocks {
+  public:
+    SampleBlocks() : blocks(), writeBlock(0), readyBlock(1), writeIndex(0), ready(false), overruns(0) {}
+
+    // Call this from the interrupt. Returns true if the sample finished a
+    // block, e.g. so the caller can timestamp it.
+    bool push(const T sample) {
+      blocks[writeBlock][writeIndex] = sample;
+      ++writeIndex;
+      if (writeIndex == BLOCK_SIZE) {
+        if (ready) {
+          // Nobody took the last block, so it gets overwritten
+          ++overruns;
+        }
+        writeIndex = 0;
+        readyBlock = writeBlock;
+        writeBlock ^= 1;
+        ready = true;
+        return true;
+      }
+      return false;
+    }
+
+    // Returns the most recently completed block, or nullptr if there hasn't
+    // been a new one since the last call. The block stays valid until the
+    // interrupt finishes filling the other block, which may already be partly
+    // full, so use it or copy it out right away.
+    const T* take() {
+      if (!ready) {
+        return nullptr;
+      }
+      ready = false;
+      return blocks[readyBlock];
+    }
+
+    // Number of blocks that were dropped because take() wasn't called in time
+    uint16_t overrunCount() const {
+      return overruns;
+    }
+
+  private:
+    T blocks[2][BLOCK_SIZE];
+    volatile uint8_t writeBlock;
+    volatile uint8_t readyBlock;
+    volatile uint16_t writeIndex;
+    volatile bool ready;
+    volatile uint16_t overruns;
+};
+
+#endif  // SAMPLER_HPP
@@ -1,104 +1,84 @@
 #include <Arduino.h>
-#include <arduinoFFT.h>
 #include <cstdint>
+#include <cstring>
 #include <FastLED.h>
 
+#include "bands.hpp"
 #include "constants.hpp"
-
-// Note: I manually edited the arduinoFFT files so that it uses floats instead
-// of doubles, so that it's faster. You'll need to do that too. Alternatively,
-// you can change this back to double if you don't want to edit library files.
-// With the double version, I get about 13 updates per second; with the float
-// version, I get 66.
-typedef double FftType;
-
+#include "fixedFft.hpp"
+#include "sampler.hpp"
+#include "spectrumSmoother.hpp"
 
 // Sample count must be a power of 2. I chose 128 because only half of the values
-// from the FFT correspond to frequencies, and the first 2 are sample averages, so
-// I needed more than 2 * PIXEL_RING_COUNT * 2 + 2, which gives me 128.
+// from the FFT correspond to frequencies, and the low bands need a few bins per
+// octave.
 static const int SAMPLE_COUNT = 128;
 
-extern CRGB pixels[2 * PIXEL_RING_COUNT];
+// Most songs have notes in the lower end, so from experimental
+// observation, this seems like a good choice
+static const uint16_t SAMPLING_FREQUENCY_HZ = 5000;
 
+// bands.hpp is generated for these, so regenerate it if they change
+static_assert(BAND_SAMPLE_COUNT == SAMPLE_COUNT, "Regenerate bands.hpp");
+static_assert(BAND_SAMPLING_FREQUENCY_HZ == SAMPLING_FREQUENCY_HZ, "Regenerate bands.hpp");
+static_assert(BAND_COUNT == 2 * PIXEL_RING_COUNT, "Regenerate bands.hpp");
 
-void spectrumAnalyzer(uint8_t) {
-  // Most songs have notes in the lower end, so from experimental
-  // observation, this seems like a good choice
-  const uint32_t SAMPLING_FREQUENCY_HZ = 5000;
-  const uint32_t samplingPeriod_us = round(1000000 * (1.0 / SAMPLING_FREQUENCY_HZ));
-  static arduinoFFT FFT = arduinoFFT();
-  static uint8_t previousValues[2 * PIXEL_RING_COUNT] = {0};
-  // Change the base hue of low intensity sounds so we can get more colors
-  static uint32_t baseHue = 0;
+// Each FFT overlaps the previous one by half, so we get a new frame every 64
+// samples (78 Hz) instead of every 128
+static const int HOP_COUNT = SAMPLE_COUNT / 2;
 
-  FftType vReal[SAMPLE_COUNT];
-  FftType vImaginary[SAMPLE_COUNT];
-  FftType sampleAverages[2 * PIXEL_RING_COUNT];
-  const int usableValues = COUNT_OF(vReal) / 2;
-  const int stepSize = usableValues / COUNT_OF(sampleAverages);
+// If the loudest band is quieter than this, don't scale it up to full
+// brightness, or we'd just be visualizing random noise
+static const uint16_t QUIET_MAXIMUM = 50;
 
-  baseHue += 100;
+static SampleBlocks<int16_t, HOP_COUNT> spectrumSamples;
 
-  for (int i = 0; i < SAMPLE_COUNT; ++i) {
-    // TODO: Do we need to worry about overflow?
-    const auto before = micros();
+static void pushSpectrumSample(const int16_t sample) {
+  spectrumSamples.push(sample);
+}
 
-    vReal[i] = analogRead(MICROPHONE_ANALOG_PIN);
-    vImaginary[i] = 0;
 
-    const auto now = micros();
-    // I don't know if this is better than a busy wait loop or not
-    delayMicroseconds(before + samplingPeriod_us - now);
-  }
+uint16_t spectrumAnalyzer(uint8_t, CRGB* const pixels) {
+  static FixedFft<SAMPLE_COUNT> fft;
+  static int16_t history[SAMPLE_COUNT] = {0};
+  // Quick to light up, then the peaks hold for a moment and drop off
+  static SpectrumSmoother<2 * PIXEL_RING_COUNT> smoother(BAND_LOUDNESS, 10, 80, 50, 250);
+  // Change the base hue of low intensity sounds so we can get more colors
+  static uint32_t baseHue = 0;
 
-  FFT.Windowing(vReal, SAMPLE_COUNT, FFT_WIN_TYP_HAMMING, FFT_FORWARD);
-  FFT.Compute(vReal, vImaginary, SAMPLE_COUNT, FFT_FORWARD);
-  FFT.ComplexToMagnitude(vReal, vImaginary, SAMPLE_COUNT);
-
-  // The first 2 samples? are the average power of the signal, so skip them.
-  // Samples < 20Hz are so low that humans can't hear them, so skip those too.
-  const int SKIP = 2 + 5;
-  uint8_t counter = SKIP;
-  for (uint16_t i = 0; i < COUNT_OF(sampleAverages); ++i) {
-    sampleAverages[i] = 0;
-    // The FFT gives us equally spaced buckets (e.g. bucket 1 is 0-100 Hz, bucket 2 is 100-200 Hz)
-    // but notes increase in frequency quadratically. In fact, each increase in octave is double
-    // the frequency. As a kludge, just skip every other sample for the first half of the samples.
-    const int increment = i < COUNT_OF(sampleAverages) / 2 ? 2 : 1;
-    for (int j = 0; j < stepSize; j += increment, ++counter) {
-      sampleAverages[i] += vReal[counter];
-    }
-    // This division should compile down to a right bit shift
-    sampleAverages[i] /= stepSize;
-    // To be accurate, we should multiply by the increment. However, I've found that percussion
-    // tends to be lower, and it overwhelms the other stuff. Since we're biasing against low sounds
-    // anyway, we just won't do that. I think the visualization looks better. Sorry bass line.
+  uint16_t magnitudes[SAMPLE_COUNT / 2];
+  uint16_t bands[2 * PIXEL_RING_COUNT];
+
+  // The sampler fills the next block while we're working on this one. Don't
+  // redraw until there's new audio, because FastLED.show() holds off
+  // interrupts and would starve the sampler. Returning 0 tells loop() that we
+  // didn't draw anything.
+  startSampling(MICROPHONE_ANALOG_PIN, SAMPLING_FREQUENCY_HZ, pushSpectrumSample);
+  const int16_t* const samples = spectrumSamples.take();
+  if (samples == nullptr) {
+    return 0;
   }
 
-  FftType max_ = -1;
-  for (auto sa : sampleAverages) {
-    max_ = max(max_, sa);
-  }
-  // Set a default max so that if it's quiet, we're not visualizing random noises
-  max_ = max(max_, 400);
-  const FftType MULTIPLIER = 1.0 / max_;
-  // Clamp them all to 0.0 - 1.0
-  for (auto& sa : sampleAverages) {
-    sa *= MULTIPLIER;
-  }
+  baseHue += 100;
+
+  memmove(&history[0], &history[HOP_COUNT], (SAMPLE_COUNT - HOP_COUNT) * sizeof(history[0]));
+  memcpy(&history[SAMPLE_COUNT - HOP_COUNT], samples, HOP_COUNT * sizeof(history[0]));
+  fft.magnitudes(history, magnitudes);
+
+  // The FFT gives us equally spaced buckets, but each octave is double the
+  // frequency of the last one, so give each octave the same number of pixels
+  mapToBands(magnitudes, bands);
+  smoother.update(bands, QUIET_MAXIMUM, millis());
 
   const uint8_t MAX_BRIGHTNESS = 128;
   // This cutoff needs some tweaking based on pixels->getBrightness()
   // 10 works with brightness = 20
   const uint8_t CUTOFF = 10;
 
-  for (uint8_t i = 0; i < COUNT_OF(sampleAverages); ++i) {
-    // Implement a fade-off effect
-    const int FADE_OFF = 20;
-    const uint8_t value_ = max(previousValues[i] > FADE_OFF ? previousValues[i] - FADE_OFF : 0, sampleAverages[i] * 0xFF);
-    previousValues[i] = value_;
-    const uint32_t hue = static_cast<uint32_t>(value_) * 0xFF + baseHue;
-    uint8_t brightness = min(MAX_BRIGHTNESS, value_);
+  for (uint8_t i = 0; i < COUNT_OF(bands); ++i) {
+    // The peaks light the pixels up and the smoother levels pick the colors
+    const uint32_t hue = static_cast<uint32_t>(smoother.level(i)) * 0xFF + baseHue;
+    uint8_t brightness = min(MAX_BRIGHTNESS, smoother.peak(i));
     // The visualization looks like garbage when brightness is high because all of the
     // pixels turn on, and I want dim pixels off
     if (brightness < CUTOFF) {
@@ -107,5 +87,6 @@ void spectrumAnalyzer(uint8_t) {
     pixels[i] = CHSV(hue, 0xFF, brightness);
   }
 
-  FastLED.show();
+  // Check for the next block of audio as soon as possible
+  return 1;
 }
@@ -0,0 +1,67 @@
+#ifndef ANIMATION_HPP
+#define ANIMATION_HPP
+
+#include <cstdint>
+#include <FastLED.h>
+
+// Small, fast random numbers (xorshift32). Each animation has its own, so
+// the same seed always gives the same frames, no matter what other
+// animations have drawn.
+class Rng {
+  public:
+    explicit Rng(const uint32_t seed) : state(1) {
+      reseed(seed);
+    }
+
+    void reseed(const uint32_t seed) {
+      // xorshift gets stuck on 0
+      state = seed == 0 ? 1 : seed;
+    }
+
+    uint32_t next() {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+    }
+
+    // 0 to limit - 1, like Arduino's random(limit)
+    uint16_t below(const uint16_t limit) {
+      return ((next() >> 16) * limit) >> 16;
+    }
+
+  private:
+    uint32_t state;
+};
+
+
+// The mask animations used to be free functions with static variables and a
+// global reset flag, which made them hard to run anywhere but on the mask.
+// Now each one is an object that owns its state, which is all sized at
+// compile time, so nothing gets allocated while drawing. Animations don't
+// call millis(), random(), delay() or FastLED.show(), so the demo runner can
+// draw thousands of frames a second on a computer.
+class Animation {
+  public:
+    // Starts over from the beginning. Random choices come from the seed.
+    void reset(const uint32_t seed) {
+      rng.reseed(seed);
+      restart();
+    }
+
+    // Draws the next frame into leds. Returns how many milliseconds to show
+    // it for, or 0 if nothing changed and it should be called again soon.
+    virtual uint16_t draw(uint8_t hue, uint32_t now_ms, CRGB* leds) = 0;
+
+  protected:
+    Animation() : rng(1) {}
+    // Animations are never deleted, so this doesn't need to be virtual
+    ~Animation() {}
+
+    // Clears the animation's own state
+    virtual void restart() = 0;
+
+    Rng rng;
+};
+
+#endif  // ANIMATION_HPP
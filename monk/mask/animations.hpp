@@ -0,0 +1,464 @@
+#ifndef ANIMATIONS_HPP
+#define ANIMATIONS_HPP
+
+/** Simpler animations go here */
+
+#include <cstdint>
+#include <FastLED.h>
+
+#include "animation.hpp"
+#include "constants.hpp"
+#include "polar.hpp"
+
+// Each of these keeps what it needs between frames in a State struct, so
+// it's easy to see how much RAM an animation takes, and restart() just puts
+// it back to how it started. They're templates on the pixel count so that
+// the compiler sizes the state for whatever strip they're drawn on.
+
+
+template <int PIXEL_COUNT>
+class BinaryClock : public Animation {
+  public:
+    uint16_t draw(const uint8_t hue, const uint32_t now_ms, CRGB* const leds) override {
+      // Do a binary shift instead of integer division because of speed and code size.
+      // It's a little less precise, but who cares.
+      // Show 1/4 seconds instead of full seconds because it's more interesting. It
+      // updates a lot faster and the other lens lights up faster.
+      uint32_t number = now_ms >> 8;
+      const CRGB color = CHSV(hue, 0xFF, 0xFF);
+      for (int led = 0; number > 0 && led < PIXEL_COUNT; led += 2) {
+        leds[led] = (number & 1) ? color : CRGB(CRGB::Black);
+        number >>= 1;
+      }
+      return 100;
+    }
+
+  protected:
+    void restart() override {}
+};
+
+
+template <int PIXEL_COUNT>
+class Breathe : public Animation {
+  public:
+    Breathe() : state() {}
+
+    uint16_t draw(const uint8_t hue, const uint32_t now_ms, CRGB* const leds) override {
+      const uint32_t ZERO_PAUSE_MS = 1000;
+
+      fill_solid(leds, PIXEL_COUNT, CRGB::Black);
+      if (state.paused) {
+        if (now_ms - state.zeroStart_ms > ZERO_PAUSE_MS) {
+          state.paused = false;
+        }
+        return 10;
+      }
+      state.brightness += state.step;
+      if (state.brightness == 192) {
+        state.step = -1;
+      } else if (state.brightness == 0) {
+        state.step = 1;
+        state.paused = true;
+        state.zeroStart_ms = now_ms;
+      }
+      fill_solid(leds, PIXEL_COUNT, CHSV(hue, 0xFF, state.brightness));
+      return 10;
+    }
+
+  protected:
+    void restart() override {
+      state.brightness = 1;
+      state.step = 1;
+      state.paused = false;
+      state.zeroStart_ms = 0;
+    }
+
+  private:
+    struct State {
+      uint8_t brightness;
+      int8_t step;
+      // Stay off for a bit at the bottom of each breath
+      bool paused;
+      uint32_t zeroStart_ms;
+    };
+    State state;
+};
+
+
+template <int PIXEL_COUNT>
+class CircularWipe : public Animation {
+  public:
+    CircularWipe() : state() {}
+
+    uint16_t draw(const uint8_t hue, const uint32_t now_ms, CRGB* const leds) override {
+      const int HUE_INCREMENT = 60;
+      const int DIMMER = 60;
+      // The head fades down to DIMMER over this many LEDs
+      const int TAIL_LENGTH = 7;
+      const uint32_t WIPE_MS = 4500;
+
+      if (!state.started || now_ms - state.wipeStart_ms >= WIPE_MS) {
+        state.started = true;
+        state.wipeStart_ms = now_ms;
+        state.hueOffset += HUE_INCREMENT;
+      }
+
+      const uint8_t previousColorHue = hue + state.hueOffset;
+      const uint8_t currentColorHue = hue + state.hueOffset + HUE_INCREMENT;
+
+      // How much of each LED the new color has covered, and how bright the head is
+      const uint32_t head = (now_ms - state.wipeStart_ms) * FULL_TURN / WIPE_MS;
+      uint8_t coverage[PIXEL_COUNT];
+      Ring::render(
+        [head](const angle_t angle, uint32_t) -> uint8_t {
+          return angle < head ? 0xFF : 0;
+        },
+        now_ms,
+        coverage);
+      uint8_t brightness[PIXEL_COUNT];
+      Ring::render(
+        [head](const angle_t angle, uint32_t) -> uint8_t {
+          const uint8_t brightness = linearTail(behind(head, angle), TAIL_LENGTH * Ring::PIXEL_WIDTH, 0xFF);
+          return brightness > DIMMER ? brightness : DIMMER;
+        },
+        now_ms,
+        brightness);
+
+      for (int i = 0; i < PIXEL_COUNT; ++i) {
+        leds[i] = blend(
+          CRGB(CHSV(previousColorHue, 0xFF, brightness[i])),
+          CRGB(CHSV(currentColorHue, 0xFF, brightness[i])),
+          coverage[i]);
+      }
+      return 20;
+    }
+
+  protected:
+    void restart() override {
+      state.started = false;
+      state.wipeStart_ms = 0;
+      state.hueOffset = 0;
+    }
+
+  private:
+    typedef PolarRing<PIXEL_COUNT> Ring;
+
+    struct State {
+      bool started;
+      uint32_t wipeStart_ms;
+      uint8_t hueOffset;
+    };
+    State state;
+};
+
+
+template <int PIXEL_COUNT>
+class FadingSparks : public Animation {
+  public:
+    FadingSparks() : state() {}
+
+    uint16_t draw(uint8_t, uint32_t, CRGB* const leds) override {
+      // Like random sparks, but they fade in and out.
+      // Start with some zeroes so that we don't relight a pixel immediately.
+      static const uint8_t rippleBrightnesses[] = {0, 0, 0, 0, 0, 0, 4, 8, 16, 32, 48, 64, 96, 128, 160, 192, 192, 192, 192};
+
+      // So we pick a random LED to start making brighter
+      const uint8_t led = rng.below(PIXEL_COUNT);
+      if (!state.increasing[led]) {
+        state.increasing[led] = true;
+        state.hues[led] = state.sparkHue;
+      }
+      state.sparkHue += 3;
+
+      for (int i = 0; i < PIXEL_COUNT; ++i) {
+        if (state.increasing[i]) {
+          if (state.brightnessIndexes[i] < static_cast<int>(COUNT_OF(rippleBrightnesses)) - 1) {
+            ++state.brightnessIndexes[i];
+          } else {
+            state.increasing[i] = false;
+          }
+          leds[i] = CHSV(state.hues[i], 0xFF, rippleBrightnesses[state.brightnessIndexes[i]]);
+        } else if (state.brightnessIndexes[i] > 0) {
+          --state.brightnessIndexes[i];
+          leds[i] = CHSV(state.hues[i], 0xFF, rippleBrightnesses[state.brightnessIndexes[i]]);
+        }
+      }
+      return 100;
+    }
+
+  protected:
+    void restart() override {
+      state = State();
+    }
+
+  private:
+    struct State {
+      bool increasing[PIXEL_COUNT];
+      int8_t brightnessIndexes[PIXEL_COUNT];
+      // Let's keep them the same color that they started with
+      uint8_t hues[PIXEL_COUNT];
+      // Let's use our own sparkHue so that we can change the pixels more quickly
+      uint8_t sparkHue;
+    };
+    State state;
+};
+
+
+template <int PIXEL_COUNT>
+class RainbowSwirl : public Animation {
+  public:
+    RainbowSwirl() : state() {}
+
+    uint16_t draw(uint8_t, const uint32_t now_ms, CRGB* const leds) override {
+      const int SWIRL_LENGTH = 6;
+      const uint32_t SWIRL_PERIOD_MS = 1800;
+
+      // Make 2 swirls on opposite sides
+      const angle_t head = spinAngle(now_ms, SWIRL_PERIOD_MS);
+      uint8_t swirl1[PIXEL_COUNT];
+      uint8_t swirl2[PIXEL_COUNT];
+      const auto shader = [](const angle_t head, const angle_t angle) -> uint8_t {
+        const uint8_t brightness = linearTail(behind(head, angle), SWIRL_LENGTH * Ring::PIXEL_WIDTH, 240);
+        // Don't fade all the way out, so that the tail ends sharply like it used to
+        return brightness == 0 ? 0 : brightness > 30 ? brightness : 30;
+      };
+      Ring::render(
+        [head, &shader](const angle_t angle, uint32_t) { return shader(head, angle); },
+        0,
+        swirl1);
+      Ring::render(
+        [head, &shader](const angle_t angle, uint32_t) { return shader(head + FULL_TURN / 2, angle); },
+        0,
+        swirl2);
+
+      for (int i = 0; i < PIXEL_COUNT; ++i) {
+        leds[i] = CHSV(state.hue, 0xFF, swirl1[i]);
+        leds[i] += CHSV(state.hue + 0x80, 0xFF, swirl2[i]);
+      }
+      ++state.hue;
+      return 20;
+    }
+
+  protected:
+    void restart() override {
+      state.hue = 0;
+    }
+
+  private:
+    typedef PolarRing<PIXEL_COUNT> Ring;
+
+    struct State {
+      uint8_t hue;
+    };
+    State state;
+};
+
+
+template <int PIXEL_COUNT>
+class Shimmer : public Animation {
+  public:
+    Shimmer() : state() {}
+
+    uint16_t draw(const uint8_t hue, uint32_t, CRGB* const leds) override {
+      for (int i = 0; i < 4; ++i) {
+        const uint8_t pixel = rng.below(PIXEL_COUNT);
+        uint8_t& value = state.values[pixel];
+        if (rng.below(2) == 1) {
+          if (value < COUNT_OF(BRIGHTNESSES) - 1) {
+            ++value;
+          } else {
+            --value;
+          }
+        } else {
+          if (value > 0) {
+            --value;
+          } else {
+            ++value;
+          }
+        }
+      }
+
+      for (int i = 0; i < PIXEL_COUNT; ++i) {
+        leds[i] = CHSV(hue, 0xFF, BRIGHTNESSES[state.values[i]]);
+      }
+      return 20;
+    }
+
+  protected:
+    void restart() override {
+      for (auto& value : state.values) {
+        value = COUNT_OF(BRIGHTNESSES) / 2;
+      }
+    }
+
+  private:
+    // Start above 0 so that each light should be on a bit
+    static constexpr uint8_t BRIGHTNESSES[] = {4, 8, 16, 32, 64, 96, 128};
+
+    struct State {
+      // Indexes into BRIGHTNESSES
+      uint8_t values[PIXEL_COUNT];
+    };
+    State state;
+};
+
+template <int PIXEL_COUNT>
+constexpr uint8_t Shimmer<PIXEL_COUNT>::BRIGHTNESSES[];
+
+
+template <int PIXEL_COUNT>
+class PacMan : public Animation {
+  public:
+    PacMan() : state() {}
+
+    uint16_t draw(uint8_t, uint32_t, CRGB* const leds) override {
+      const uint8_t powerPillPosition = PIXEL_COUNT - 1;
+      const CRGB::HTMLColorCode ghostColors[GHOST_COUNT] = {CRGB::Red, CRGB::Orange, CRGB::Pink, CRGB::Teal};
+
+      // Redraw
+      fill_solid(leds, PIXEL_COUNT, CRGB::Black);
+      if (state.state == PacManState::RUNNING) {
+        leds[powerPillPosition] = CRGB::White;
+      }
+      for (uint8_t i = 0; i < GHOST_COUNT; ++i) {
+        if (state.ghostAlive[i]) {
+          auto ghostColor = CRGB::Black;
+          switch (state.state) {
+            case PacManState::RUNNING:
+              ghostColor = ghostColors[i];
+              break;
+            case PacManState::CHASING_WHITE:
+              ghostColor = CRGB::White;
+              break;
+            case PacManState::CHASING_BLUE:
+              ghostColor = CRGB::Blue;
+              break;
+          }
+          // The ghosts trail behind each other, and can be off the start of the strip
+          const uint8_t position = state.ghostPosition - (i * 2);
+          if (position > 0 && position < PIXEL_COUNT) {
+            leds[position] = ghostColor;
+          }
+        }
+      }
+      // Draw Pac-Man last, in case he's on top of something
+      leds[state.pacManPosition] = CRGB::Yellow;
+
+      switch (state.state) {
+        case PacManState::RUNNING:
+          if (state.pacManPosition == powerPillPosition) {
+            state.state = PacManState::CHASING_BLUE;
+          } else {
+            ++state.pacManPosition;
+            ++state.ghostPosition;
+          }
+          break;
+        case PacManState::CHASING_BLUE:
+          --state.pacManPosition;
+          for (uint8_t i = 0; i < GHOST_COUNT; ++i) {
+            const uint8_t thisGhost = state.ghostPosition - (i * 2);
+            if (state.pacManPosition == thisGhost) {
+              state.ghostAlive[i] = false;
+              break;
+            }
+          }
+          state.state = PacManState::CHASING_WHITE;
+          break;
+        case PacManState::CHASING_WHITE:
+          --state.pacManPosition;
+          --state.ghostPosition;
+          state.state = PacManState::CHASING_BLUE;
+          break;
+      }
+      // Once we enter the CHASING states, we never leave (until reset) so just
+      // have Pac-Man spin in circles
+      if (state.pacManPosition >= PIXEL_COUNT) {
+        state.pacManPosition = PIXEL_COUNT - 1;
+      }
+      return 150;
+    }
+
+  protected:
+    void restart() override {
+      state.state = PacManState::RUNNING;
+      state.pacManPosition = 20;
+      state.ghostPosition = state.pacManPosition - 5;
+      for (auto& alive : state.ghostAlive) {
+        alive = true;
+      }
+    }
+
+  private:
+    static const int GHOST_COUNT = 4;
+
+    enum class PacManState : uint8_t {
+      RUNNING,
+      CHASING_BLUE,
+      CHASING_WHITE,
+    };
+
+    struct State {
+      PacManState state;
+      uint8_t pacManPosition;
+      uint8_t ghostPosition;
+      bool ghostAlive[GHOST_COUNT];
+    };
+    State state;
+};
+
+
+template <int PIXEL_COUNT>
+class FourInchWorms : public Animation {
+  public:
+    FourInchWorms() : state() {}
+
+    uint16_t draw(const uint8_t hue, uint32_t, CRGB* const leds) override {
+      // This kind of sucks, because LED_COUNT isn't divisible by 4 :(
+      static const uint8_t lengthToBrightness[] = {0, 255, 200, 150, 120, 100, 80, 70, 60, 50, 40};
+      static_assert(PIXEL_COUNT / 4 <= COUNT_OF(lengthToBrightness), "Add more brightnesses");
+      const CRGB color = CHSV(hue, 0xFF, lengthToBrightness[state.length]);
+
+      fill_solid(leds, PIXEL_COUNT, CRGB::Black);
+      // Each worm stretches out from the start of its quarter, and then pulls
+      // its tail up to its head
+      const int WORM_SPACE = PIXEL_COUNT / 4;
+      for (int i = 0; i < 4; ++i) {
+        const int start = i * WORM_SPACE + (state.stretching ? 0 : WORM_SPACE - 1 - state.length);
+        for (int j = 0; j < state.length; ++j) {
+          leds[start + j] = color;
+        }
+      }
+
+      if (state.stretching) {
+        ++state.length;
+        if (state.length == WORM_SPACE) {
+          state.stretching = false;
+          --state.length;
+          // Pause at full stretch
+          return 400;
+        }
+      } else {
+        --state.length;
+        if (state.length == 0) {
+          state.stretching = true;
+          ++state.length;
+        }
+      }
+      return 200;
+    }
+
+  protected:
+    void restart() override {
+      state.stretching = true;
+      state.length = 1;
+    }
+
+  private:
+    struct State {
+      bool stretching;
+      uint8_t length;
+    };
+    State state;
+};
+
+#endif  // ANIMATIONS_HPP
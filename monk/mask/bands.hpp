@@ -0,0 +1,185 @@
+// Generated from python3 bands.py 128 5000 45, don't edit
+#ifndef BANDS_HPP
+#define BANDS_HPP
+
+#include <cstdint>
+
+// Maps FFT bins onto logarithmically spaced bands, so that each octave
+// gets the same number of LEDs. Bins that straddle 2 bands are split
+// between them by how much they overlap, so each band is a short dot
+// product over BAND_WEIGHTS.
+
+static const int BAND_SAMPLE_COUNT = 128;
+static const int BAND_SAMPLING_FREQUENCY_HZ = 5000;
+static const int BAND_COUNT = 45;
+static const int BAND_WEIGHT_BITS = 15;
+
+struct Band {
+  uint8_t firstBin;
+  uint8_t binCount;
+  uint16_t weightOffset;
+};
+
+static const Band BANDS[BAND_COUNT] = {
+  {2, 1, 0},  // 80-86 Hz
+  {2, 1, 1},  // 86-93 Hz
+  {2, 2, 2},  // 93-101 Hz
+  {3, 1, 4},  // 101-109 Hz
+  {3, 1, 5},  // 109-117 Hz
+  {3, 1, 6},  // 117-126 Hz
+  {3, 1, 7},  // 126-136 Hz
+  {4, 1, 8},  // 136-147 Hz
+  {4, 1, 9},  // 147-159 Hz
+  {4, 1, 10},  // 159-172 Hz
+  {4, 2, 11},  // 172-185 Hz
+  {5, 1, 13},  // 185-200 Hz
+  {5, 2, 14},  // 200-216 Hz
+  {6, 1, 16},  // 216-233 Hz
+  {6, 1, 17},  // 233-251 Hz
+  {6, 2, 18},  // 251-271 Hz
+  {7, 1, 20},  // 271-293 Hz
+  {8, 1, 21},  // 293-316 Hz
+  {8, 2, 22},  // 316-341 Hz
+  {9, 1, 24},  // 341-368 Hz
+  {9, 2, 25},  // 368-397 Hz
+  {10, 2, 27},  // 397-429 Hz
+  {11, 2, 29},  // 429-463 Hz
+  {12, 2, 31},  // 463-499 Hz
+  {13, 2, 33},  // 499-539 Hz
+  {14, 2, 35},  // 539-582 Hz
+  {15, 2, 37},  // 582-628 Hz
+  {16, 2, 39},  // 628-678 Hz
+  {17, 3, 41},  // 678-732 Hz
+  {19, 2, 44},  // 732-790 Hz
+  {20, 3, 46},  // 790-852 Hz
+  {22, 3, 49},  // 852-920 Hz
+  {24, 2, 52},  // 920-993 Hz
+  {25, 3, 54},  // 993-1071 Hz
+  {27, 4, 57},  // 1071-1156 Hz
+  {30, 3, 61},  // 1156-1248 Hz
+  {32, 3, 64},  // 1248-1347 Hz
+  {34, 4, 67},  // 1347-1454 Hz
+  {37, 4, 71},  // 1454-1569 Hz
+  {40, 4, 75},  // 1569-1694 Hz
+  {43, 5, 79},  // 1694-1828 Hz
+  {47, 4, 84},  // 1828-1973 Hz
+  {51, 5, 88},  // 1973-2129 Hz
+  {55, 5, 93},  // 2129-2298 Hz
+  {59, 5, 98},  // 2298-2480 Hz
+};
+
+static const uint16_t BAND_WEIGHTS[] = {
+  13206,
+  13719,
+  8611, 5642,
+  14807,
+  15383,
+  15981,
+  16603,
+  17063,
+  17920,
+  18617,
+  5940, 13401,
+  20093,
+  19681, 1194,
+  21686,
+  22530,
+  3030, 20376,
+  24317,
+  25153,
+  16805, 9440,
+  27266,
+  2915, 25411,
+  12027, 17401,
+  18371, 12201,
+  22061, 9700,
+  23203, 9794,
+  21895, 12386,
+  18227, 17386,
+  12285, 24714,
+  4146, 27934, 6358,
+  20768, 19165,
+  7434, 25882, 8171,
+  17048, 24913, 1139,
+  22883, 21893,
+  2009, 23082, 21427,
+  1593, 22218, 22218, 2298,
+  19175, 21386, 9646,
+  11301, 20586, 20273,
+  300, 19815, 19815, 14258,
+  5349, 19073, 19073, 12801,
+  6037, 18359, 18359, 15731,
+  2530, 17672, 17672, 17672, 5216,
+  11999, 17024, 17024, 17024,
+  16273, 16373, 16373, 16373, 187,
+  15581, 15760, 15760, 15760, 5269,
+  10099, 15170, 15170, 15170, 15170,
+};
+
+// How loud each band sounds, from the A-weighting curve at the middle of
+// the band, scaled so that the loudest is just under 1 << BAND_WEIGHT_BITS
+static const uint16_t BAND_LOUDNESS[BAND_COUNT] = {
+  2297,  // -21.8 dB at 83 Hz
+  2615,  // -20.7 dB at 90 Hz
+  2966,  // -19.6 dB at 97 Hz
+  3350,  // -18.5 dB at 104 Hz
+  3769,  // -17.5 dB at 113 Hz
+  4224,  // -16.5 dB at 122 Hz
+  4716,  // -15.6 dB at 131 Hz
+  5246,  // -14.6 dB at 142 Hz
+  5814,  // -13.8 dB at 153 Hz
+  6422,  // -12.9 dB at 165 Hz
+  7070,  // -12.1 dB at 178 Hz
+  7758,  // -11.2 dB at 192 Hz
+  8488,  // -10.5 dB at 208 Hz
+  9258,  // -9.7 dB at 224 Hz
+  10069,  // -9.0 dB at 242 Hz
+  10920,  // -8.3 dB at 261 Hz
+  11811,  // -7.6 dB at 282 Hz
+  12740,  // -6.9 dB at 304 Hz
+  13705,  // -6.3 dB at 328 Hz
+  14702,  // -5.7 dB at 354 Hz
+  15728,  // -5.1 dB at 382 Hz
+  16778,  // -4.5 dB at 413 Hz
+  17846,  // -4.0 dB at 445 Hz
+  18927,  // -3.5 dB at 481 Hz
+  20011,  // -3.0 dB at 519 Hz
+  21092,  // -2.6 dB at 560 Hz
+  22161,  // -2.1 dB at 604 Hz
+  23209,  // -1.7 dB at 652 Hz
+  24227,  // -1.4 dB at 704 Hz
+  25208,  // -1.0 dB at 760 Hz
+  26143,  // -0.7 dB at 820 Hz
+  27027,  // -0.4 dB at 885 Hz
+  27854,  // -0.1 dB at 956 Hz
+  28620,  // 0.1 dB at 1031 Hz
+  29321,  // 0.3 dB at 1113 Hz
+  29956,  // 0.5 dB at 1201 Hz
+  30525,  // 0.7 dB at 1297 Hz
+  31026,  // 0.8 dB at 1399 Hz
+  31462,  // 0.9 dB at 1510 Hz
+  31833,  // 1.0 dB at 1630 Hz
+  32141,  // 1.1 dB at 1760 Hz
+  32387,  // 1.2 dB at 1899 Hz
+  32573,  // 1.2 dB at 2050 Hz
+  32699,  // 1.2 dB at 2212 Hz
+  32767,  // 1.3 dB at 2388 Hz
+};
+
+// Combines the magnitudes of the first BAND_SAMPLE_COUNT / 2 bins from an FFT
+// into BAND_COUNT bands. Magnitudes need to be under 2^15 so that the sums
+// can't overflow.
+inline void mapToBands(const uint16_t* const magnitudes, uint16_t* const bands) {
+  for (int i = 0; i < BAND_COUNT; ++i) {
+    const Band& band = BANDS[i];
+    const uint16_t* const bins = &magnitudes[band.firstBin];
+    const uint16_t* const weights = &BAND_WEIGHTS[band.weightOffset];
+    uint32_t sum = 0;
+    for (int j = 0; j < band.binCount; ++j) {
+      sum += static_cast<uint32_t>(bins[j]) * weights[j];
+    }
+    bands[i] = sum >> BAND_WEIGHT_BITS;
+  }
+}
+
+#endif  // BANDS_HPP
@@ -0,0 +1,200 @@
+#ifndef BUTTON_HPP
+#define BUTTON_HPP
+
+#include <cstdint>
+
+// Button handling that doesn't depend on loop() running often. The pin change
+// interrupt timestamps every edge and restarts a timer, and the timer decides
+// what happened once the pin has settled. Presses end up in a queue, so a
+// press during a slow animation is late instead of lost.
+//
+// The goggles and the monk mask both use this. Arduino won't compile files
+// from outside the sketch directory, so each has a copy; keep them in sync.
+
+enum class ButtonEvent : uint8_t {
+  PRESS,
+  LONG_PRESS,
+  DOUBLE_PRESS,
+};
+
+// Starts watching a button that pulls pin low. This uses TC4 for the timer.
+void startButton(uint8_t pin);
+// Gets the oldest button event. Returns false if there aren't any.
+bool takeButtonEvent(ButtonEvent* event);
+// Whether the button is down, after debouncing
+bool isButtonDown();
+
+
+// Queue that one interrupt pushes into and loop() pops from. Each side only
+// writes its own index, and they're single bytes, so nothing needs to turn
+// interrupts off. SIZE must be a power of 2, and one slot is always empty.
+template <typename T, int SIZE>
+class EventQueue {
+  public:
+    static_assert(SIZE > 1 && SIZE <= 256 && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of 2");
+
+    EventQueue() : events(), head(0), tail(0), drops(0) {}
+
+    // Call this from the interrupt. If loop() hasn't kept up, the event is
+    // dropped.
+    void push(const T event) {
+      const uint8_t next = (head + 1) & (SIZE - 1);
+      if (next == tail) {
+        ++drops;
+        return;
+      }
+      events[head] = event;
+      head = next;
+    }
+
+    bool pop(T* const event) {
+      if (tail == head) {
+        return false;
+      }
+      *event = events[tail];
+      tail = (tail + 1) & (SIZE - 1);
+      return true;
+    }
+
+    // Number of events that didn't fit
+    uint16_t dropCount() const {
+      return drops;
+    }
+
+  private:
+    T events[SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint16_t drops;
+};
+
+
+// Turns edges and timer ticks into button events. This doesn't touch any
+// hardware, so it can be tested on a computer with made up edges. Both
+// callbacks have to run at the same interrupt priority so that they can't
+// interrupt each other.
+class ButtonTracker {
+  public:
+    static const uint16_t DEBOUNCE_MS = 20;
+    static const uint16_t LONG_PRESS_MS = 500;
+    // A second press that starts this soon after the first one ends makes it
+    // a double press. Single presses are reported this much later.
+    static const uint16_t DOUBLE_PRESS_GAP_MS = 250;
+
+    ButtonTracker() :
+      state(State::UP), down(false), lastEdge_ms(0), downTime_ms(0), upTime_ms(0), queue()
+    {}
+
+    // Call this from the pin change interrupt. Returns how many ms until the
+    // timer should call update().
+    uint16_t edge(const uint32_t now_ms) {
+      lastEdge_ms = now_ms;
+      return DEBOUNCE_MS;
+    }
+
+    // Call this from the timer with the current pin level. Returns how many
+    // ms until it should be called again, or 0 if it doesn't need to be.
+    uint16_t update(const bool pinDown, const uint32_t now_ms) {
+      const uint32_t sinceEdge_ms = now_ms - lastEdge_ms;
+      if (pinDown != down) {
+        // Still bouncing. An edge already restarted the timer, but don't
+        // rely on it.
+        if (sinceEdge_ms < DEBOUNCE_MS) {
+          return DEBOUNCE_MS - sinceEdge_ms;
+        }
+        down = pinDown;
+        settle();
+      }
+
+      switch (state) {
+        case State::DOWN:
+          if (now_ms - downTime_ms >= LONG_PRESS_MS) {
+            queue.push(ButtonEvent::LONG_PRESS);
+            state = State::HELD;
+            return 0;
+          }
+          return LONG_PRESS_MS - (now_ms - downTime_ms);
+        case State::WAITING_FOR_SECOND:
+          if (now_ms - upTime_ms >= DOUBLE_PRESS_GAP_MS) {
+            queue.push(ButtonEvent::PRESS);
+            state = State::UP;
+            return 0;
+          }
+          return DOUBLE_PRESS_GAP_MS - (now_ms - upTime_ms);
+        default:
+          return 0;
+      }
+    }
+
+    bool isDown() const {
+      return down;
+    }
+
+    bool take(ButtonEvent* const event) {
+      return queue.pop(event);
+    }
+
+    uint16_t dropCount() const {
+      return queue.dropCount();
+    }
+
+  private:
+    enum class State : uint8_t {
+      UP,
+      DOWN,
+      HELD,  // Long press already reported, waiting for release
+      WAITING_FOR_SECOND,  // Released, might turn into a double press
+      SECOND_DOWN,
+    };
+
+    State state;
+    bool down;
+    uint32_t lastEdge_ms;
+    uint32_t downTime_ms;
+    uint32_t upTime_ms;
+    EventQueue<ButtonEvent, 8> queue;
+
+    // The debounced level just changed. Times are taken from the last edge,
+    // not from when the timer noticed.
+    void settle() {
+      switch (state) {
+        case State::UP:
+          if (down) {
+            state = State::DOWN;
+            downTime_ms = lastEdge_ms;
+          }
+          break;
+        case State::DOWN:
+          if (!down) {
+            state = State::WAITING_FOR_SECOND;
+            upTime_ms = lastEdge_ms;
+          }
+          break;
+        case State::HELD:
+          if (!down) {
+            state = State::UP;
+          }
+          break;
+        case State::WAITING_FOR_SECOND:
+          if (down) {
+            // The timer was late, so the gap already ran out
+            if (lastEdge_ms - upTime_ms >= DOUBLE_PRESS_GAP_MS) {
+              queue.push(ButtonEvent::PRESS);
+              state = State::DOWN;
+              downTime_ms = lastEdge_ms;
+            } else {
+              state = State::SECOND_DOWN;
+            }
+          }
+          break;
+        case State::SECOND_DOWN:
+          if (!down) {
+            queue.push(ButtonEvent::DOUBLE_PRESS);
+            state = State::UP;
+          }
+          break;
+      }
+    }
+};
+
+#endif  // BUTTON_HPP
@@ -0,0 +1,94 @@
+#ifndef FAST_LED_H
+#define FAST_LED_H
+
+// Just enough of FastLED to run the mask animations on a computer. The
+// colors are close to FastLED's rainbow colors but not exact, which is fine
+// for timing and for comparing against earlier runs of the runner.
+
+#include <cstdint>
+
+typedef uint8_t fract8;
+
+inline uint8_t scale8(const uint8_t value, const fract8 scale) {
+  return (static_cast<uint16_t>(value) * (1 + scale)) >> 8;
+}
+
+inline uint8_t qadd8(const uint8_t a, const uint8_t b) {
+  const int sum = a + b;
+  return sum > 255 ? 255 : sum;
+}
+
+struct CHSV {
+  uint8_t h;
+  uint8_t s;
+  uint8_t v;
+
+  CHSV(const uint8_t hue, const uint8_t saturation, const uint8_t value) : h(hue), s(saturation), v(value) {}
+};
+
+struct CRGB {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+
+  enum HTMLColorCode : uint32_t {
+    Black = 0x000000,
+    Blue = 0x0000FF,
+    Orange = 0xFFA500,
+    Pink = 0xFFC0CB,
+    Red = 0xFF0000,
+    Teal = 0x008080,
+    White = 0xFFFFFF,
+    Yellow = 0xFFFF00,
+  };
+
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(const uint8_t red, const uint8_t green, const uint8_t blue) : r(red), g(green), b(blue) {}
+  CRGB(const uint32_t code) : r(code >> 16), g(code >> 8), b(code) {}
+  CRGB(const HTMLColorCode code) : CRGB(static_cast<uint32_t>(code)) {}
+
+  // FastLED's rainbow has 8 sections of 32 hues, with more room for yellow
+  // than a plain HSV spectrum
+  CRGB(const CHSV& hsv) : r(0), g(0), b(0) {
+    const uint8_t offset = (hsv.h & 0x1F) * 8;
+    const uint8_t third = scale8(offset, 85);
+    const uint8_t twoThirds = scale8(offset, 170);
+    switch (hsv.h >> 5) {
+      case 0: r = 255 - third; g = third; break;
+      case 1: r = 171; g = 85 + third; break;
+      case 2: r = 171 - twoThirds; g = 170 + third; break;
+      case 3: g = 255 - third; b = third; break;
+      case 4: g = 171 - twoThirds; b = 85 + twoThirds; break;
+      case 5: r = third; b = 255 - third; break;
+      case 6: r = 85 + third; b = 171 - third; break;
+      default: r = 170 + third; b = 85 - third; break;
+    }
+    // Desaturate toward white, then dim
+    const uint8_t white = 255 - hsv.s;
+    r = scale8(qadd8(scale8(r, hsv.s), white), hsv.v);
+    g = scale8(qadd8(scale8(g, hsv.s), white), hsv.v);
+    b = scale8(qadd8(scale8(b, hsv.s), white), hsv.v);
+  }
+
+  CRGB& operator+=(const CRGB& other) {
+    r = qadd8(r, other.r);
+    g = qadd8(g, other.g);
+    b = qadd8(b, other.b);
+    return *this;
+  }
+};
+
+inline void fill_solid(CRGB* const leds, const int count, const CRGB& color) {
+  for (int i = 0; i < count; ++i) {
+    leds[i] = color;
+  }
+}
+
+inline CRGB blend(const CRGB& from, const CRGB& to, const fract8 amount) {
+  const auto mix = [amount](const uint8_t a, const uint8_t b) -> uint8_t {
+    return (a * (256 - amount) + b * amount) >> 8;
+  };
+  return CRGB(mix(from.r, to.r), mix(from.g, to.g), mix(from.b, to.b));
+}
+
+#endif  // FAST_LED_H
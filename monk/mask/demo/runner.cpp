@@ -0,0 +1,183 @@
+// Draws the mask animations on a computer, as fast as it can. With no
+// arguments it times every animation. With an animation name it can also
+// write every frame to an image, one row of LEDs per frame, or compare
+// against an image from an earlier run, so I can check that a change didn't
+// change what an animation looks like.
+//
+//     ./runner
+//     ./runner shimmer 1000 --write shimmer.ppm
+//     ./runner shimmer 1000 --compare shimmer.ppm
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+#include "../animations.hpp"
+#include "../constants.hpp"
+
+// Every run starts from the same seed and the same clock, so the frames
+// come out the same every time
+static const uint32_t SEED = 1;
+static const int DEFAULT_FRAME_COUNT = 100000;
+
+static BinaryClock<LED_COUNT> binaryClock;
+static Breathe<LED_COUNT> breathe;
+static CircularWipe<LED_COUNT> circularWipe;
+static FadingSparks<LED_COUNT> fadingSparks;
+static FourInchWorms<LED_COUNT> fourInchWorms;
+static PacMan<LED_COUNT> pacMan;
+static RainbowSwirl<LED_COUNT> rainbowSwirl;
+static Shimmer<LED_COUNT> shimmer;
+
+struct NamedAnimation {
+  const char* name;
+  Animation* animation;
+  size_t size;
+};
+
+static const NamedAnimation ANIMATIONS[] = {
+  {"binaryClock", &binaryClock, sizeof(binaryClock)},
+  {"breathe", &breathe, sizeof(breathe)},
+  {"circularWipe", &circularWipe, sizeof(circularWipe)},
+  {"fadingSparks", &fadingSparks, sizeof(fadingSparks)},
+  {"fourInchWorms", &fourInchWorms, sizeof(fourInchWorms)},
+  {"pacMan", &pacMan, sizeof(pacMan)},
+  {"rainbowSwirl", &rainbowSwirl, sizeof(rainbowSwirl)},
+  {"shimmer", &shimmer, sizeof(shimmer)},
+};
+
+
+// Draws frameCount frames with a pretend clock that moves ahead by however
+// long each frame asked to be shown. If frames isn't null, every frame gets
+// appended to it.
+static double run(Animation* const animation, const int frameCount, std::vector<uint8_t>* const frames) {
+  CRGB leds[LED_COUNT];
+  animation->reset(SEED);
+  uint32_t now_ms = 0;
+  uint8_t hue = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frameCount; ++frame) {
+    const uint16_t delay_ms = animation->draw(hue, now_ms, leds);
+    // The mask moves the hue every 100 ms
+    hue = now_ms / 100;
+    now_ms += delay_ms == 0 ? 1 : delay_ms;
+    if (frames != nullptr) {
+      for (const auto& led : leds) {
+        frames->push_back(led.r);
+        frames->push_back(led.g);
+        frames->push_back(led.b);
+      }
+    }
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+
+static bool writeImage(const char* const path, const std::vector<uint8_t>& frames, const int frameCount) {
+  FILE* const file = fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  fprintf(file, "P6\n%d %d\n255\n", LED_COUNT, frameCount);
+  const bool wrote = fwrite(frames.data(), 1, frames.size(), file) == frames.size();
+  return fclose(file) == 0 && wrote;
+}
+
+
+static bool readImage(const char* const path, std::vector<uint8_t>* const frames, int* const frameCount) {
+  FILE* const file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  int width = 0;
+  int maximum = 0;
+  bool read = fscanf(file, "P6 %d %d %d", &width, frameCount, &maximum) == 3 && fgetc(file) == '\n';
+  read = read && width == LED_COUNT && maximum == 255 && *frameCount > 0;
+  if (read) {
+    frames->resize(static_cast<size_t>(width) * *frameCount * 3);
+    read = fread(frames->data(), 1, frames->size(), file) == frames->size();
+  }
+  fclose(file);
+  return read;
+}
+
+
+int main(int argc, char* argv[]) {
+  if (argc == 1) {
+    printf("%-14s %6s %12s\n", "animation", "bytes", "frames/s");
+    for (const auto& named : ANIMATIONS) {
+      const double seconds = run(named.animation, DEFAULT_FRAME_COUNT, nullptr);
+      printf("%-14s %6zu %12.0f\n", named.name, named.size, DEFAULT_FRAME_COUNT / seconds);
+    }
+    return 0;
+  }
+
+  const NamedAnimation* named = nullptr;
+  for (const auto& candidate : ANIMATIONS) {
+    if (strcmp(candidate.name, argv[1]) == 0) {
+      named = &candidate;
+    }
+  }
+  if (named == nullptr || (argc != 3 && argc != 5)) {
+    fprintf(stderr, "Usage: %s [animation frames [--write|--compare image.ppm]]\n", argv[0]);
+    fprintf(stderr, "Animations:");
+    for (const auto& candidate : ANIMATIONS) {
+      fprintf(stderr, " %s", candidate.name);
+    }
+    fprintf(stderr, "\n");
+    return 1;
+  }
+  const int frameCount = atoi(argv[2]);
+  if (frameCount <= 0) {
+    fprintf(stderr, "frames needs to be more than 0\n");
+    return 1;
+  }
+
+  std::vector<uint8_t> frames;
+  frames.reserve(static_cast<size_t>(frameCount) * LED_COUNT * 3);
+  const double seconds = run(named->animation, frameCount, &frames);
+  printf("%s: %d frames, %.0f frames/s\n", named->name, frameCount, frameCount / seconds);
+  if (argc == 3) {
+    return 0;
+  }
+
+  const std::string option = argv[3];
+  const char* const path = argv[4];
+  if (option == "--write") {
+    if (!writeImage(path, frames, frameCount)) {
+      fprintf(stderr, "Couldn't write %s\n", path);
+      return 1;
+    }
+    return 0;
+  }
+  if (option != "--compare") {
+    fprintf(stderr, "Unknown option %s\n", option.c_str());
+    return 1;
+  }
+
+  std::vector<uint8_t> expected;
+  int expectedFrameCount = 0;
+  if (!readImage(path, &expected, &expectedFrameCount)) {
+    fprintf(stderr, "Couldn't read %s\n", path);
+    return 1;
+  }
+  if (expectedFrameCount != frameCount) {
+    fprintf(stderr, "%s has %d frames, not %d\n", path, expectedFrameCount, frameCount);
+    return 1;
+  }
+  const int frameBytes = LED_COUNT * 3;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (frames[i] != expected[i]) {
+      fprintf(stderr, "Frame %zu LED %zu is different\n", i / frameBytes, i % frameBytes / 3);
+      return 1;
+    }
+  }
+  printf("Matches %s\n", path);
+  return 0;
+}
@@ -0,0 +1,139 @@
+// Drives SampleBlocks from a pretend ADC to check the handoff between the
+// sampler interrupt and loop(): push() says when a block is done, take()
+// always gets the newest block, a taken block isn't touched until the other
+// one fills, and dropped blocks are counted. Exits with 1 if anything's off.
+//
+//     ./sampler
+
+#include <cstdint>
+#include <cstdio>
+
+#include "../sampler.hpp"
+
+// Same as the spectrum analyzer
+static const int BLOCK_SIZE = 64;
+static const int SEED_COUNT = 100;
+static const int TAKES_PER_SEED = 2000;
+
+typedef SampleBlocks<int16_t, BLOCK_SIZE> Blocks;
+
+static int failures = 0;
+
+static void check(const bool ok, const char* const message, const long value) {
+  if (!ok) {
+    printf("%s (%ld)\n", message, value);
+    ++failures;
+  }
+}
+
+// The pretend ADC reads a 10-bit ramp, so each sample says when it was taken
+static int16_t reading(const long index) {
+  return index & 0x3FF;
+}
+
+static uint32_t randomState = 1;
+
+static uint32_t random32() {
+  randomState = randomState * 1103515245 + 12345;
+  return randomState >> 8;
+}
+
+// Checks that block holds the BLOCK_SIZE samples ending with sample last
+static bool holds(const int16_t* const block, const long last) {
+  for (int i = 0; i < BLOCK_SIZE; ++i) {
+    if (block[i] != reading(last - BLOCK_SIZE + 1 + i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// push() returns true exactly when a block is done, and a loop that keeps up
+// gets every block in order
+static void keepingUp() {
+  Blocks blocks;
+  long pushed = 0;
+  check(blocks.take() == nullptr, "Got a block before any samples", 0);
+  for (int block = 0; block < 100; ++block) {
+    for (int i = 0; i < BLOCK_SIZE; ++i) {
+      const bool finished = blocks.push(reading(pushed));
+      ++pushed;
+      check(finished == (i == BLOCK_SIZE - 1), "push() was wrong about finishing a block", pushed);
+      if (i < BLOCK_SIZE - 1) {
+        check(blocks.take() == nullptr, "Got a block before it was finished", pushed);
+      }
+    }
+    const int16_t* const taken = blocks.take();
+    check(taken != nullptr, "Didn't get a finished block", pushed);
+    if (taken != nullptr) {
+      check(holds(taken, pushed - 1), "Block had the wrong samples", pushed);
+    }
+    check(blocks.take() == nullptr, "Got the same block twice", pushed);
+  }
+  check(blocks.overrunCount() == 0, "Counted overruns when loop() kept up", blocks.overrunCount());
+}
+
+
+// A taken block stays put while the interrupt fills the other one, and the
+// very next sample after that overwrites it
+static void validity() {
+  Blocks blocks;
+  long pushed = 0;
+  for (int i = 0; i < BLOCK_SIZE; ++i) {
+    blocks.push(reading(pushed++));
+  }
+  const int16_t* const taken = blocks.take();
+  const long last = pushed - 1;
+  for (int i = 0; i < BLOCK_SIZE; ++i) {
+    blocks.push(reading(pushed++));
+    check(holds(taken, last), "Taken block changed while the other block was filling", i);
+  }
+  blocks.push(reading(pushed++));
+  check(!holds(taken, last), "Taken block wasn't reused after the other block filled", pushed);
+}
+
+
+// A loop() that takes a random number of sample periods each pass, like when
+// FastLED.show() holds things up. Every take() should get the newest block,
+// and every finished block is either taken or counted as an overrun.
+static void randomLoop(const int seed) {
+  randomState = seed + 1;
+  Blocks blocks;
+  long pushed = 0;
+  long finished = 0;
+  long taken = 0;
+  for (int i = 0; i < TAKES_PER_SEED; ++i) {
+    // Mostly under a block, sometimes a few blocks
+    const long samples = random32() % 4 == 0 ? random32() % (BLOCK_SIZE * 4) : random32() % BLOCK_SIZE;
+    for (long j = 0; j < samples; ++j) {
+      if (blocks.push(reading(pushed))) {
+        ++finished;
+      }
+      ++pushed;
+    }
+    const long newest = pushed / BLOCK_SIZE * BLOCK_SIZE - 1;
+    const int16_t* const block = blocks.take();
+    if (block == nullptr) {
+      check(finished == taken + blocks.overrunCount(), "No block, but one was waiting", seed);
+      continue;
+    }
+    ++taken;
+    check(finished == pushed / BLOCK_SIZE, "push() missed a finished block", seed);
+    check(holds(block, newest), "Didn't get the newest block", seed);
+    check(finished == taken + blocks.overrunCount(), "Dropped a block without counting it", seed);
+  }
+}
+
+
+int main() {
+  keepingUp();
+  validity();
+  for (int seed = 0; seed < SEED_COUNT; ++seed) {
+    randomLoop(seed);
+  }
+  if (failures == 0) {
+    printf("Every block was handed off or counted\n");
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#ifndef FIXED_FFT_HPP
+#define FIXED_FFT_HPP
+
+#include <cmath>
+#include <cstdint>
+
+// Integer FFT for the spectrum analyzers. The M0 doesn't have an FPU, so
+// arduinoFFT spent most of its time in software floating point. This keeps
+// everything in Q15, looks the twiddle factors and the Hamming window up from
+// tables, and approximates the magnitudes instead of calling sqrt.
+//
+// Each stage halves the values so nothing can overflow, so the output is the
+// FFT of the ADC readings times 16 / SAMPLE_COUNT. A full scale sine wave
+// comes out at about 2100.
+//
+// The goggles and the monk mask both use this. Arduino won't compile files
+// from outside the sketch directory, so each has a copy; keep them in sync.
+template <int SAMPLE_COUNT>
+class FixedFft {
+  public:
+    static_assert(SAMPLE_COUNT >= 4 && (SAMPLE_COUNT & (SAMPLE_COUNT - 1)) == 0, "SAMPLE_COUNT must be a power of 2");
+    static_assert(SAMPLE_COUNT <= 1024, "Indexes are 16 bits");
+
+    FixedFft() : real(), imaginary(), sines(), window() {
+      for (int i = 0; i < COUNT_OF_SINES; ++i) {
+        sines[i] = toQ15(sinf(2.0f * static_cast<float>(M_PI) * i / SAMPLE_COUNT));
+      }
+      for (int i = 0; i < SAMPLE_COUNT / 2; ++i) {
+        window[i] = toQ15(0.54f - 0.46f * cosf(2.0f * static_cast<float>(M_PI) * i / (SAMPLE_COUNT - 1)));
+      }
+    }
+
+    // Windows a block of raw 10-bit ADC readings, transforms it, and writes
+    // the magnitudes of the first SAMPLE_COUNT / 2 bins to output
+    void magnitudes(const int16_t* const samples, uint16_t* const output) {
+      // Remove the DC offset first, otherwise window leakage from it covers
+      // up the bass bins
+      int32_t sum = 0;
+      for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        sum += samples[i];
+      }
+      const int16_t mean = sum / SAMPLE_COUNT;
+      // Every stage loses a bit, so scale quiet blocks up as far as they'll go
+      // and scale the results back down at the end
+      int16_t largest = 1;
+      for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        const int16_t centered = samples[i] - mean;
+        const int16_t absolute = centered < 0 ? -centered : centered;
+        largest = absolute > largest ? absolute : largest;
+      }
+      int shift = MINIMUM_SHIFT;
+      while ((largest << (shift + 1)) <= MAXIMUM_INPUT) {
+        ++shift;
+      }
+      for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        const int i2 = i < SAMPLE_COUNT / 2 ? i : SAMPLE_COUNT - 1 - i;
+        // Multiply rather than shift, because shifting a negative number left
+        // is undefined before C++20
+        const int16_t centered = (samples[i] - mean) * (1 << shift);
+        real[reverseBits(i)] = multiply(centered, window[i2]);
+      }
+      for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        imaginary[i] = 0;
+      }
+
+      transform();
+
+      const int extraShift = shift - MINIMUM_SHIFT;
+      const uint16_t round = (1 << extraShift) >> 1;
+      for (int i = 0; i < SAMPLE_COUNT / 2; ++i) {
+        output[i] = (approximateMagnitude(real[i], imaginary[i]) + round) >> extraShift;
+      }
+    }
+
+  private:
+    // 10-bit readings with the offset removed fit in 11 bits, so they can
+    // always be shifted up at least this much. The output is always scaled
+    // as if they were shifted by exactly this much.
+    static const int MINIMUM_SHIFT = 4;
+    // Leave a bit of headroom so that rounding can't overflow
+    static const int16_t MAXIMUM_INPUT = 16383;
+    // sin for a full cycle plus a quarter, so cos(x) = sin(x + quarter)
+    static const int COUNT_OF_SINES = SAMPLE_COUNT / 2 + SAMPLE_COUNT / 4;
+
+    int16_t real[SAMPLE_COUNT];
+    int16_t imaginary[SAMPLE_COUNT];
+    int16_t sines[COUNT_OF_SINES];
+    // The window is symmetric, so only store half of it
+    int16_t window[SAMPLE_COUNT / 2];
+
+    static int16_t toQ15(const float value) {
+      const long rounded = lroundf(value * 32768.0f);
+      return rounded > 32767 ? 32767 : rounded;
+    }
+
+    static int16_t multiply(const int16_t a, const int16_t b) {
+      return (static_cast<int32_t>(a) * b) >> 15;
+    }
+
+    static uint16_t reverseBits(uint16_t index) {
+      uint16_t reversed = 0;
+      for (int bit = 1; bit < SAMPLE_COUNT; bit <<= 1) {
+        reversed = (reversed << 1) | (index & 1);
+        index >>= 1;
+      }
+      return reversed;
+    }
+
+    // Radix 2 decimation in time. The input is already in bit reversed order.
+    void transform() {
+      for (int size = 2; size <= SAMPLE_COUNT; size <<= 1) {
+        const int half = size / 2;
+        const int step = SAMPLE_COUNT / size;
+        for (int k = 0; k < half; ++k) {
+          // e^(-i*theta) = cos(theta) - i*sin(theta)
+          const int16_t wReal = sines[k * step + SAMPLE_COUNT / 4];
+          const int16_t wImaginary = -sines[k * step];
+          for (int start = k; start < SAMPLE_COUNT; start += size) {
+            const int odd = start + half;
+            const int32_t tReal =
+              (static_cast<int32_t>(real[odd]) * wReal - static_cast<int32_t>(imaginary[odd]) * wImaginary) >> 15;
+            const int32_t tImaginary =
+              (static_cast<int32_t>(real[odd]) * wImaginary + static_cast<int32_t>(imaginary[odd]) * wReal) >> 15;
+            const int32_t evenReal = real[start];
+            const int32_t evenImaginary = imaginary[start];
+            real[start] = (evenReal + tReal) >> 1;
+            imaginary[start] = (evenImaginary + tImaginary) >> 1;
+            real[odd] = (evenReal - tReal) >> 1;
+            imaginary[odd] = (evenImaginary - tImaginary) >> 1;
+          }
+        }
+      }
+    }
+
+    // Alpha max plus beta min, within 4% of sqrt(re^2 + im^2)
+    static uint16_t approximateMagnitude(const int32_t re, const int32_t im) {
+      const uint32_t a = re < 0 ? -re : re;
+      const uint32_t b = im < 0 ? -im : im;
+      const uint32_t larger = a > b ? a : b;
+      const uint32_t smaller = a > b ? b : a;
+      return (larger * 123 + smaller * 51) >> 7;
+    }
+};
+
+#endif  // FIXED_FFT_HPP
@@ -1,7 +1,10 @@
 #include <Adafruit_DotStar.h>
 #include <FastLED.h>
 
+#include "animations.hpp"
+#include "button.hpp"
 #include "constants.hpp"
+#include "spectrumAnalyzer.hpp"
 
 // Constants
 static const int LED_PIN = 2;
@@ -9,28 +12,14 @@ static const int BUTTON_PIN = 1;
 static const int ONBOARD_LED_PIN = 13;
 static const int INITIAL_BRIGHTNESS = 100;
 static const int MILLIS_PER_HUE = 100;
-
-// Function declarations
-void setButtonDownState();
-
-// State machine for button presses
-enum class ButtonState_t {
-  UP,
-  DEBOUNCE_DOWN,
-  DOWN,
-  LONG_BUTTON_PRESS,
-  BUTTON_PRESS,
-  AFTER_BUTTON_PRESS,
-};
+// Set this to print how fast the spectrum analyzer is going
+static const bool DEBUG_SPECTRUM_ANALYZER = false;
+static const int DEBUG_INTERVAL_MS = 5000;
 
 // Static global variables
 static Adafruit_DotStar internalPixel = Adafruit_DotStar(1, INTERNAL_DS_DATA, INTERNAL_DS_CLK, DOTSTAR_BGR);
-static decltype(millis()) buttonDownTime = 0;
-static ButtonState_t buttonState = ButtonState_t::UP;
-static bool buttonDown = false;
 
 // Non-static global variables
-bool reset = true;  // Indicates that an animation should clear its state
 CRGB leds[LED_COUNT];
 
 
@@ -44,10 +33,9 @@ void setup() {
   analogReference(AR_DEFAULT);
   pinMode(MICROPHONE_ANALOG_PIN, INPUT);
   pinMode(LED_PIN, OUTPUT);
-  pinMode(BUTTON_PIN, INPUT_PULLUP);
   pinMode(ONBOARD_LED_PIN, OUTPUT);
 
-  attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), setButtonDownState, CHANGE);
+  startButton(BUTTON_PIN);
 
   internalPixel.begin();
   internalPixel.setBrightness(5);
@@ -69,33 +57,31 @@ void setup() {
 }
 
 
-typedef void (*animationFunction_t)(uint8_t hue);
-// Static animations
-#define ANIM(name) void name(uint8_t hue)
-ANIM(binaryClock);
-ANIM(breathe);
-ANIM(circularWipe);
-ANIM(fadingSparks);
-ANIM(pacMan);
-ANIM(rainbowSwirl);
-ANIM(shimmer);
-ANIM(spectrumAnalyzer);
-
-
-// Each animationFunction_t[] should end in nullptr
-constexpr animationFunction_t ANIMATIONS[] = {
-  breathe,
-  //binaryClock,
-  circularWipe,
-  fadingSparks,
-  //pacMan,
-  rainbowSwirl,
-  shimmer,
-  spectrumAnalyzer
+// Static animations. These all live here for the whole time, so switching
+// animations never allocates anything.
+static BinaryClock<LED_COUNT> binaryClock;
+static Breathe<LED_COUNT> breathe;
+static CircularWipe<LED_COUNT> circularWipe;
+static FadingSparks<LED_COUNT> fadingSparks;
+static PacMan<LED_COUNT> pacMan;
+static RainbowSwirl<LED_COUNT> rainbowSwirl;
+static Shimmer<LED_COUNT> shimmer;
+static SpectrumAnalyzer spectrumAnalyzer;
+
+
+constexpr Animation* ANIMATIONS[] = {
+  &breathe,
+  //&binaryClock,
+  &circularWipe,
+  &fadingSparks,
+  //&pacMan,
+  &rainbowSwirl,
+  &shimmer,
+  &spectrumAnalyzer
 };
 
 // Use this for testing a single animation
-//constexpr animationFunction_t ANIMATIONS[] = {pacMan};
+//constexpr Animation* ANIMATIONS[] = {&pacMan};
 
 
 typedef void (*configurationFunction_t)(bool buttonPressed);
@@ -103,41 +89,74 @@ const constexpr configurationFunction_t CONFIGURATION_FUNCTIONS[] = {configureBr
 static_assert(CONFIGURATION_FUNCTIONS[COUNT_OF(CONFIGURATION_FUNCTIONS) - 1] == nullptr, "");
 
 
+// Compare the difference so this still works when millis() wraps
+static bool isDue(const uint32_t now_ms, const uint32_t deadline_ms) {
+  return static_cast<int32_t>(now_ms - deadline_ms) >= 0;
+}
+
+
 void loop() {
   static uint8_t animationsIndex = 0;
   static uint8_t configurationsIndex = COUNT_OF(CONFIGURATION_FUNCTIONS) - 1;
   static uint8_t hue = 0;
   static auto hueChangeTime_ms = millis();
-
-  setButtonDownState();
-  updateButtonState();
-  if (buttonState == ButtonState_t::BUTTON_PRESS) {
-    // If we're not configuring, go to the next animation
-    if (CONFIGURATION_FUNCTIONS[configurationsIndex] == nullptr) {
+  static auto nextFrame_ms = millis();
+  static bool resetAnimation = true;
+
+  // The button interrupts queue up presses, so handle one per pass
+  digitalWrite(ONBOARD_LED_PIN, isButtonDown() ? HIGH : LOW);
+  ButtonEvent buttonEvent;
+  const bool hasButtonEvent = takeButtonEvent(&buttonEvent);
+  if (hasButtonEvent && buttonEvent == ButtonEvent::LONG_PRESS) {
+    ++configurationsIndex;
+    if (configurationsIndex == COUNT_OF(CONFIGURATION_FUNCTIONS)) {
+      configurationsIndex = 0;
+    }
+    fill_solid(&leds[0], LED_COUNT, CRGB::Black);
+  } else if (hasButtonEvent && CONFIGURATION_FUNCTIONS[configurationsIndex] == nullptr) {
+    // If we're not configuring, go to the next animation, or back one for a
+    // double press
+    if (buttonEvent == ButtonEvent::DOUBLE_PRESS) {
+      animationsIndex = (animationsIndex == 0 ? COUNT_OF(ANIMATIONS) : animationsIndex) - 1;
+    } else {
       ++animationsIndex;
       if (animationsIndex == COUNT_OF(ANIMATIONS)) {
         animationsIndex = 0;
       }
-      fill_solid(&leds[0], LED_COUNT, CRGB::Black);
-      reset = true;  // Animation functions need to clear reset (if they care)
-    }
-  } else if (buttonState == ButtonState_t::LONG_BUTTON_PRESS) {
-    ++configurationsIndex;
-    if (configurationsIndex == COUNT_OF(CONFIGURATION_FUNCTIONS)) {
-      configurationsIndex = 0;
     }
     fill_solid(&leds[0], LED_COUNT, CRGB::Black);
+    resetAnimation = true;
+    nextFrame_ms = millis();
   }
 
   if (CONFIGURATION_FUNCTIONS[configurationsIndex] != nullptr) {
-    CONFIGURATION_FUNCTIONS[configurationsIndex](buttonState == ButtonState_t::BUTTON_PRESS);
+    CONFIGURATION_FUNCTIONS[configurationsIndex](hasButtonEvent && buttonEvent == ButtonEvent::PRESS);
   } else {
-    Serial.printf("Doing animation %d\n", animationsIndex);
-    // Do a regular animation
-    ANIMATIONS[animationsIndex](hue);
+    // Do a regular animation. The spectrum analyzer returns right away
+    // until it has new audio, so only show frames that something drew.
+    Animation* const animation = ANIMATIONS[animationsIndex];
+    const auto now_ms = millis();
+    if (resetAnimation) {
+      Serial.printf("Doing animation %d\n", animationsIndex);
+      // Seed from the clock so the random animations don't repeat every time
+      animation->reset(micros());
+      resetAnimation = false;
+    }
+    if (isDue(now_ms, nextFrame_ms)) {
+      const uint16_t delay_ms = animation->draw(hue, now_ms, leds);
+      if (delay_ms != 0) {
+        FastLED.show();
+        if (animation == &spectrumAnalyzer) {
+          spectrumAnalyzerShown();
+        }
+      }
+      nextFrame_ms = now_ms + delay_ms;
+    }
 
     // Update the color
-    const auto now_ms = millis();
+    if (DEBUG_SPECTRUM_ANALYZER && animation == &spectrumAnalyzer) {
+      printSpectrumAnalyzerStats(now_ms);
+    }
     if (now_ms >= hueChangeTime_ms + MILLIS_PER_HUE) {
       hue += (now_ms - hueChangeTime_ms) / MILLIS_PER_HUE;
       hueChangeTime_ms = now_ms;
@@ -146,47 +165,24 @@ void loop() {
 }
 
 
-void setButtonDownState() {
-  buttonDown = (digitalRead(BUTTON_PIN) == LOW);
-  digitalWrite(LED_BUILTIN, buttonDown ? HIGH : LOW);
-}
-
-
-void updateButtonState() {
-  const auto now = millis();
-  switch (buttonState) {
-    case ButtonState_t::UP:
-      if (buttonDown) {
-        buttonState = ButtonState_t::DEBOUNCE_DOWN;
-        buttonDownTime = millis();
-      }
-      break;
-    case ButtonState_t::DEBOUNCE_DOWN:
-      if (buttonDown && now - buttonDownTime > 20) {
-        buttonState = ButtonState_t::DOWN;
-      } else if (!buttonDown) {
-        buttonState = ButtonState_t::UP;
-      }
-      break;
-    case ButtonState_t::DOWN:
-      if (now - buttonDownTime > 500) {
-        buttonState = ButtonState_t::LONG_BUTTON_PRESS;
-      } else if (!buttonDown) {
-        buttonState = ButtonState_t::BUTTON_PRESS;
-      }
-      break;
-    case ButtonState_t::LONG_BUTTON_PRESS:
-      buttonState = ButtonState_t::AFTER_BUTTON_PRESS;
-      break;
-    case ButtonState_t::BUTTON_PRESS:
-      buttonState = ButtonState_t::AFTER_BUTTON_PRESS;
-      break;
-    case ButtonState_t::AFTER_BUTTON_PRESS:
-      if (!buttonDown) {
-        buttonState = ButtonState_t::UP;
-      }
-      break;
+void printSpectrumAnalyzerStats(const uint32_t now_ms) {
+  static uint32_t lastPrint_ms = 0;
+  if (now_ms - lastPrint_ms < DEBUG_INTERVAL_MS) {
+    return;
+  }
+  const SpectrumAnalyzerStats stats = takeSpectrumAnalyzerStats();
+  const uint32_t elapsed_ms = now_ms - lastPrint_ms;
+  lastPrint_ms = now_ms;
+  if (stats.frames == 0) {
+    return;
   }
+  Serial.printf(
+    "%lu fps, latency %lu us average, %lu us max, %u overruns, %u dropped samples\n",
+    stats.frames * 1000ul / elapsed_ms,
+    stats.totalLatency_us / stats.frames,
+    stats.maximumLatency_us,
+    stats.overruns,
+    stats.droppedSamples);
 }
 
 
@@ -0,0 +1,102 @@
+#include <Arduino.h>
+
+#include "sampler.hpp"
+
+// The Trinket M0 is a SAMD21, so this drives TC3 and the ADC registers
+// directly. TC3 isn't used by FastLED or the Arduino core (Tone uses TC5).
+
+static volatile sampleCallback_t sampleCallback = nullptr;
+static uint16_t samplingRate_hz = 0;
+static uint32_t samplePeriod_us = 0;
+static uint32_t lastTick_us = 0;
+static volatile uint16_t droppedSamples = 0;
+
+static void syncTc3() {
+  while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+static void syncAdc() {
+  while (ADC->STATUS.bit.SYNCBUSY);
+}
+
+
+void startSampling(const uint8_t pin, const uint16_t rate_hz, const sampleCallback_t callback) {
+  // Animations call this every frame, so make the common case cheap
+  if (sampleCallback == callback && samplingRate_hz == rate_hz && ADC->CTRLA.bit.ENABLE) {
+    return;
+  }
+
+  // Let the core set up the mux, reference and clock for this pin, then leave
+  // the ADC enabled so we can start conversions from the interrupt. Do this
+  // every time, because a plain analogRead() elsewhere turns the ADC off.
+  analogRead(pin);
+  ADC->CTRLA.bit.ENABLE = 1;
+  syncAdc();
+  ADC->SWTRIG.bit.START = 1;
+
+  sampleCallback = callback;
+  if (samplingRate_hz == rate_hz) {
+    // The timer is already running
+    return;
+  }
+
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TCC2_TC3;
+  while (GCLK->STATUS.bit.SYNCBUSY);
+
+  TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+  syncTc3();
+  TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV1;
+  syncTc3();
+  TC3->COUNT16.CC[0].reg = SystemCoreClock / rate_hz - 1;
+  syncTc3();
+  samplingRate_hz = rate_hz;
+  samplePeriod_us = 1000000ul / rate_hz;
+  lastTick_us = micros();
+
+  TC3->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+  NVIC_SetPriority(TC3_IRQn, 0);
+  NVIC_EnableIRQ(TC3_IRQn);
+  TC3->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+  syncTc3();
+}
+
+
+void stopSampling() {
+  TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+  syncTc3();
+  NVIC_DisableIRQ(TC3_IRQn);
+  sampleCallback = nullptr;
+  samplingRate_hz = 0;
+}
+
+
+uint16_t droppedSampleCount() {
+  return droppedSamples;
+}
+
+
+void TC3_Handler() {
+  TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  // If FastLED.show() held off interrupts for a while, the ticks in between
+  // only set the flag once, so we just pick up where we left off. Count the
+  // ones we missed. The M0 has no divide instruction, so only divide when
+  // we're late.
+  const uint32_t now_us = micros();
+  const uint32_t sinceLast_us = now_us - lastTick_us;
+  lastTick_us = now_us;
+  if (sinceLast_us > samplePeriod_us * 3 / 2) {
+    droppedSamples += (sinceLast_us + samplePeriod_us / 2) / samplePeriod_us - 1;
+  }
+  // Conversions take a few dozen microseconds, so the one we started last
+  // time should be done
+  if (ADC->INTFLAG.bit.RESRDY) {
+    const int16_t sample = ADC->RESULT.reg;
+    ADC->SWTRIG.bit.START = 1;
+    const sampleCallback_t callback = sampleCallback;
+    if (callback != nullptr) {
+      callback(sample);
+    }
+  } else {
+    ++droppedSamples;
+  }
+}
@@ -1,78 +1,97 @@
 #include <Arduino.h>
-#include <arduinoFFT.h>
 #include <cstdint>
+#include <cstring>
 #include <FastLED.h>
 
+#include "bands.hpp"
 #include "constants.hpp"
-
-// Note: I manually edited the arduinoFFT files so that it uses floats instead
-// of doubles, so that it's faster. These 2 lines just make the type match. If
-// you want, you can edit the library to use floats, or just leave it. This
-// should compile either way.
-static arduinoFFT FFT = arduinoFFT();
-typedef decltype(FFT.MajorPeak()) FftType;
+#include "fixedFft.hpp"
+#include "sampler.hpp"
+#include "spectrumAnalyzer.hpp"
+#include "spectrumSmoother.hpp"
 
 // Sample count must be a power of 2. I chose 128 because only half of the values
-// from the FFT correspond to frequencies, and the first 2 are sample averages, so
-// I needed more than LED_COUNT * 2 + 2, which gives me 128.
+// from the FFT correspond to frequencies, and the low bands need a few bins per
+// octave.
 static const int SAMPLE_COUNT = 128;
-static_assert(LED_COUNT * 2 + 2 < SAMPLE_COUNT, "");
-static_assert(LED_COUNT * 2 + 2 >= SAMPLE_COUNT / 2, "");
-
-extern CRGB leds[LED_COUNT];
-
-
-// collectSamples returns a reference to an array of FftType with size LED_SIZE
-static FftType (&collectSamples())[LED_COUNT];
-static FftType averagePower;
 
+// Most songs have notes in the lower end, so from experimental
+// observation, this seems like a good choice
+static const uint16_t SAMPLING_FREQUENCY_HZ = 5000;
+
+// bands.hpp is generated for these, so regenerate it if they change
+static_assert(BAND_SAMPLE_COUNT == SAMPLE_COUNT, "Regenerate bands.hpp");
+static_assert(BAND_SAMPLING_FREQUENCY_HZ == SAMPLING_FREQUENCY_HZ, "Regenerate bands.hpp");
+static_assert(BAND_COUNT == LED_COUNT, "Regenerate bands.hpp");
+
+
+// Each FFT overlaps the previous one by half, so we get a new frame every 64
+// samples (78 Hz) instead of every 128
+static const int HOP_COUNT = SAMPLE_COUNT / 2;
+
+// If the loudest band is quieter than this, don't scale it up to full
+// brightness, or we'd just be visualizing random noise
+static const uint16_t QUIET_MAXIMUM = 125;
+
+// This runs as a pipeline. The sampler interrupt fills one block while we
+// copy the last one into the history, transform it and push it to the LEDs,
+// so sampling never waits on the FFT or on FastLED.show(). Each stage owns
+// its own static buffers instead of handing back references to the next.
+static SampleBlocks<int16_t, HOP_COUNT> micSamples;
+static FixedFft<SAMPLE_COUNT> fft;
+static int16_t history[SAMPLE_COUNT];
+static uint16_t magnitudes[SAMPLE_COUNT / 2];
+static uint16_t bands[LED_COUNT];
+// Quick to light up, then the peaks hold for a moment and drop off
+static SpectrumSmoother<LED_COUNT> smoother(BAND_LOUDNESS, 10, 80, 50, 250);
+
+// When the sampler finished the newest block, and when it finished the
+// block in the frame that's about to be shown, for measuring latency
+static volatile uint32_t blockReady_us = 0;
+static uint32_t drawnBlockReady_us = 0;
+static SpectrumAnalyzerStats stats;
+static uint16_t reportedOverruns = 0;
+static uint16_t reportedDroppedSamples = 0;
+
+static void analyzeSamples(const int16_t* samples);
+
+static void pushMicSample(const int16_t sample) {
+  if (micSamples.push(sample)) {
+    blockReady_us = micros();
+  }
+}
 
-void spectrumAnalyzer(uint8_t) {
 
-  static uint8_t previousValues[LED_COUNT] = {0};
+uint16_t SpectrumAnalyzer::draw(uint8_t, const uint32_t now_ms, CRGB* const leds) {
   // Change the base hue of low intensity sounds so we can get more colors
   static uint8_t baseHue = 0;
 
-  baseHue += 1;
-
-  FftType (&sampleAverages)[LED_COUNT] = collectSamples();
-
-  // The bassline really drowns out the other samples, so reduce its effect
-  // Actually, is that because the FFT has very small buckets for lower samples?
-  // If the average intensity of half an octave is stuffed into a single bucket,
-  // that might be causing it to be overrepresented. TODO
-  for (uint8_t i = 0; i < COUNT_OF(sampleAverages) / 8; ++i) {
-    sampleAverages[i] *= 0.5;
-  }
-  for (uint8_t i = 0; i < COUNT_OF(sampleAverages) / 4; ++i) {
-    sampleAverages[i] *= 0.5;
+  // The sampler fills the next block while we're working on this one. Don't
+  // redraw until there's new audio, because FastLED.show() holds off
+  // interrupts and would starve the sampler.
+  startSampling(MICROPHONE_ANALOG_PIN, SAMPLING_FREQUENCY_HZ, pushMicSample);
+  const int16_t* const samples = micSamples.take();
+  if (samples == nullptr) {
+    return 0;
   }
+  drawnBlockReady_us = blockReady_us;
 
-  FftType maxSample = -1;
-  for (auto sa : sampleAverages) {
-    maxSample = max(maxSample, sa);
-  }
-  // Set a default max so that if it's quiet, we're not visualizing random noises
-  maxSample = max(maxSample, 1000);
-  const FftType MULTIPLIER = 1.0 / maxSample;
-  // Clamp them all to 0.0 - 1.0
-  for (auto& sa : sampleAverages) {
-    sa *= MULTIPLIER;
-  }
+  baseHue += 1;
+
+  analyzeSamples(samples);
+  smoother.update(bands, QUIET_MAXIMUM, now_ms);
 
   const uint8_t MAX_BRIGHTNESS = 128;
   // This cutoff needs some tweaking based on leds->getBrightness()
   // 10 works with brightness = 20
   const uint8_t CUTOFF = 10;
 
-  for (uint8_t i = 0; i < COUNT_OF(sampleAverages); ++i) {
-    // Implement a fade-off effect
-    const int FADE_OFF = 20;
-    uint8_t value = max(previousValues[i] > FADE_OFF ? previousValues[i] - FADE_OFF : 0, sampleAverages[i] * 0xFF);
-    previousValues[i] = value;
-    // Let's also reduce the color space a bit so that the colors aren't all over the place
-    const uint8_t hue = value / 2 + baseHue;
-    uint8_t brightness = min(MAX_BRIGHTNESS, value);
+  for (uint8_t i = 0; i < COUNT_OF(bands); ++i) {
+    // The peaks light the LEDs up and the smoother levels pick the colors.
+    // Let's also reduce the color space a bit so that the colors aren't all
+    // over the place.
+    const uint8_t hue = smoother.level(i) / 2 + baseHue;
+    uint8_t brightness = min(MAX_BRIGHTNESS, smoother.peak(i));
     // The visualization looks like garbage when brightness is high because all of the
     // LEDs turn on, and I want dim LEDs off
     if (brightness < CUTOFF) {
@@ -81,63 +100,46 @@ void spectrumAnalyzer(uint8_t) {
     leds[i] = CHSV(hue, 0xFF, brightness);
   }
 
-  FastLED.show();
+  return 1;
 }
 
 
-FftType (&collectSamples())[LED_COUNT] {
-  // Most songs have notes in the lower end, so from experimental
-  // observation, this seems like a good choice
-  static const uint32_t SAMPLING_FREQUENCY_HZ = 5000;
-  static const uint32_t samplingPeriod_us = round(1000000 * (1.0 / SAMPLING_FREQUENCY_HZ));
+void spectrumAnalyzerShown() {
+  const uint32_t latency_us = micros() - drawnBlockReady_us;
+  ++stats.frames;
+  stats.totalLatency_us += latency_us;
+  stats.maximumLatency_us = max(stats.maximumLatency_us, latency_us);
+}
 
-  // Declare these static so that we're not reallocating every call, and so that we
-  // can return a reference to sampleAverages
-  static FftType vReal[SAMPLE_COUNT];
-  static FftType vImaginary[SAMPLE_COUNT];
-  static FftType sampleAverages[LED_COUNT];
-  static const int usableValues = COUNT_OF(vReal) / 2;
-  static const int stepSize = usableValues / COUNT_OF(sampleAverages);
 
-  for (int i = 0; i < SAMPLE_COUNT; ++i) {
-    // TODO: Do we need to worry about overflow?
-    const auto before = micros();
+SpectrumAnalyzerStats takeSpectrumAnalyzerStats() {
+  SpectrumAnalyzerStats taken = stats;
+  const uint16_t overruns = micSamples.overrunCount();
+  taken.overruns = overruns - reportedOverruns;
+  reportedOverruns = overruns;
+  const uint16_t droppedSamples = droppedSampleCount();
+  taken.droppedSamples = droppedSamples - reportedDroppedSamples;
+  reportedDroppedSamples = droppedSamples;
+  stats = SpectrumAnalyzerStats();
+  return taken;
+}
 
-    vReal[i] = analogRead(MICROPHONE_ANALOG_PIN);
-    vImaginary[i] = 0;
 
-    const auto now = micros();
-    // I don't know if this is better than a busy wait loop or not
-    delayMicroseconds(before + samplingPeriod_us - now);
-  }
+void analyzeSamples(const int16_t* const samples) {
+  // Copy the block out first, so the sampler can have it back as soon as
+  // possible
+  memmove(&history[0], &history[HOP_COUNT], (SAMPLE_COUNT - HOP_COUNT) * sizeof(history[0]));
+  memcpy(&history[SAMPLE_COUNT - HOP_COUNT], samples, HOP_COUNT * sizeof(history[0]));
 
   // I tried all the windowing types with music and with a pure sine wave.
-  // For music, FFT_WIN_TYP_HAMMING seemed to do best, but FFT_WIN_TYP_TRIANGLE
-  // seemed best for the sine wave. HANN and TRIANGLE also did well.
-  FFT.Windowing(vReal, SAMPLE_COUNT, FFT_WIN_TYP_HAMMING, FFT_FORWARD);
-  FFT.Compute(vReal, vImaginary, SAMPLE_COUNT, FFT_FORWARD);
-  FFT.ComplexToMagnitude(vReal, vImaginary, SAMPLE_COUNT);
-
-  // The first 2 samples? are the average power of the signal, so skip them.
-  // Samples < 20Hz are so low that humans can't hear them, so skip those too.
-  const int SKIP = 2 + 5;
-  uint8_t counter = SKIP;
-  averagePower = vReal[0];
-  for (uint16_t i = 0; i < COUNT_OF(sampleAverages); ++i) {
-    sampleAverages[i] = 0;
-    // The FFT gives us equally spaced buckets (e.g. bucket 1 is 0-100 Hz, bucket 2 is 100-200 Hz)
-    // but notes increase in frequency quadratically. In fact, each increase in octave is double
-    // the frequency. As a kludge, just skip every other sample for the first half of the samples.
-    const int increment = i < COUNT_OF(sampleAverages) / 2 ? 2 : 1;
-    for (int j = 0; j < stepSize; j += increment, ++counter) {
-      sampleAverages[i] += vReal[counter];
-    }
-    // This division should compile down to a right bit shift
-    sampleAverages[i] /= stepSize;
-    // To be accurate, we should multiply by the increment. However, I've found that percussion
-    // tends to be lower, and it overwhelms the other stuff. Since we're biasing against low sounds
-    // anyway, we just won't do that. I think the visualization looks better. Sorry bass line.
-  }
-
-  return sampleAverages;
+  // For music, Hamming seemed to do best, but triangle seemed best for the
+  // sine wave. Hann and triangle also did well. FixedFft uses Hamming.
+  fft.magnitudes(history, magnitudes);
+
+  // The FFT gives us equally spaced buckets, but each octave is double the
+  // frequency of the last one, so give each octave the same number of LEDs.
+  // The bands are weighted so that pink noise comes out flat, and then the
+  // smoother weights them by how loud they sound, so the bassline doesn't
+  // drown out everything else anymore.
+  mapToBands(magnitudes, bands);
 }
@@ -0,0 +1,38 @@
+#ifndef SPECTRUM_ANALYZER_HPP
+#define SPECTRUM_ANALYZER_HPP
+
+#include <cstdint>
+#include <FastLED.h>
+
+#include "animation.hpp"
+
+// Shows the mic's spectrum, one band per LED. This runs the sampler, so it
+// only works on the mask.
+class SpectrumAnalyzer : public Animation {
+  public:
+    // Returns 0 until the sampler has a new block
+    uint16_t draw(uint8_t hue, uint32_t now_ms, CRGB* leds) override;
+
+  protected:
+    void restart() override {}
+};
+
+// Debug info about how well the spectrum analyzer is keeping up
+struct SpectrumAnalyzerStats {
+  uint16_t frames;  // Frames shown
+  // From when the newest sample in a frame was read to when FastLED.show()
+  // finished showing it
+  uint32_t totalLatency_us;
+  uint32_t maximumLatency_us;
+  uint16_t overruns;  // Blocks that the sampler dropped because we didn't take them in time
+  uint16_t droppedSamples;  // Sample periods that interrupts were held off for
+};
+
+// Call this right after FastLED.show() shows a frame that the spectrum
+// analyzer drew, so the latency includes showing it
+void spectrumAnalyzerShown();
+
+// Returns the stats since the last call and starts counting again
+SpectrumAnalyzerStats takeSpectrumAnalyzerStats();
+
+#endif  // SPECTRUM_ANALYZER_HPP
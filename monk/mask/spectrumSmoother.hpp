@@ -0,0 +1,151 @@
+#ifndef SPECTRUM_SMOOTHER_HPP
+#define SPECTRUM_SMOOTHER_HPP
+
+#include <cmath>
+#include <cstdint>
+
+// Smooths the spectrum analyzer bands over time. The analyzers used to fade
+// each LED by a fixed amount per frame, so they looked slower or faster
+// depending on how fast they were running. This works in milliseconds
+// instead, so it looks the same at any frame rate:
+// - Each band is weighted by how loud it sounds (A-weighting), so the
+//   bassline doesn't take over
+// - Levels rise and fall exponentially, quickly going up and slowly coming
+//   down
+// - Peaks jump up right away, hold for a bit, and then fall like they're
+//   dropped, slowly at first and then faster
+//
+// Levels and peaks are in 1/256ths so that slow decays still move a little
+// every frame. The decay factors come from a table that's built once, so the
+// per-band math is all integer. This doesn't use Arduino or FastLED, so it
+// can be run on a computer.
+//
+// The goggles and the monk mask both use this. Arduino won't compile files
+// from outside the sketch directory, so each has a copy; keep them in sync.
+template <int BAND_COUNT>
+class SpectrumSmoother {
+  public:
+    // loudness is a gain for each band with 15 fractional bits, like
+    // BAND_LOUDNESS from bands.hpp. Attack and decay are time constants. A
+    // peak stays put for hold_ms and then takes fall_ms to fall all the way.
+    SpectrumSmoother(
+      const uint16_t* const loudness,
+      const uint16_t attack_ms,
+      const uint16_t decay_ms,
+      const uint16_t hold_ms,
+      const uint16_t fall_ms
+    ) :
+      loudness(loudness), hold_ms(hold_ms), fall_ms(fall_ms),
+      attackRetained(), decayRetained(), targets(), levels(), peaks(), peakTimes_ms(), lastUpdate_ms(0), started(false)
+    {
+      for (int i = 0; i < TABLE_MS; ++i) {
+        attackRetained[i] = retained(i, attack_ms);
+        decayRetained[i] = retained(i, decay_ms);
+      }
+    }
+
+    // Call this with each new set of bands. Bands are scaled so the loudest
+    // one is full brightness, unless it's quieter than quietMaximum.
+    void update(const uint16_t* const bands, const uint16_t quietMaximum, const uint32_t now_ms) {
+      uint32_t elapsed_ms = started ? now_ms - lastUpdate_ms : TABLE_MS;
+      lastUpdate_ms = now_ms;
+      started = true;
+
+      uint16_t weighted[BAND_COUNT];
+      uint16_t maximum = quietMaximum;
+      for (int i = 0; i < BAND_COUNT; ++i) {
+        weighted[i] = (static_cast<uint32_t>(bands[i]) * loudness[i]) >> LOUDNESS_BITS;
+        maximum = weighted[i] > maximum ? weighted[i] : maximum;
+      }
+      if (maximum == 0) {
+        maximum = 1;
+      }
+
+      // How much of the old level is left after elapsed_ms. Long gaps are
+      // split up, because retained(a + b) = retained(a) * retained(b). Once
+      // both are 0 they stay 0, so a gap of minutes doesn't take thousands
+      // of steps.
+      uint32_t attack = 1ul << RETAINED_BITS;
+      uint32_t decay = 1ul << RETAINED_BITS;
+      while (elapsed_ms > 0 && (attack != 0 || decay != 0)) {
+        const uint32_t step_ms = elapsed_ms < TABLE_MS ? elapsed_ms : TABLE_MS - 1;
+        attack = (attack * attackRetained[step_ms]) >> RETAINED_BITS;
+        decay = (decay * decayRetained[step_ms]) >> RETAINED_BITS;
+        elapsed_ms -= step_ms;
+      }
+
+      for (int i = 0; i < BAND_COUNT; ++i) {
+        // The last frame's value is what the band was since then, so move
+        // toward that. Using the new value would count it as having been
+        // there the whole time, which gets it there faster at lower frame
+        // rates.
+        const int32_t target = targets[i];
+        const int32_t level = levels[i];
+        const uint32_t retain = target > level ? attack : decay;
+        levels[i] = target + (((level - target) * static_cast<int32_t>(retain)) >> RETAINED_BITS);
+        targets[i] = static_cast<uint32_t>(weighted[i]) * FULL_LEVEL / maximum;
+
+        // Peaks jump up right away, so the new value counts too
+        const uint16_t highest = targets[i] > target ? targets[i] : target;
+        if (highest >= fallenPeak(i, now_ms)) {
+          peaks[i] = highest;
+          peakTimes_ms[i] = now_ms;
+        }
+      }
+    }
+
+    // Smoothed level of a band, 0 to 255
+    uint8_t level(const int band) const {
+      return levels[band] >> 8;
+    }
+
+    // Where the falling peak of a band is as of the last update, 0 to 255
+    uint8_t peak(const int band) const {
+      return fallenPeak(band, lastUpdate_ms) >> 8;
+    }
+
+  private:
+    static const int LOUDNESS_BITS = 15;
+    static const uint16_t FULL_LEVEL = 0xFF00;
+    // 15 bits so that a full scale difference times this still fits in an int32_t
+    static const int RETAINED_BITS = 15;
+    static const int TABLE_MS = 64;
+
+    const uint16_t* const loudness;
+    const uint16_t hold_ms;
+    const uint16_t fall_ms;
+    uint32_t attackRetained[TABLE_MS];
+    uint32_t decayRetained[TABLE_MS];
+    uint16_t targets[BAND_COUNT];
+    uint16_t levels[BAND_COUNT];
+    uint16_t peaks[BAND_COUNT];
+    uint32_t peakTimes_ms[BAND_COUNT];
+    uint32_t lastUpdate_ms;
+    bool started;
+
+    static uint32_t retained(const int elapsed_ms, const uint16_t timeConstant_ms) {
+      if (timeConstant_ms == 0) {
+        return elapsed_ms == 0 ? 1ul << RETAINED_BITS : 0;
+      }
+      return lroundf(expf(-static_cast<float>(elapsed_ms) / timeConstant_ms) * (1ul << RETAINED_BITS));
+    }
+
+    // Peaks fall as if they were dropped, so the distance goes up with the
+    // square of the time since the hold ended
+    uint16_t fallenPeak(const int band, const uint32_t now_ms) const {
+      const uint32_t held_ms = now_ms - peakTimes_ms[band];
+      if (held_ms <= hold_ms) {
+        return peaks[band];
+      }
+      const uint32_t falling_ms = held_ms - hold_ms;
+      if (falling_ms >= fall_ms) {
+        return 0;
+      }
+      // Fraction of fall_ms, out of 256
+      const uint32_t fraction = falling_ms * 256 / fall_ms;
+      const uint32_t fallen = (FULL_LEVEL * fraction * fraction) >> 16;
+      return fallen < peaks[band] ? peaks[band] - fallen : 0;
+    }
+};
+
+#endif  // SPECTRUM_SMOOTHER_HPP
@@ -9,39 +9,69 @@ extern CRGB leds[];
 
 using std::fill;
 
+CRGB Animation::framebuffer[LED_COLUMN_COUNT][LED_ROW_COUNT];
+
 CRGB ColorGenerator::getColor(const uint8_t v) {
   return CHSV(v, 255, 255);
 }
 
-CRGB ColorGenerator::getColor(const uint16_t v) {
+void ColorGenerator::prepare() {
+  if ((advance() || !prepared) && usesPalette()) {
+    for (int i = 0; i < PALETTE_SIZE; ++i) {
+      palette[i] = computeColor(i * PALETTE_STEP);
+    }
+    prepared = true;
+  }
+}
+
+void ColorGenerator::map(const uint16_t* const values, CRGB* const out, const int count) const {
+  if (!usesPalette()) {
+    for (int i = 0; i < count; ++i) {
+      out[i] = computeColor(values[i]);
+    }
+    return;
+  }
+  for (int i = 0; i < count; ++i) {
+    // Round to the nearest color. The top one wraps around to 0, same as the
+    // values do.
+    const uint16_t rounded = values[i] + PALETTE_STEP / 2;
+    out[i] = palette[rounded / PALETTE_STEP];
+  }
+}
+
+CRGB ColorGenerator::computeColor(const uint16_t v) const {
   CRGB crgb;
   hsv2rgb_raw(CHSV(v / 256, 255, 255), crgb);
   return crgb;
 }
 
-CRGB RedGreenGenerator::getColor(const uint16_t v) {
+CRGB RedGreenGenerator::computeColor(const uint16_t v) const {
   const uint8_t red = (sin16(v) / 256) + 128;
   const uint8_t green = (cos16(v) / 256) + 128;
   const uint8_t blue = 0;
   return CRGB(red, green, blue);
 }
 
-CRGB PastelGenerator::getColor(const uint16_t v) {
+CRGB PastelGenerator::computeColor(const uint16_t v) const {
   const uint8_t red = 255;
   const uint8_t green = (cos16(v) / 256) + 128;
   const uint8_t blue = (sin16(v) / 256) + 128;
   return CRGB(red, green, blue);
 }
 
-CRGB NeonGenerator::getColor(const uint16_t v) {
+CRGB NeonGenerator::computeColor(const uint16_t v) const {
   const uint8_t red = (sin16(v) / 256) + 128;
   const uint8_t green = (sin16(v + 2 * 32768 / 3) / 256) + 128;
   const uint8_t blue = (sin16(v + 4 * 32768 / 3) / 256) + 128;
   return CRGB(red, green, blue);
 }
 
-CRGB ChangingGenerator::getColor(const uint16_t v) {
-  timer += 6;
+bool ChangingGenerator::advance() {
+  timer += TIMER_STEP;
+  return true;
+}
+
+CRGB ChangingGenerator::computeColor(const uint16_t v) const {
   const uint16_t redOffset = sin16(timer / 13) + 32768;
   const uint16_t greenOffset = sin16(timer / 17) + 32768;
   const uint16_t blueOffset = sin16(timer / 19) + 32768;
@@ -51,7 +81,7 @@ CRGB ChangingGenerator::getColor(const uint16_t v) {
   return CRGB(red, green, blue);
 }
 
-CRGB ChristmasGenerator::getColor(const uint16_t v) {
+CRGB ChristmasGenerator::computeColor(const uint16_t v) const {
   uint8_t red = (sin16(v) / 256) + 128;
   if (red < 128) {
     red = 0;
@@ -70,10 +100,7 @@ CRGB ChristmasGenerator::getColor(const uint16_t v) {
 void Animation::setLed(int x, int y, const CRGB &color) {
   if (x >= 0 && x < LED_COLUMN_COUNT) {
     if (y >= 0 && y < LED_ROW_COUNT) {
-      const auto offset = XY_TO_OFFSET[x][y];
-      if (offset != UNUSED_LED) {
-        leds[offset] = color;
-      }
+      framebuffer[x][y] = color;
     }
   }
 }
@@ -82,12 +109,31 @@ void Animation::setLed(int index, const CRGB &color) {
   leds[index] = color;
 }
 
+void Animation::clearFramebuffer() {
+  fill(&framebuffer[0][0], &framebuffer[0][0] + LED_COLUMN_COUNT * LED_ROW_COUNT, CRGB::Black);
+}
+
+void Animation::clearLeds() {
+  fill_solid(leds, LED_COUNT, CRGB::Black);
+}
+
+void Animation::showFramebuffer() {
+  for (const auto& gridLed : GRID_LEDS) {
+    leds[gridLed.led] = framebuffer[gridLed.x][gridLed.y];
+  }
+  // The framebuffer doesn't cover these, and switching from something like
+  // Snake would leave them lit
+  for (const auto skippedLed : SKIPPED_LEDS) {
+    leds[skippedLed] = CRGB::Black;
+  }
+}
+
 Count::Count() : index(0), hue(0) {}
 
 int Count::animate() {
   const int millisPerIteration = 500;
 
-  FastLED.clear();
+  clearLeds();
   setLed(index, CHSV(hue, 255, 255));
   ++hue;
   ++index;
@@ -101,7 +147,10 @@ CountXY::CountXY() : offset(0) {}
 
 int CountXY::animate() {
   const int millisPerIteration = 500;
-  FastLED.clear();
+  // Clear the LEDs too, because the red one goes over the LEDs that aren't
+  // in the grid
+  clearLeds();
+  clearFramebuffer();
 
   // Highlight the top and bottom of each column
   for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
@@ -123,6 +172,8 @@ int CountXY::animate() {
     }
   }
 
+  showFramebuffer();
+
   ++offset;
   if (offset >= LED_COUNT) {
     offset = 0;
@@ -135,7 +186,7 @@ int CountXY::animate() {
 HorizontalSnake::HorizontalSnake() : x(0), y(0), hue(0), xIncreasing(true) {}
 
 int HorizontalSnake::animate() {
-  FastLED.clear();
+  clearFramebuffer();
   if (xIncreasing) {
     ++x;
     if (x >= LED_COLUMN_COUNT) {
@@ -165,6 +216,7 @@ int HorizontalSnake::animate() {
     }
     tempX += direction;
   }
+  showFramebuffer();
   ++hue;
   return 20;
 }
@@ -174,7 +226,7 @@ Snake::Snake(int length_) : length(length_), offset(0), hue(0) {}
 int Snake::animate() {
   const unsigned millisPerIteration = 20;
 
-  FastLED.clear();
+  clearLeds();
 
   offset = (offset + 1) % LED_COUNT;
   if (offset < length) {
@@ -208,7 +260,7 @@ int Shine::animate() {
   static_assert(maxAmount % changeAmount == 0);
 
   hue += 4; // Make it cycle faster
-  FastLED.clear();
+  clearLeds();
 
   // Randomly start increasing an LED
   int chosen = rand() % LED_COUNT;
@@ -257,7 +309,7 @@ int Blobs::animate() {
   const float radius2 = radius * radius;
   const float reachedDistance2 = 2.0f;
 
-  FastLED.clear();
+  clearFramebuffer();
 
   for (int i = 0; i < count; ++i) {
     const float distance2 = (targetX[i] - x[i]) * (targetX[i] - x[i]) +
@@ -303,27 +355,24 @@ int Blobs::animate() {
     const uint8_t hueOffset = 256 / count * i;
     for (int xIter = startX; xIter < endX; ++xIter) {
       for (int yIter = startY; yIter < endY; ++yIter) {
-        const auto offset = XY_TO_OFFSET[xIter][yIter];
-        if (offset == UNUSED_LED) {
-          continue;
-        }
         const float distance2 = static_cast<float>(
                                   (xIter - x[i]) * (xIter - x[i]) + (yIter - y[i]) * (yIter - y[i]));
         const float ratio = sqrtf((radius2 - distance2) / radius2);
         if (ratio > 0.0f) {
           const int brightness = static_cast<int>(255 * ratio);
           const CHSV color = CHSV(hue + hueOffset, 255, brightness);
-          // TODO(bskari) What does this do? Does this mean it's unset? Ugh
-          if (leds[offset]) {
-            const CRGB blended = blend(color, leds[offset], 128);
-            setLed(xIter, yIter, blended);
+          // If another blob already lit this cell, mix them
+          CRGB& cell = framebuffer[xIter][yIter];
+          if (cell) {
+            cell = blend(color, cell, 128);
           } else {
-            setLed(xIter, yIter, color);
+            cell = color;
           }
         }
       }
     }
   }
+  showFramebuffer();
 
   return millisPerIteration;
 }
@@ -337,58 +386,122 @@ Blobs::~Blobs() {
   delete[] ySpeed;
 }
 
+// sin16 angle units per radian, shifted up 16 bits
+static const uint32_t RADIAN_ANGLE = 683565276;
+
+// Radians to a sin16 angle shifted up 16 bits. Only for setting up, because
+// it uses floats.
+static uint32_t toAngle(const float radians) {
+  return static_cast<uint32_t>(static_cast<int64_t>(static_cast<double>(radians) * RADIAN_ANGLE));
+}
+
+static int16_t toFraction(const float f) {
+  return static_cast<int16_t>(f * 32767.0f);
+}
+
+// Like sin16, but interpolated from QUARTER_SINE, so it's a lot closer.
+// sin16 is off by up to about 0.3%, and PlasmaBidoulle adds three of them up
+// and then takes the sine of that, so it's noticeably off.
+static int16_t sine(const uint16_t angle) {
+  // QUARTER_SINE has 256 steps, so 64 angles per step
+  const uint16_t quarterAngle = angle & 0x3FFF;
+  const int index = (angle & 0x4000) ? 0x4000 - quarterAngle : quarterAngle;
+  const int step = index >> 6;
+  int value = QUARTER_SINE[step];
+  if (step < COUNT_OF(QUARTER_SINE) - 1) {
+    value += (QUARTER_SINE[step + 1] - value) * (index & 63) >> 6;
+  }
+  return (angle & 0x8000) ? -value : value;
+}
+
 PlasmaBidoulle::PlasmaBidoulle(float multiplier_, float timeIncrement_)
-  : time(0), multiplier(multiplier_), timeIncrement(timeIncrement_),
-    redMultiplier(1.0f), greenMultiplier(1.0f), blueMultiplier(1.0f),
-    redOffset(0.0f), greenOffset(2.0f / 3.0f * M_PI),
-    blueOffset(4.0f / 3.0f * M_PI) {}
+  : time(0), multiplier(toAngle(multiplier_)), timeIncrement(toAngle(timeIncrement_)),
+    redMultiplier(32767), greenMultiplier(32767), blueMultiplier(32767),
+    redOffset(0), greenOffset(65536 / 3), blueOffset(2 * 65536 / 3),
+    ringAngles()
+{
+  fillRingAngles();
+}
 
 PlasmaBidoulle::PlasmaBidoulle(float multiplier_, float timeIncrement_,
                                float redMultiplier_, float greenMultiplier_,
                                float blueMultiplier_, float redOffset_,
                                float greenOffset_, float blueOffset_)
-  : time(0), multiplier(multiplier_), timeIncrement(timeIncrement_),
-    redMultiplier(redMultiplier_), greenMultiplier(greenMultiplier_),
-    blueMultiplier(blueMultiplier_), redOffset(redOffset_),
-    greenOffset(greenOffset_), blueOffset(blueOffset_) {}
+  : time(0), multiplier(toAngle(multiplier_)), timeIncrement(toAngle(timeIncrement_)),
+    redMultiplier(toFraction(redMultiplier_)), greenMultiplier(toFraction(greenMultiplier_)),
+    blueMultiplier(toFraction(blueMultiplier_)), redOffset(toAngle(redOffset_) >> 16),
+    greenOffset(toAngle(greenOffset_) >> 16), blueOffset(toAngle(blueOffset_) >> 16),
+    ringAngles()
+{
+  fillRingAngles();
+}
 
-uint8_t PlasmaBidoulle::convert(const float f) {
-  return static_cast<uint8_t>((f + 1.0f) * 0.5f * 255.0f);
+void PlasmaBidoulle::fillRingAngles() {
+  const float multiplierRadians = static_cast<float>(multiplier) / RADIAN_ANGLE;
+  for (int i = 0; i < RING_ANGLE_COUNT; ++i) {
+    ringAngles[i] = toAngle(multiplierRadians * sqrtf(i * (1.0f / 8.0f))) >> 16;
+  }
 }
 
 int PlasmaBidoulle::animate() {
-  // Adapted from https://www.bidouille.org/prog/plasma
-  const float M_PI_F = static_cast<float>(M_PI);
-
-  FastLED.clear();
+  // Adapted from https://www.bidouille.org/prog/plasma, which does this with
+  // floats:
+  //   v1 = sin(multiplier * x + time)
+  //   v2 = sin(multiplier * (x * sin(time / 2) + y * cos(time / 3)) + time)
+  //   cx = sin(x + 0.5 * sin(time / 5))
+  //   cy = y + 0.5 * cos(time / 3)
+  //   v3 = sin(multiplier * sqrt(cx * cx + cy * cy + 1) + time)
+  //   v = v1 + v2 + v3
+  //   red = sin(v * pi + redOffset)
+  // Everything except the sines of sums only depends on x or y, so work
+  // those out once per frame.
   time += timeIncrement;
-  float cys[LED_ROW_COUNT];
-  for (int y = 0; y < LED_ROW_COUNT; ++y) {
-    cys[y] = y + 0.5f * cosf(time * (1.0f / 3.0f));
-  }
+  const uint32_t timeAngle = time;
+  const int halfTimeSin = sine(time / 2 >> 16);
+  const int thirdTimeCos = sine((time / 3 >> 16) + 65536 / 4);
+  const int fifthTimeSin = sine(time / 5 >> 16);
+  const uint32_t cxShift = static_cast<int64_t>(fifthTimeSin) * (RADIAN_ANGLE / 2) / 32768;
+
+  int16_t v1s[LED_COLUMN_COUNT];
+  uint32_t v2Columns[LED_COLUMN_COUNT];
+  // These are 8.8 fixed point
+  uint32_t cxSquares[LED_COLUMN_COUNT];
   for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
-    const float v1 = sinf(multiplier * x + time);
-    const float cx = sinf(x + 0.5 * sinf(time * 0.2f));
-    for (int y = 0; y < LED_ROW_COUNT; ++y) {
-      if (XY_TO_OFFSET[x][y] != UNUSED_LED) {
-        const float v2 = sinf(multiplier * (x * sinf(time * 0.5f) +
-                                            y * cosf(time * (1.0f / 3.0f))) +
-                              time);
-        const float v3 =
-          sinf(multiplier * sqrtf((cx * cx + cys[y] * cys[y] + 1.0f)) + time);
-        const float v = v1 + v2 + v3;
-        // const float v = v1 + v2;
-        const float red = redMultiplier * sinf(v * M_PI_F + redOffset);
-        const float green = greenMultiplier * sinf(v * M_PI_F + greenOffset);
-        const float blue = blueMultiplier * sinf(v * M_PI_F + blueOffset);
-        const uint8_t r = convert(red);
-        const uint8_t g = convert(green);
-        const uint8_t b = convert(blue);
-        setLed(x, y, CRGB(r, g, b));
-      }
-    }
+    const int64_t xAngle = static_cast<int64_t>(multiplier) * x;
+    v1s[x] = sine((static_cast<uint32_t>(xAngle) + timeAngle) >> 16);
+    v2Columns[x] = xAngle * halfTimeSin / 32768;
+    const int cx = sine((x * RADIAN_ANGLE + cxShift) >> 16);
+    // Do the + 1 here
+    cxSquares[x] = (cx * cx >> 22) + 256;
+  }
+  uint32_t v2Rows[LED_ROW_COUNT];
+  uint32_t cySquares[LED_ROW_COUNT];
+  for (int y = 0; y < LED_ROW_COUNT; ++y) {
+    v2Rows[y] = static_cast<int64_t>(multiplier) * y * thirdTimeCos / 32768;
+    const int64_t cy = (y << 15) + thirdTimeCos / 2;
+    cySquares[y] = cy * cy >> 22;
+  }
+
+  const uint16_t timeAngle16 = timeAngle >> 16;
+  for (const auto& gridLed : GRID_LEDS) {
+    const int x = gridLed.x;
+    const int y = gridLed.y;
+    const int v2 = sine((v2Columns[x] + v2Rows[y] + timeAngle) >> 16);
+    // Round the squared distance to the nearest 1/8
+    const int ringIndex = (cxSquares[x] + cySquares[y] + 16) >> 5;
+    const int v3 = sine(ringAngles[ringIndex] + timeAngle16);
+    // v is 3 at most, and 32767 is 1, so this is about v * pi as an angle
+    const uint16_t vAngle = v1s[x] + v2 + v3;
+    const auto convert = [vAngle](const int16_t channelMultiplier, const uint16_t offset) {
+      const int value = channelMultiplier * sine(vAngle + offset) / 32768;
+      return static_cast<uint8_t>((value + 32768) * 255 >> 16);
+    };
+    leds[gridLed.led] = CRGB(
+      convert(redMultiplier, redOffset),
+      convert(greenMultiplier, greenOffset),
+      convert(blueMultiplier, blueOffset));
   }
-  return 0;
+  return 20;
 }
 
 PlasmaBidoulleFast::PlasmaBidoulleFast(ColorGenerator &colorGenerator_)
@@ -411,78 +524,148 @@ int PlasmaBidoulleFast::animate() {
   // blend for y
 
   time += timeIncrement;
+  // v1 only depends on x, and v2 is the sine of a column part plus a row
+  // part, so work those out once per frame
+  int16_t v1s[LED_COLUMN_COUNT];
+  int v2Columns[LED_COLUMN_COUNT];
+  const int16_t v2XSin = sin16(time / 4);
   for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
-    const int16_t v1 = sin16(multiplier * x + time); // good
+    v1s[x] = sin16(multiplier * x + time); // good
     // const int16_t cx = sin16(multiplier * x + sin16(time / 5) / 2);  // bad
-    for (int y = 0; y < LED_ROW_COUNT; ++y) {
-      if (XY_TO_OFFSET[x][y] != UNUSED_LED) {
-        const int16_t v2 = sin16(
-                             (multiplier * (x * sin16(time / 4) / 2 + y * cos16(time / 3)) +
-                              time) /
-                             16384); // bad values, but looks good?
-        const int adjustedX = x + xOffset + X_CENTER;
-        const int adjustedY = y + yOffset + Y_CENTER;
-        const uint16_t blend1 = bidoulleV3rings[adjustedX][adjustedY] * (blend - xRemainder) / blend;
-        const uint16_t blend2 = bidoulleV3rings[adjustedX + 1][adjustedY] * xRemainder / blend;
-        const uint16_t v3 = (blend1 + blend2) / 2 * 256;
-        const uint16_t v = v1 + v2 + v3;
-        setLed(x, y, colorGenerator.getColor(v));
-      }
-    }
+    v2Columns[x] = multiplier * (x * v2XSin / 2);
+  }
+  int v2Rows[LED_ROW_COUNT];
+  const int16_t v2YCos = cos16(time / 3);
+  for (int y = 0; y < LED_ROW_COUNT; ++y) {
+    v2Rows[y] = multiplier * (y * v2YCos);
+  }
+
+  uint16_t values[GRID_LED_COUNT];
+  for (int i = 0; i < GRID_LED_COUNT; ++i) {
+    const int x = GRID_LEDS[i].x;
+    const int y = GRID_LEDS[i].y;
+    const int16_t v2 = sin16((v2Columns[x] + v2Rows[y] + time) / 16384); // bad values, but looks good?
+    const int adjustedX = x + xOffset + X_CENTER;
+    const int adjustedY = y + yOffset + Y_CENTER;
+    const uint16_t blend1 = bidoulleV3rings[adjustedX][adjustedY] * (blend - xRemainder) / blend;
+    const uint16_t blend2 = bidoulleV3rings[adjustedX + 1][adjustedY] * xRemainder / blend;
+    const uint16_t v3 = (blend1 + blend2) / 2 * 256;
+    values[i] = v1s[x] + v2 + v3;
+  }
+
+  CRGB colors[GRID_LED_COUNT];
+  colorGenerator.prepare();
+  colorGenerator.map(values, colors, GRID_LED_COUNT);
+  for (int i = 0; i < GRID_LED_COUNT; ++i) {
+    leds[GRID_LEDS[i].led] = colors[i];
   }
   return 20;
 }
 
+// sqrt16(x * x + y * y) for each of GRID_LEDS. It never changes, so it's only
+// worked out the first time.
+static const uint8_t* gridLedRadii() {
+  static uint8_t radii[GRID_LED_COUNT];
+  static bool filled = false;
+  if (!filled) {
+    for (int i = 0; i < GRID_LED_COUNT; ++i) {
+      const int x = GRID_LEDS[i].x;
+      const int y = GRID_LEDS[i].y;
+      radii[i] = sqrt16(x * x + y * y);
+    }
+    filled = true;
+  }
+  return radii;
+}
+
+// More than sqrt16 gives for any grid LED, however it rounds
+static const int MAXIMUM_GRID_RADIUS = LED_COLUMN_COUNT + LED_ROW_COUNT;
+
 Plasma1::Plasma1(ColorGenerator &colorGenerator_)
   : colorGenerator(colorGenerator_), time(0) {}
 
 int Plasma1::animate() {
+  // Every term only depends on x, y, x + y, or the distance from the corner,
+  // so work those out once per frame and just add them up per LED
+  uint8_t p1s[LED_COLUMN_COUNT];
   for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
-    for (int y = 0; y < LED_ROW_COUNT; ++y) {
-      const auto index = XY_TO_OFFSET[x][y];
-      if (index != UNUSED_LED) {
-        const uint8_t p1 = 128 + (sin16(x * (PI_16_1_0 / 4) + time / 4)) / 256;
-        const uint8_t p2 = 128 + (sin16(y * (PI_16_1_0 / 4) + time / 4)) / 256;
-        const uint8_t p3 =
-          128 + (sin16((x + y) * (PI_16_1_0 / 8) + time / 8)) / 256;
-        const uint8_t p4 =
-          128 + (sin16(sqrt16(x * x + y * y) * 1000 + time)) / 256;
-        const uint8_t v = (p1 + p2 + p3 + p4) / 4;
-        setLed(x, y, colorGenerator.getColor(v));
-      }
-    }
+    p1s[x] = 128 + (sin16(x * (PI_16_1_0 / 4) + time / 4)) / 256;
+  }
+  uint8_t p2s[LED_ROW_COUNT];
+  for (int y = 0; y < LED_ROW_COUNT; ++y) {
+    p2s[y] = 128 + (sin16(y * (PI_16_1_0 / 4) + time / 4)) / 256;
+  }
+  uint8_t p3s[LED_COLUMN_COUNT + LED_ROW_COUNT - 1];
+  for (int xy = 0; xy < COUNT_OF(p3s); ++xy) {
+    p3s[xy] = 128 + (sin16(xy * (PI_16_1_0 / 8) + time / 8)) / 256;
+  }
+  uint8_t p4s[MAXIMUM_GRID_RADIUS + 1];
+  for (int radius = 0; radius < COUNT_OF(p4s); ++radius) {
+    p4s[radius] = 128 + (sin16(radius * 1000 + time)) / 256;
+  }
+
+  const uint8_t* const radii = gridLedRadii();
+  for (int i = 0; i < GRID_LED_COUNT; ++i) {
+    const int x = GRID_LEDS[i].x;
+    const int y = GRID_LEDS[i].y;
+    const uint8_t v = (p1s[x] + p2s[y] + p3s[x + y] + p4s[radii[i]]) / 4;
+    leds[GRID_LEDS[i].led] = colorGenerator.getColor(v);
   }
   time += 1000;
   return 10;
 }
 
+// Plasma2 and Plasma3 are the same
+static void drawPlasma3(ColorGenerator& colorGenerator, const int time) {
+  // cx = x + 0.5 * sin(time / 5)
+  // cy = y + 0.5 * cos(time / 3)
+  // v = sin(sqrt(100 * (cx**2 + cy ** 2) + 1) + time)
+  // p1 and cx only depend on x, and p2 is the sine of an x part plus a y
+  // part, so work those out once per frame
+  uint8_t p1s[LED_COLUMN_COUNT];
+  int p2Columns[LED_COLUMN_COUNT];
+  uint32_t cxSquares[LED_COLUMN_COUNT];
+  const int16_t p2XSin = sin16(time / 2);
+  const int16_t cxOffset = sin16(time / 8) / 1024;
+  for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
+    p1s[x] = 128 + (sin16(x * (PI_16_1_0 / 8) + time / 4)) / 256;
+    p2Columns[x] = 10 * (x * p2XSin / 256);
+    // cx goes below 0 near the left edge and wraps around. The square only
+    // gets used for its bottom 16 bits, so do it unsigned.
+    const uint16_t cx = x + cxOffset;
+    cxSquares[x] = static_cast<uint32_t>(cx) * cx;
+  }
+  int p2Rows[LED_ROW_COUNT];
+  uint32_t cySquares[LED_ROW_COUNT];
+  const int16_t p2YCos = cos16(time / 3);
+  const int16_t cyOffset = sin16(time / 16) / 1024;
+  for (int y = 0; y < LED_ROW_COUNT; ++y) {
+    p2Rows[y] = 10 * (y * p2YCos / 256);
+    const uint16_t cy = y + cyOffset;
+    cySquares[y] = static_cast<uint32_t>(cy) * cy;
+  }
+  uint8_t p3s[LED_COLUMN_COUNT + LED_ROW_COUNT - 1];
+  for (int xy = 0; xy < COUNT_OF(p3s); ++xy) {
+    p3s[xy] = 128 + (sin16(xy * (PI_16_1_0 / 8) + time / 8)) / 256;
+  }
+
+  for (const auto& gridLed : GRID_LEDS) {
+    const int x = gridLed.x;
+    const int y = gridLed.y;
+    const uint8_t p2 = 128 + sin16(p2Columns[x] + p2Rows[y]) / 256;
+    const uint8_t p4 =
+      128 +
+      sin16(sqrt16(cxSquares[x] + cySquares[y]) * (PI_16_1_0 / 2) + time) / 512;
+    const uint8_t v = (p1s[x] + p2 + p3s[x + y] + p4) / 4;
+    leds[gridLed.led] = colorGenerator.getColor(v);
+  }
+}
+
 Plasma2::Plasma2(ColorGenerator &colorGenerator_)
   : colorGenerator(colorGenerator_), time(0) {}
 
 int Plasma2::animate() {
-  for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
-    for (int y = 0; y < LED_ROW_COUNT; ++y) {
-      const auto index = XY_TO_OFFSET[x][y];
-      if (index != UNUSED_LED) {
-        const uint8_t p1 = 128 + (sin16(x * (PI_16_1_0 / 8) + time / 4)) / 256;
-        const uint8_t p2 = 128 + sin16(10 * (x * sin16(time / 2) / 256 +
-                                             y * cos16(time / 3) / 256)) /
-                           256;
-        const uint8_t p3 =
-          128 + (sin16((x + y) * (PI_16_1_0 / 8) + time / 8)) / 256;
-        // cx = x + 0.5 * sin(time / 5)
-        // cy = y + 0.5 * cos(time / 3)
-        // v = sin(sqrt(100 * (cx**2 + cy ** 2) + 1) + time)
-        const uint16_t cx = x + sin16(time / 8) / 1024;
-        const uint16_t cy = y + sin16(time / 16) / 1024;
-        const uint8_t p4 =
-          128 +
-          sin16(sqrt16(cx * cx + cy * cy) * (PI_16_1_0 / 2) + time) / 512;
-        const uint8_t v = (p1 + p2 + p3 + p4) / 4;
-        setLed(x, y, colorGenerator.getColor(v));
-      }
-    }
-  }
+  drawPlasma3(colorGenerator, time);
   time += 1000;
   return 10;
 }
@@ -491,29 +674,7 @@ Plasma3::Plasma3(ColorGenerator &colorGenerator_)
   : colorGenerator(colorGenerator_), time(0) {}
 
 int Plasma3::animate() {
-  for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
-    for (int y = 0; y < LED_ROW_COUNT; ++y) {
-      const auto index = XY_TO_OFFSET[x][y];
-      if (index != UNUSED_LED) {
-        const uint8_t p1 = 128 + (sin16(x * (PI_16_1_0 / 8) + time / 4)) / 256;
-        const uint8_t p2 = 128 + sin16(10 * (x * sin16(time / 2) / 256 +
-                                             y * cos16(time / 3) / 256)) /
-                           256;
-        const uint8_t p3 =
-          128 + (sin16((x + y) * (PI_16_1_0 / 8) + time / 8)) / 256;
-        // cx = x + 0.5 * sin(time / 5)
-        // cy = y + 0.5 * cos(time / 3)
-        // v = sin(sqrt(100 * (cx**2 + cy ** 2) + 1) + time)
-        const uint16_t cx = x + sin16(time / 8) / 1024;
-        const uint16_t cy = y + sin16(time / 16) / 1024;
-        const uint8_t p4 =
-          128 +
-          sin16(sqrt16(cx * cx + cy * cy) * (PI_16_1_0 / 2) + time) / 512;
-        const uint8_t v = (p1 + p2 + p3 + p4) / 4;
-        setLed(x, y, colorGenerator.getColor(v));
-      }
-    }
-  }
+  drawPlasma3(colorGenerator, time);
   time += 1000;
   return 10;
 }
@@ -534,11 +695,7 @@ int CenteredVideo::animate() {
   const int width = 12;
   const int startColumn = 8;
 
-  for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
-    for (int y = 0; y < LED_ROW_COUNT; ++y) {
-      setLed(x, y, CRGB::Black);
-    }
-  }
+  clearFramebuffer();
 
   int count = 0;
   for (int y = 0; y < height; ++y) {
@@ -548,15 +705,44 @@ int CenteredVideo::animate() {
       setLed(startColumn + width - x - 1, height - y, value);
     }
   }
+  showFramebuffer();
   frame = (frame + 1) % frameCount;
   return millisPerFrame;
 }
 
-SpectrumAnalyzer1::SpectrumAnalyzer1(int (*sf)(void)) : soundFunction(sf) {
+SpectrumAnalyzer1::SpectrumAnalyzer1(void (*sf)(SoundLevels*)) :
+  soundFunction(sf),
+  lastBeatCount(0),
+  beatBrightness(0)
+{
 }
 
 int SpectrumAnalyzer1::animate() {
-  return 0;
+  SoundLevels levels;
+  soundFunction(&levels);
+  if (levels.beatCount != lastBeatCount) {
+    lastBeatCount = levels.beatCount;
+    beatBrightness = 128;
+  }
+
+  // The bands cover every column, so there's nothing to clear
+  const int columnsPerBand = LED_COLUMN_COUNT / SoundLevels::BAND_COUNT;
+  static_assert(LED_COLUMN_COUNT % SoundLevels::BAND_COUNT == 0, "Bands don't cover the grid");
+  for (int band = 0; band < SoundLevels::BAND_COUNT; ++band) {
+    const int height = (levels.bands[band] * LED_ROW_COUNT + 127) / 255;
+    const uint8_t hue = band * 256 / SoundLevels::BAND_COUNT;
+    const CRGB bar = CHSV(hue, 255, 255);
+    // The background lights up on the beat and fades out
+    const CRGB background = CHSV(hue, 255, beatBrightness);
+    for (int x = band * columnsPerBand; x < (band + 1) * columnsPerBand; ++x) {
+      for (int y = 0; y < LED_ROW_COUNT; ++y) {
+        framebuffer[x][y] = y < height ? bar : background;
+      }
+    }
+  }
+  showFramebuffer();
+  beatBrightness = beatBrightness * 3 / 4;
+  return 20;
 }
 
 SnakeGame::SnakeGame()
@@ -703,7 +889,7 @@ void SnakeGame::spawnFruit() {
 }
 
 void SnakeGame::draw() const {
-  FastLED.clear();
+  clearFramebuffer();
 
   // Draw border
   for (int y = 0; y < HEIGHT; ++y) {
@@ -718,6 +904,7 @@ void SnakeGame::draw() const {
     setLed(body[i][0] + START_COLUMN, body[i][1], CHSV(hueIterable, 255, 255));
     hueIterable += 10;
   }
+  showFramebuffer();
 }
 
 BasicSpiral::BasicSpiral(ColorGenerator& colorGenerator_) : colorGenerator(colorGenerator_), time(0) {}
@@ -747,5 +934,6 @@ int BasicSpiral::animate() {
       setLed(x, y, colorGenerator.getColor(v));
     }
   }
+  showFramebuffer();
   return 40;
 }
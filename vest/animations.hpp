@@ -4,6 +4,7 @@
 #include <cstdint>
 
 #include "constants.hpp"
+#include "soundAnalyzer.hpp"
 
 using std::uint16_t;
 using std::uint32_t;
@@ -11,52 +12,92 @@ using std::uint8_t;
 
 class CRGB;
 
-// Hue generator
+// Hue generator. Each generator has a palette of PALETTE_SIZE colors that
+// go around the 16 bit value circle. Call prepare() once per frame, then
+// map() looks the colors up, which is a lot cheaper than working each one out
+// per pixel.
 class ColorGenerator {
   public:
+    static const int PALETTE_SIZE = 1024;
+    // How many values share each palette color
+    static const int PALETTE_STEP = 65536 / PALETTE_SIZE;
+
     ColorGenerator() = default;
     ~ColorGenerator() = default;
-    virtual CRGB getColor(uint8_t v);
-    virtual CRGB getColor(uint16_t v);
+    // The hue wheel, for animations that only have 8 bits of value. This
+    // doesn't use the palette.
+    CRGB getColor(uint8_t v);
+    // Builds the palette if it's out of date, and moves generators that
+    // change over time along one frame
+    void prepare();
+    // Sets out[i] to the palette color nearest to values[i], or to the exact
+    // color for generators that don't use the palette. Call prepare() first.
+    void map(const uint16_t* values, CRGB* out, int count) const;
+
+  protected:
+    // The exact color for value, which prepare() samples for the palette
+    virtual CRGB computeColor(uint16_t value) const;
+    // Called once per frame. Returns true if the colors changed, so the
+    // palette needs to be built again.
+    virtual bool advance() { return false; }
+    // The nearest palette color is only close to the exact one if the colors
+    // change smoothly. Generators that jump from one color to another return
+    // false, and map() works out every color instead.
+    virtual bool usesPalette() const { return true; }
+
+  private:
+    CRGB palette[PALETTE_SIZE];
+    bool prepared = false;
 };
 
 class RedGreenGenerator : public ColorGenerator {
   public:
     RedGreenGenerator() = default;
     ~RedGreenGenerator() = default;
-    CRGB getColor(uint16_t value);
+  protected:
+    CRGB computeColor(uint16_t value) const override;
 };
 
 class PastelGenerator : public ColorGenerator {
   public:
     PastelGenerator() = default;
     ~PastelGenerator() = default;
-    CRGB getColor(uint16_t value);
+  protected:
+    CRGB computeColor(uint16_t value) const override;
 };
 
 class NeonGenerator : public ColorGenerator {
   public:
     NeonGenerator() = default;
     ~NeonGenerator() = default;
-    CRGB getColor(uint16_t value);
+  protected:
+    CRGB computeColor(uint16_t value) const override;
 };
 
 class ChangingGenerator : public ColorGenerator {
   public:
+    // This used to move along 6 every time it looked up a color, so it
+    // changed faster when more pixels were drawn. This is about the same
+    // speed as that was when every grid LED was drawn once per frame.
+    static const uint32_t TIMER_STEP = 6 * GRID_LED_COUNT;
+
     ChangingGenerator() = default;
     ~ChangingGenerator() = default;
-    CRGB getColor(uint16_t value);
+  protected:
+    CRGB computeColor(uint16_t value) const override;
+    bool advance() override;
   private:
-    uint32_t timer;
+    uint32_t timer = 0;
 };
 
 class ChristmasGenerator : public ColorGenerator {
   public:
     ChristmasGenerator() = default;
     ~ChristmasGenerator() = default;
-    CRGB getColor(uint16_t value);
-  private:
-    uint32_t timer;
+  protected:
+    CRGB computeColor(uint16_t value) const override;
+    // Goes straight between red, green and white
+    bool usesPalette() const override { return false; }
 };
 
 class Animation {
@@ -69,8 +110,23 @@ class Animation {
     virtual ~Animation() = default;
     virtual void reset() {}
 
+    // Draws into the framebuffer. Coordinates outside the grid are ignored.
     static void setLed(int x, int y, const CRGB& color);
     static void setLed(int index, const CRGB& color);
+
+  protected:
+    // Animations that work in x, y draw into this and then call
+    // showFramebuffer(). Every cell is there, even the ones without LEDs, so
+    // drawing doesn't have to check anything per pixel.
+    static CRGB framebuffer[LED_COLUMN_COUNT][LED_ROW_COUNT];
+
+    static void clearFramebuffer();
+    // Copies the cells that have LEDs into leds[]
+    static void showFramebuffer();
+    // For animations that draw straight into leds[]. FastLED.clear() only
+    // clears the controllers added with FastLED.addLeds(), and with
+    // PARALLEL_OUTPUT there aren't any.
+    static void clearLeds();
 };
 
 class Count : public Animation {
@@ -137,13 +193,16 @@ class Shine : public Animation {
     uint8_t hues[LED_COUNT];
 };
 
+// Bars for each band of the microphone, that flash on the beat
 class SpectrumAnalyzer1 : public Animation {
   public:
-    SpectrumAnalyzer1(int (*soundFunction)(void));
+    SpectrumAnalyzer1(void (*soundFunction)(SoundLevels*));
     ~SpectrumAnalyzer1() = default;
     int animate() override;
   private:
-    int (*soundFunction)(void);
+    void (*soundFunction)(SoundLevels*);
+    uint32_t lastBeatCount;
+    uint8_t beatBrightness;
 };
 
 class Blobs : public Animation {
@@ -179,17 +238,30 @@ class PlasmaBidoulle : public Animation {
     ~PlasmaBidoulle() = default;
     int animate() override;
   private:
-    float time;
-    const float multiplier;
-    const float timeIncrement;
-    const float redMultiplier;
-    const float greenMultiplier;
-    const float blueMultiplier;
-    const float redOffset;
-    const float greenOffset;
-    const float blueOffset;
-
-    static uint8_t convert(const float f);
+    // This is all fixed point. Angles are sin16 angles shifted up 16 bits, so
+    // 2^32 is all the way around and they wrap on their own. time is in the
+    // same units, but keeps counting up instead of wrapping, because the
+    // plasma also uses time / 3 and time / 5.
+    uint64_t time;
+    const uint32_t multiplier;  // Angle per unit
+    const uint32_t timeIncrement;
+    // 32767 is 1
+    const int16_t redMultiplier;
+    const int16_t greenMultiplier;
+    const int16_t blueMultiplier;
+    // sin16 angles
+    const uint16_t redOffset;
+    const uint16_t greenOffset;
+    const uint16_t blueOffset;
+
+    // The ring term is sin(multiplier * sqrt(cx * cx + cy * cy + 1) + time).
+    // cx is at most 1 and cy is at most LED_ROW_COUNT - 0.5, so the part
+    // before time only depends on a squared distance in that range. This
+    // table has it as a sin16 angle for every 1/8 of squared distance.
+    static const int RING_ANGLE_COUNT = 16 + 2 * (2 * LED_ROW_COUNT - 1) * (2 * LED_ROW_COUNT - 1) + 2;
+    uint16_t ringAngles[RING_ANGLE_COUNT];
+
+    void fillRingAngles();
 };
 
 
@@ -10,9 +10,25 @@ const uint16_t PI_16_1_0 = 1.0 / (3.14159 * 2) * 65536;
 
 const int SD_PIN = 5;
 
+// I2S microphone. It's the same one as in piddle, but piddle's pins are the SD
+// card's SPI pins here.
+const int MICROPHONE_CLOCK_PIN = 26;
+const int MICROPHONE_WORD_SELECT_PIN = 25;
+const int MICROPHONE_DATA_PIN = 33;
+
 // Generated from offsets.py
 #include "offsets.hpp"
 
+// The strands, in the same order as the LEDs in offsets.hpp
+constexpr int LED_PINS[] = {17, 21, 4, 0, 15};
+static_assert(COUNT_OF(LED_PINS) == STRAND_COUNT, "Every strand needs a pin");
+
+// I2SClocklessLedDriver wants these defined. NUMSTRIPS is used in #if, so it
+// has to be a plain number.
+#define NUM_LEDS_PER_STRIP LONGEST_STRAND_LED_COUNT
+#define NUMSTRIPS 5
+static_assert(NUMSTRIPS == STRAND_COUNT, "Update NUMSTRIPS to match offsets.hpp");
+
 // This is off-center because I have more LEDs on one side
 const int X_CENTER = LED_COLUMN_COUNT / 2 + 1;
 const int Y_CENTER = LED_ROW_COUNT / 2;
@@ -0,0 +1,84 @@
+#ifndef FAST_LED_H
+#define FAST_LED_H
+
+// Just enough of FastLED and Arduino to build animations.cpp on a computer
+// for the benchmark. sin16, cos16 and sqrt16 are the same as in demo.cpp, so
+// the plasmas come out the same as they do on the vest. The HSV colors are
+// only close.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#define PROGMEM
+
+using std::max;
+using std::min;
+
+typedef uint8_t fract8;
+
+uint32_t millis();
+
+int16_t sin16(uint16_t theta);
+uint8_t sqrt16(uint16_t value);
+
+inline int16_t cos16(const uint16_t theta) {
+  return sin16(theta + 65536 / 4);
+}
+
+inline uint8_t random8() {
+  return rand();
+}
+
+struct CHSV {
+  uint8_t h;
+  uint8_t s;
+  uint8_t v;
+
+  CHSV(const uint8_t hue, const uint8_t saturation, const uint8_t value) : h(hue), s(saturation), v(value) {}
+};
+
+struct CRGB {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+
+  enum HTMLColorCode : uint32_t {
+    Aquamarine = 0x7FFFD4,
+    Black = 0x000000,
+    Gray = 0x808080,
+    Red = 0xFF0000,
+    Yellow = 0xFFFF00,
+  };
+
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(const uint8_t red, const uint8_t green, const uint8_t blue) : r(red), g(green), b(blue) {}
+  CRGB(const uint32_t code) : r(code >> 16), g(code >> 8), b(code) {}
+  CRGB(const HTMLColorCode code) : CRGB(static_cast<uint32_t>(code)) {}
+  CRGB(const CHSV& hsv);
+
+  explicit operator bool() const {
+    return r != 0 || g != 0 || b != 0;
+  }
+
+  bool operator==(const CRGB& other) const {
+    return r == other.r && g == other.g && b == other.b;
+  }
+};
+
+void hsv2rgb_raw(const CHSV& hsv, CRGB& rgb);
+CRGB blend(const CRGB& from, const CRGB& to, fract8 amount);
+void fill_rainbow(CRGB* leds, int count, uint8_t hue);
+void fill_solid(CRGB* leds, int count, const CRGB& color);
+
+struct CFastLED {
+  // Like FastLED, this only clears the LEDs of controllers that were added.
+  // With PARALLEL_OUTPUT the vest doesn't add any, so it does nothing.
+  void clear();
+  bool controllersAdded = true;
+};
+extern CFastLED FastLED;
+
+#endif  // FAST_LED_H
@@ -0,0 +1,570 @@
+// Times the vest plasmas on a computer. It builds the real animations.cpp
+// against the stand-in FastLED.h in this directory, and also keeps copies of
+// the plasmas as they first were, when they looked at every cell in the grid,
+// worked out every term for every pixel, and checked XY_TO_OFFSET. It checks
+// that both draw the same LEDs, and then times them.
+//
+// PlasmaBidoulle's original is the float version it was adapted from, and
+// PlasmaBidoulleFast is an approximation of that, so compare all three.
+//
+// It also keeps copies of the color generators from before they had palettes,
+// and checks that every palette color is exactly what the old generator gave
+// for that value, and that every other value is close.
+//
+// The animations that draw straight into leds[] are run both with and
+// without FastLED controllers, which is the difference between the vest's two
+// output modes, to check that they draw the same either way.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+
+#include "../animations.hpp"
+#include "../constants.hpp"
+
+static const int FRAME_COUNT = 5000;
+
+CRGB leds[LED_COUNT];
+CFastLED FastLED;
+
+// The color generators from before they had palettes. The changing one took
+// its timer as a member and moved it along on every call.
+
+static CRGB originalHue(const uint16_t v, uint32_t&) {
+  CRGB crgb;
+  hsv2rgb_raw(CHSV(v / 256, 255, 255), crgb);
+  return crgb;
+}
+
+static CRGB originalRedGreen(const uint16_t v, uint32_t&) {
+  const uint8_t red = (sin16(v) / 256) + 128;
+  const uint8_t green = (cos16(v) / 256) + 128;
+  const uint8_t blue = 0;
+  return CRGB(red, green, blue);
+}
+
+static CRGB originalPastel(const uint16_t v, uint32_t&) {
+  const uint8_t red = 255;
+  const uint8_t green = (cos16(v) / 256) + 128;
+  const uint8_t blue = (sin16(v) / 256) + 128;
+  return CRGB(red, green, blue);
+}
+
+static CRGB originalNeon(const uint16_t v, uint32_t&) {
+  const uint8_t red = (sin16(v) / 256) + 128;
+  const uint8_t green = (sin16(v + 2 * 32768 / 3) / 256) + 128;
+  const uint8_t blue = (sin16(v + 4 * 32768 / 3) / 256) + 128;
+  return CRGB(red, green, blue);
+}
+
+static CRGB originalChanging(const uint16_t v, uint32_t& timer) {
+  timer += 6;
+  const uint16_t redOffset = sin16(timer / 13) + 32768;
+  const uint16_t greenOffset = sin16(timer / 17) + 32768;
+  const uint16_t blueOffset = sin16(timer / 19) + 32768;
+  const uint8_t red = (sin16(v + redOffset) / 256) + 128;
+  const uint8_t green = (sin16(v + greenOffset) / 256) + 128;
+  const uint8_t blue = (sin16(v + blueOffset) / 256) + 128;
+  return CRGB(red, green, blue);
+}
+
+static CRGB originalChristmas(const uint16_t v, uint32_t&) {
+  uint8_t red = (sin16(v) / 256) + 128;
+  if (red < 128) {
+    red = 0;
+  }
+  uint8_t green = (sin16(v + 2 * 32768 / 3) / 256) + 128;
+  if (green < 128 || red >= 128) {
+    green = 0;
+  }
+  uint8_t blue = 0;
+  if (red == 0 && green == 0 && blue == 0) {
+    red = green = blue = 255;
+  }
+  return CRGB(red, green, blue);
+}
+
+typedef CRGB (*OriginalGenerator)(uint16_t v, uint32_t& timer);
+
+
+// The original versions draw in here
+static CRGB originalLeds[LED_COUNT];
+
+static void setOriginalLed(const int x, const int y, const CRGB& color) {
+  if (x >= 0 && x < LED_COLUMN_COUNT) {
+    if (y >= 0 && y < LED_ROW_COUNT) {
+      const auto offset = XY_TO_OFFSET[x][y];
+      if (offset != UNUSED_LED) {
+        originalLeds[offset] = color;
+      }
+    }
+  }
+}
+
+
+class OriginalPlasma1 : public Animation {
+  public:
+    OriginalPlasma1(ColorGenerator& colorGenerator_) : colorGenerator(colorGenerator_), time(0) {}
+
+    int animate() override {
+      for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
+        for (int y = 0; y < LED_ROW_COUNT; ++y) {
+          const auto index = XY_TO_OFFSET[x][y];
+          if (index != UNUSED_LED) {
+            const uint8_t p1 = 128 + (sin16(x * (PI_16_1_0 / 4) + time / 4)) / 256;
+            const uint8_t p2 = 128 + (sin16(y * (PI_16_1_0 / 4) + time / 4)) / 256;
+            const uint8_t p3 =
+              128 + (sin16((x + y) * (PI_16_1_0 / 8) + time / 8)) / 256;
+            const uint8_t p4 =
+              128 + (sin16(sqrt16(x * x + y * y) * 1000 + time)) / 256;
+            const uint8_t v = (p1 + p2 + p3 + p4) / 4;
+            setOriginalLed(x, y, colorGenerator.getColor(v));
+          }
+        }
+      }
+      time += 1000;
+      return 10;
+    }
+
+  private:
+    ColorGenerator& colorGenerator;
+    int time;
+};
+
+
+// Plasma2 and Plasma3 are the same
+class OriginalPlasma3 : public Animation {
+  public:
+    OriginalPlasma3(ColorGenerator& colorGenerator_) : colorGenerator(colorGenerator_), time(0) {}
+
+    int animate() override {
+      for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
+        for (int y = 0; y < LED_ROW_COUNT; ++y) {
+          const auto index = XY_TO_OFFSET[x][y];
+          if (index != UNUSED_LED) {
+            const uint8_t p1 = 128 + (sin16(x * (PI_16_1_0 / 8) + time / 4)) / 256;
+            const uint8_t p2 = 128 + sin16(10 * (x * sin16(time / 2) / 256 +
+                                                 y * cos16(time / 3) / 256)) /
+                               256;
+            const uint8_t p3 =
+              128 + (sin16((x + y) * (PI_16_1_0 / 8) + time / 8)) / 256;
+            const uint16_t cx = x + sin16(time / 8) / 1024;
+            const uint16_t cy = y + sin16(time / 16) / 1024;
+            const uint8_t p4 =
+              128 +
+              sin16(sqrt16(cx * cx + cy * cy) * (PI_16_1_0 / 2) + time) / 512;
+            const uint8_t v = (p1 + p2 + p3 + p4) / 4;
+            setOriginalLed(x, y, colorGenerator.getColor(v));
+          }
+        }
+      }
+      time += 1000;
+      return 10;
+    }
+
+  private:
+    ColorGenerator& colorGenerator;
+    int time;
+};
+
+
+class OriginalPlasmaBidoulleFast : public Animation {
+  public:
+    OriginalPlasmaBidoulleFast(OriginalGenerator getColor_) : getColor(getColor_), time(0), timer(0) {}
+
+    int animate() override {
+      const uint16_t multiplier = 0.15f * PI_16_1_0;
+      const uint16_t timeIncrement = 0.1f * PI_16_1_0;
+      const int blend = 64;
+      const int xSin = sin16(time / 2);
+      const int xOffset = xSin / 4096;
+      const int xRemainder = (xSin % 4096) / blend;
+      const int ySin = sin16(time / 3);
+      const int yOffset = ySin / 8192;
+
+      time += timeIncrement;
+      for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
+        const int16_t v1 = sin16(multiplier * x + time);
+        for (int y = 0; y < LED_ROW_COUNT; ++y) {
+          if (XY_TO_OFFSET[x][y] != UNUSED_LED) {
+            const int16_t v2 = sin16(
+                                 (multiplier * (x * sin16(time / 4) / 2 + y * cos16(time / 3)) +
+                                  time) /
+                                 16384);
+            const int adjustedX = x + xOffset + X_CENTER;
+            const int adjustedY = y + yOffset + Y_CENTER;
+            const uint16_t blend1 = bidoulleV3rings[adjustedX][adjustedY] * (blend - xRemainder) / blend;
+            const uint16_t blend2 = bidoulleV3rings[adjustedX + 1][adjustedY] * xRemainder / blend;
+            const uint16_t v3 = (blend1 + blend2) / 2 * 256;
+            const uint16_t v = v1 + v2 + v3;
+            setOriginalLed(x, y, getColor(v, timer));
+          }
+        }
+      }
+      return 20;
+    }
+
+  private:
+    OriginalGenerator getColor;
+    uint32_t time;
+    uint32_t timer;
+};
+
+
+class OriginalPlasmaBidoulle : public Animation {
+  public:
+    OriginalPlasmaBidoulle(const float multiplier_, const float timeIncrement_) :
+      frame(0), time(0), multiplier(multiplier_), timeIncrement(timeIncrement_) {}
+
+    int animate() override {
+      const float M_PI_F = static_cast<float>(M_PI);
+      const float greenOffset = 2.0f / 3.0f * M_PI;
+      const float blueOffset = 4.0f / 3.0f * M_PI;
+      const auto convert = [](const float f) {
+        return static_cast<uint8_t>((f + 1.0f) * 0.5f * 255.0f);
+      };
+
+      // This used to be time += timeIncrement, but adding up floats drifts
+      // by a few hundredths after a few thousand frames, which would count
+      // against the fixed point version
+      ++frame;
+      time = frame * timeIncrement;
+      float cys[LED_ROW_COUNT];
+      for (int y = 0; y < LED_ROW_COUNT; ++y) {
+        cys[y] = y + 0.5f * cosf(time * (1.0f / 3.0f));
+      }
+      for (int x = 0; x < LED_COLUMN_COUNT; ++x) {
+        const float v1 = sinf(multiplier * x + time);
+        const float cx = sinf(x + 0.5 * sinf(time * 0.2f));
+        for (int y = 0; y < LED_ROW_COUNT; ++y) {
+          if (XY_TO_OFFSET[x][y] != UNUSED_LED) {
+            const float v2 = sinf(multiplier * (x * sinf(time * 0.5f) +
+                                                y * cosf(time * (1.0f / 3.0f))) +
+                                  time);
+            const float v3 =
+              sinf(multiplier * sqrtf((cx * cx + cys[y] * cys[y] + 1.0f)) + time);
+            const float v = v1 + v2 + v3;
+            setOriginalLed(x, y, CRGB(
+              convert(sinf(v * M_PI_F)),
+              convert(sinf(v * M_PI_F + greenOffset)),
+              convert(sinf(v * M_PI_F + blueOffset))));
+          }
+        }
+      }
+      return 0;
+    }
+
+  private:
+    int frame;
+    float time;
+    const float multiplier;
+    const float timeIncrement;
+};
+
+
+static ColorGenerator hueGenerator;
+static RedGreenGenerator redGreenGenerator;
+static PastelGenerator pastelGenerator;
+static NeonGenerator neonGenerator;
+static ChangingGenerator changingGenerator;
+static ChristmasGenerator christmasGenerator;
+
+static Plasma1 plasma1(hueGenerator);
+static OriginalPlasma1 originalPlasma1(hueGenerator);
+static Plasma2 plasma2(hueGenerator);
+static OriginalPlasma3 originalPlasma2(hueGenerator);
+static Plasma3 plasma3(hueGenerator);
+static OriginalPlasma3 originalPlasma3(hueGenerator);
+static PlasmaBidoulleFast bidoulleFast(neonGenerator);
+static OriginalPlasmaBidoulleFast originalBidoulleFast(originalNeon);
+static PlasmaBidoulle bidoulle(0.15f, 0.1f);
+static OriginalPlasmaBidoulle originalBidoulle(0.15f, 0.1f);
+
+struct Comparison {
+  const char* name;
+  Animation* animation;
+  Animation* original;
+  // The palettes round values to the nearest color, which moves the neon
+  // colors by at most 1. PlasmaBidoulle used to be floats and is now fixed
+  // point, so it's a little off.
+  int maximumDifference;
+};
+
+static const Comparison COMPARISONS[] = {
+  {"Plasma1", &plasma1, &originalPlasma1, 0},
+  {"Plasma2", &plasma2, &originalPlasma2, 0},
+  {"Plasma3", &plasma3, &originalPlasma3, 0},
+  {"PlasmaBidoulleFast", &bidoulleFast, &originalBidoulleFast, 1},
+  {"PlasmaBidoulle", &bidoulle, &originalBidoulle, 2},
+};
+
+struct GeneratorComparison {
+  const char* name;
+  ColorGenerator* generator;
+  OriginalGenerator original;
+  // For values between palette colors
+  int maximumDifference;
+};
+
+// Hue only changes every 256 values, but a channel moves 4 when it does.
+// Christmas doesn't use the palette, so it has to match exactly.
+static const GeneratorComparison GENERATOR_COMPARISONS[] = {
+  {"Hue", &hueGenerator, originalHue, 4},
+  {"RedGreen", &redGreenGenerator, originalRedGreen, 1},
+  {"Pastel", &pastelGenerator, originalPastel, 1},
+  {"Neon", &neonGenerator, originalNeon, 1},
+  {"Changing", &changingGenerator, originalChanging, 1},
+  {"Christmas", &christmasGenerator, originalChristmas, 0},
+};
+
+
+static int difference(const CRGB& first, const CRGB& second) {
+  const auto channel = [](const uint8_t a, const uint8_t b) {
+    return a > b ? a - b : b - a;
+  };
+  return std::max({channel(first.r, second.r), channel(first.g, second.g), channel(first.b, second.b)});
+}
+
+
+static int largestDifference(const CRGB* const first, const CRGB* const second, const int count) {
+  int largest = 0;
+  for (int i = 0; i < count; ++i) {
+    largest = std::max(largest, difference(first[i], second[i]));
+  }
+  return largest;
+}
+
+
+static int totalDifference(const CRGB* const first, const CRGB* const second, const int count) {
+  int total = 0;
+  for (int i = 0; i < count; ++i) {
+    total += std::abs(first[i].r - second[i].r);
+    total += std::abs(first[i].g - second[i].g);
+    total += std::abs(first[i].b - second[i].b);
+  }
+  return total;
+}
+
+
+// Checks every palette color against the old generator, over a few frames
+// so that the changing generator moves, and every other value against the
+// comparison's maximumDifference. Sets largest to the biggest difference
+// between map() and the old generator for any value, which comes from
+// rounding to the palette.
+static bool checkGenerator(const GeneratorComparison& comparison, int* const largest) {
+  static uint16_t values[65536];
+  static CRGB colors[65536];
+  for (int v = 0; v < 65536; ++v) {
+    values[v] = v;
+  }
+
+  uint32_t timer = 0;
+  *largest = 0;
+  for (int frame = 0; frame < 10; ++frame) {
+    comparison.generator->prepare();
+    comparison.generator->map(values, colors, 65536);
+    timer += ChangingGenerator::TIMER_STEP;
+    for (int v = 0; v < 65536; ++v) {
+      // The old changing generator moved its timer along 6 before working
+      // out each color, so start it 6 short of where prepare() moved it to
+      uint32_t originalTimer = timer - 6;
+      const CRGB original = comparison.original(v, originalTimer);
+      if (v % ColorGenerator::PALETTE_STEP == 0 && !(colors[v] == original)) {
+        printf("%s palette is different for %d on frame %d\n", comparison.name, v, frame);
+        return false;
+      }
+      const int off = difference(colors[v], original);
+      *largest = std::max(*largest, off);
+      if (off > comparison.maximumDifference) {
+        printf("%s is off by %d for %d on frame %d\n", comparison.name, off, v, frame);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+
+struct OutputModeComparison {
+  const char* name;
+  Animation* (*make)();
+};
+
+static const OutputModeComparison OUTPUT_MODE_COMPARISONS[] = {
+  {"Count", []() -> Animation* { return new Count(); }},
+  {"CountXY", []() -> Animation* { return new CountXY(); }},
+  {"Snake", []() -> Animation* { return new Snake(20); }},
+  {"Shine", []() -> Animation* { return new Shine(); }},
+};
+
+// Runs a new one of the animation with and without controllers, so that
+// FastLED.clear() does and doesn't clear leds[], and checks that every frame
+// comes out the same
+static bool checkOutputModes(const OutputModeComparison& comparison) {
+  const int frameCount = 1000;
+  static CRGB withControllers[frameCount][LED_COUNT];
+  for (const bool controllersAdded : {true, false}) {
+    FastLED.controllersAdded = controllersAdded;
+    fill_solid(leds, LED_COUNT, CRGB::Black);
+    srand(1);
+    Animation* const animation = comparison.make();
+    for (int frame = 0; frame < frameCount; ++frame) {
+      animation->animate();
+      if (controllersAdded) {
+        std::copy(leds, leds + LED_COUNT, withControllers[frame]);
+      } else if (largestDifference(leds, withControllers[frame], LED_COUNT) != 0) {
+        printf("%s is different without controllers on frame %d\n", comparison.name, frame);
+        delete animation;
+        FastLED.controllersAdded = true;
+        return false;
+      }
+    }
+    delete animation;
+  }
+  FastLED.controllersAdded = true;
+  // The plasmas don't draw the LEDs that aren't on the grid, and they're
+  // compared with a copy that starts off black
+  fill_solid(leds, LED_COUNT, CRGB::Black);
+  return true;
+}
+
+
+static double nanosecondsPerFrame(Animation* const animation) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FRAME_COUNT; ++i) {
+    animation->animate();
+  }
+  const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / FRAME_COUNT;
+}
+
+
+int main() {
+  bool matches = true;
+  printf("%-20s %12s\n", "generator", "largest difference");
+  for (const auto& comparison : GENERATOR_COMPARISONS) {
+    int largest = 0;
+    if (!checkGenerator(comparison, &largest)) {
+      matches = false;
+    }
+    printf("%-20s %12d\n", comparison.name, largest);
+  }
+  printf("\n");
+
+  printf("%-20s %12s\n", "output modes", "");
+  for (const auto& comparison : OUTPUT_MODE_COMPARISONS) {
+    const bool same = checkOutputModes(comparison);
+    matches = matches && same;
+    printf("%-20s %12s\n", comparison.name, same ? "same" : "different");
+  }
+  printf("\n");
+
+  printf("%-20s %12s %12s\n", "animation", "largest", "average");
+  for (const auto& comparison : COMPARISONS) {
+    int largest = 0;
+    double total = 0.0;
+    for (int frame = 0; frame < FRAME_COUNT; ++frame) {
+      comparison.animation->animate();
+      comparison.original->animate();
+      const int difference = largestDifference(leds, originalLeds, LED_COUNT);
+      if (difference > comparison.maximumDifference) {
+        printf("%s is off by %d on frame %d\n", comparison.name, difference, frame);
+        matches = false;
+      }
+      largest = std::max(largest, difference);
+      total += totalDifference(leds, originalLeds, LED_COUNT);
+    }
+    printf("%-20s %12d %12.2f\n", comparison.name, largest, total / FRAME_COUNT / GRID_LED_COUNT / 3);
+  }
+  printf("\n");
+
+  printf("%-20s %12s %12s\n", "ns/frame", "original", "now");
+  for (const auto& comparison : COMPARISONS) {
+    const double original = nanosecondsPerFrame(comparison.original);
+    const double now = nanosecondsPerFrame(comparison.animation);
+    printf("%-20s %12.0f %12.0f\n", comparison.name, original, now);
+  }
+  return matches ? 0 : 1;
+}
+
+
+// The rest of the FastLED stand-in
+
+uint32_t millis() {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void CFastLED::clear() {
+  if (controllersAdded) {
+    fill_solid(leds, LED_COUNT, CRGB::Black);
+  }
+}
+
+void fill_solid(CRGB* const leds, const int count, const CRGB& color) {
+  std::fill(leds, leds + count, color);
+}
+
+int16_t sin16(const uint16_t theta) {
+  static const uint16_t base[] = {0, 6393, 12539, 18204, 23170, 27245, 30273, 32137};
+  static const uint8_t slope[] = {49, 48, 44, 38, 31, 23, 14, 4};
+
+  uint16_t offset = (theta & 0x3FFF) >> 3;  // 0..2047
+  if (theta & 0x4000) {
+    offset = 2047 - offset;
+  }
+  const uint8_t section = offset / 256;  // 0..7
+  const uint8_t secoffset8 = static_cast<uint8_t>(offset) / 2;
+  int16_t y = slope[section] * secoffset8 + base[section];
+  if (theta & 0x8000) {
+    y = -y;
+  }
+  return y;
+}
+
+uint8_t sqrt16(const uint16_t value) {
+  uint8_t x = 0;
+  if (value > 65536 / 3) {
+    return 255;
+  }
+  while (x * x < value) {
+    ++x;
+  }
+  return x;
+}
+
+// Red, green and blue each take a third of the hues
+void hsv2rgb_raw(const CHSV& hsv, CRGB& rgb) {
+  const uint8_t hue = hsv.h * 3 / 4;  // 0..191
+  const uint8_t rampUp = (hue % 64) * 4;
+  const uint8_t rampDown = 255 - rampUp;
+  uint8_t channels[3] = {0, 0, 0};
+  const int section = hue / 64;
+  channels[section] = rampDown;
+  channels[(section + 1) % 3] = rampUp;
+  const auto scale = [&hsv](const uint8_t channel) -> uint8_t {
+    const int white = 255 - hsv.s;
+    return (channel * hsv.s / 255 + white) * hsv.v / 255;
+  };
+  rgb = CRGB(scale(channels[0]), scale(channels[1]), scale(channels[2]));
+}
+
+CRGB::CRGB(const CHSV& hsv) : r(0), g(0), b(0) {
+  hsv2rgb_raw(hsv, *this);
+}
+
+CRGB blend(const CRGB& from, const CRGB& to, const fract8 amount) {
+  const auto mix = [amount](const uint8_t a, const uint8_t b) -> uint8_t {
+    return (a * (256 - amount) + b * amount) >> 8;
+  };
+  return CRGB(mix(from.r, to.r), mix(from.g, to.g), mix(from.b, to.b));
+}
+
+void fill_rainbow(CRGB* const leds, const int count, uint8_t hue) {
+  for (int i = 0; i < count; ++i) {
+    leds[i] = CHSV(hue, 255, 255);
+    hue += 5;
+  }
+}
@@ -0,0 +1,195 @@
+// Decodes .anim movies on a computer, to check what video.py writes. It
+// prints the header and checks that every frame decodes, both in order and
+// by seeking through the index, and that a frame with its last byte cut off
+// doesn't. If there's a .rgb file of what the frames should be, which
+// video.py --test-corpus writes next to each movie, it checks the pixels too.
+// Then it prints how many bytes a second the SD card would have to read to
+// play it, and how long decoding a frame takes.
+//
+//     python3 ../video/video.py --test-corpus corpus
+//     ./movie corpus/*.anim
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../movieFormat.hpp"
+
+static bool readFile(const std::string& path, std::vector<uint8_t>* const contents) {
+  FILE* const file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  uint8_t buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    contents->insert(contents->end(), buffer, buffer + read);
+  }
+  fclose(file);
+  return true;
+}
+
+
+// Decodes the frame that starts at offset. Delta frames change what's already
+// in pixels. Returns false if it's bad.
+static bool decodeAt(
+  const std::vector<uint8_t>& movie,
+  const uint32_t offset,
+  const size_t pixelCount,
+  std::vector<uint8_t>* const pixels,
+  size_t* const size
+) {
+  if (offset + MOVIE_FRAME_HEADER_SIZE > movie.size()) {
+    return false;
+  }
+  const uint8_t type = movie[offset];
+  *size = readLittleEndian16(&movie[offset + 1]);
+  const uint32_t dataOffset = offset + MOVIE_FRAME_HEADER_SIZE;
+  if (dataOffset + *size > movie.size()) {
+    return false;
+  }
+  // Cutting off the last byte should always be caught. A delta that doesn't
+  // change anything is empty, so there's nothing to cut off.
+  std::vector<uint8_t> scratch(*pixels);
+  if (*size > 0 && decodeMovieFrame(type, &movie[dataOffset], *size - 1, scratch.data(), pixelCount)) {
+    return false;
+  }
+  return decodeMovieFrame(type, &movie[dataOffset], *size, pixels->data(), pixelCount);
+}
+
+
+static bool check(const std::string& path) {
+  std::vector<uint8_t> movie;
+  if (!readFile(path, &movie)) {
+    printf("%s: couldn't read it\n", path.c_str());
+    return false;
+  }
+  MovieHeader header;
+  if (movie.size() < MOVIE_HEADER_SIZE || !parseMovieHeader(movie.data(), &header)) {
+    printf("%s: not a movie\n", path.c_str());
+    return false;
+  }
+  const size_t pixelCount = header.width * header.height;
+  const size_t frameSize = pixelCount * 3;
+  if (header.indexOffset + static_cast<size_t>(header.frameCount) * MOVIE_INDEX_ENTRY_SIZE != movie.size()) {
+    printf("%s: the index doesn't end at the end of the file\n", path.c_str());
+    return false;
+  }
+
+  std::vector<uint8_t> expected;
+  const std::string expectedPath = path.substr(0, path.rfind('.')) + ".rgb";
+  const bool haveExpected = readFile(expectedPath, &expected);
+  if (haveExpected && expected.size() != header.frameCount * frameSize) {
+    printf("%s: %s has %zu frames, not %u\n", path.c_str(), expectedPath.c_str(), expected.size() / frameSize, header.frameCount);
+    return false;
+  }
+
+  // In order, the way the vest reads them
+  std::vector<uint8_t> pixels(frameSize);
+  uint32_t offset = MOVIE_HEADER_SIZE;
+  size_t encodedSize = 0;
+  int typeCounts[4] = {};
+  for (uint32_t frame = 0; frame < header.frameCount; ++frame) {
+    const uint32_t entry = readLittleEndian32(&movie[header.indexOffset + frame * MOVIE_INDEX_ENTRY_SIZE]);
+    const bool keyFrame = offset < movie.size() && isMovieKeyFrame(movie[offset]);
+    if ((entry & ~MOVIE_KEY_FRAME) != offset || ((entry & MOVIE_KEY_FRAME) != 0) != keyFrame || (frame == 0 && !keyFrame)) {
+      printf("%s: index entry %u is %08x, expected %s at %u\n", path.c_str(), frame, entry, keyFrame ? "a key frame" : "a delta", offset);
+      return false;
+    }
+    if (movie[offset] < sizeof(typeCounts) / sizeof(typeCounts[0])) {
+      ++typeCounts[movie[offset]];
+    }
+    size_t size = 0;
+    if (!decodeAt(movie, offset, pixelCount, &pixels, &size)) {
+      printf("%s: frame %u is bad\n", path.c_str(), frame);
+      return false;
+    }
+    if (haveExpected && !std::equal(pixels.begin(), pixels.end(), expected.begin() + frame * frameSize)) {
+      printf("%s: frame %u has the wrong pixels\n", path.c_str(), frame);
+      return false;
+    }
+    offset += MOVIE_FRAME_HEADER_SIZE + size;
+    encodedSize += MOVIE_FRAME_HEADER_SIZE + size;
+  }
+  if (offset != header.indexOffset) {
+    printf("%s: the frames end at %u, but the index starts at %u\n", path.c_str(), offset, header.indexOffset);
+    return false;
+  }
+
+  // Backwards through the index, like seeking. Frames after a key frame have
+  // to be decoded from it.
+  for (uint32_t frame = header.frameCount; frame-- > 0;) {
+    uint32_t keyFrame = frame;
+    while (
+      (readLittleEndian32(&movie[header.indexOffset + keyFrame * MOVIE_INDEX_ENTRY_SIZE]) & MOVIE_KEY_FRAME) == 0
+    ) {
+      --keyFrame;
+    }
+    bool decoded = true;
+    for (uint32_t i = keyFrame; decoded && i <= frame; ++i) {
+      const uint32_t entry = readLittleEndian32(&movie[header.indexOffset + i * MOVIE_INDEX_ENTRY_SIZE]);
+      size_t size = 0;
+      decoded = decodeAt(movie, entry & ~MOVIE_KEY_FRAME, pixelCount, &pixels, &size);
+    }
+    if (!decoded || (haveExpected && !std::equal(pixels.begin(), pixels.end(), expected.begin() + frame * frameSize))) {
+      printf("%s: frame %u is wrong when seeking to it\n", path.c_str(), frame);
+      return false;
+    }
+  }
+
+  // Keep decoding the whole movie until it's been long enough to time
+  const auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::nano> elapsed(0);
+  uint32_t decodedFrames = 0;
+  while (elapsed.count() < 100e6) {
+    offset = MOVIE_HEADER_SIZE;
+    for (uint32_t frame = 0; frame < header.frameCount; ++frame) {
+      const uint16_t size = readLittleEndian16(&movie[offset + 1]);
+      decodeMovieFrame(movie[offset], &movie[offset + MOVIE_FRAME_HEADER_SIZE], size, pixels.data(), pixelCount);
+      offset += MOVIE_FRAME_HEADER_SIZE + size;
+    }
+    decodedFrames += header.frameCount;
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+
+  const double fps = 1e6 / header.microsPerFrame;
+  const double bytesPerFrame = static_cast<double>(encodedSize) / header.frameCount;
+  printf(
+    "%s: %dx%d, %u frames, %.2f fps, %.0f%% of raw%s\n",
+    path.c_str(),
+    header.width,
+    header.height,
+    header.frameCount,
+    fps,
+    100.0 * encodedSize / (header.frameCount * (frameSize + MOVIE_FRAME_HEADER_SIZE)),
+    haveExpected ? ", pixels match" : "");
+  printf(
+    "  %d raw, %d run length, %d delta, %d palette frames\n",
+    typeCounts[static_cast<int>(MovieFrameType::raw)],
+    typeCounts[static_cast<int>(MovieFrameType::runLength)],
+    typeCounts[static_cast<int>(MovieFrameType::delta)],
+    typeCounts[static_cast<int>(MovieFrameType::palette)]);
+  printf(
+    "  %.0f bytes/frame, %.0f bytes/s, %.0f bytes/s at 60 fps, %.0f ns/frame to decode\n",
+    bytesPerFrame,
+    bytesPerFrame * fps,
+    bytesPerFrame * 60,
+    elapsed.count() / decodedFrames);
+  return true;
+}
+
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s movie.anim...\n", argv[0]);
+    return 1;
+  }
+  bool passed = true;
+  for (int i = 1; i < argc; ++i) {
+    passed = check(argv[i]) && passed;
+  }
+  return passed ? 0 : 1;
+}
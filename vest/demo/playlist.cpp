@@ -0,0 +1,169 @@
+// Builds the vest's playlist from a directory on a computer, the same way the
+// vest does from the SD card, and checks that next, previous, and jump wrap
+// around. With a count, it first fills the directory with that many made up
+// movies, in a shuffled order and with some files that aren't movies mixed in,
+// and checks that it found all of them in order.
+//
+//     ./playlist movies 500
+//     ./playlist corpus
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "../movieFormat.hpp"
+#include "../playlist.hpp"
+
+static void writeLittleEndian32(uint8_t* const bytes, const uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    bytes[i] = value >> (i * 8);
+  }
+}
+
+
+// Only the header, because that's all the playlist reads
+static bool writeMovie(const std::string& path, const uint32_t frameCount) {
+  uint8_t header[MOVIE_HEADER_SIZE] = {'A', 'N', 'I', 'M', MOVIE_VERSION, 16, 15, 0};
+  writeLittleEndian32(header + 8, 50000);
+  writeLittleEndian32(header + 12, frameCount);
+  writeLittleEndian32(header + 16, MOVIE_HEADER_SIZE);
+  FILE* const file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool wrote = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+  return fclose(file) == 0 && wrote;
+}
+
+
+static bool fill(const std::string& directory, const int count) {
+  mkdir(directory.c_str(), 0755);
+  // Write them in a shuffled order, so the directory's order isn't already sorted
+  std::vector<int> order(count);
+  for (int i = 0; i < count; ++i) {
+    order[i] = i;
+  }
+  srand(1);
+  for (int i = count - 1; i > 0; --i) {
+    std::swap(order[i], order[rand() % (i + 1)]);
+  }
+  for (const int i : order) {
+    char name[32];
+    snprintf(name, sizeof(name), "/movie%04d.anim", i);
+    if (!writeMovie(directory + name, i + 1)) {
+      printf("Couldn't write %s%s\n", directory.c_str(), name);
+      return false;
+    }
+    if (i % 10 == 0) {
+      snprintf(name, sizeof(name), "/notes%04d.txt", i);
+      FILE* const file = fopen((directory + name).c_str(), "w");
+      if (file != nullptr) {
+        fputs("Not a movie\n", file);
+        fclose(file);
+      }
+    }
+  }
+  return true;
+}
+
+
+static void build(const std::string& directory, Playlist* const playlist) {
+  DIR* const dir = opendir(directory.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  uint8_t header[MOVIE_HEADER_SIZE];
+  for (const dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+    FILE* const file = fopen((directory + "/" + entry->d_name).c_str(), "rb");
+    if (file == nullptr) {
+      continue;
+    }
+    if (fread(header, 1, sizeof(header), file) == sizeof(header)) {
+      playlist->add(entry->d_name, header);
+    }
+    fclose(file);
+  }
+  closedir(dir);
+  playlist->sort();
+}
+
+
+static bool checkWrapping(const Playlist& built) {
+  Playlist playlist(built);
+  const int size = playlist.size();
+  const int last = size - 1;
+  bool passed = playlist.current() == 0
+    && playlist.previous() == last
+    && playlist.next() == 0
+    && playlist.jump(last) == last
+    && playlist.next() == 0
+    && playlist.jump(-1) == last
+    && playlist.jump(size) == 0
+    && playlist.jump(3 * size + 1) == 1 % size
+    && playlist.jump(-3 * size - 1) == last;
+  for (int i = 1; i < size; ++i) {
+    passed = passed && strcmp(playlist.name(i - 1), playlist.name(i)) < 0;
+  }
+  return passed;
+}
+
+
+int main(int argc, char* argv[]) {
+  if (argc != 2 && argc != 3) {
+    fprintf(stderr, "Usage: %s directory [count]\n", argv[0]);
+    return 1;
+  }
+  const std::string directory = argv[1];
+  const int count = argc == 3 ? atoi(argv[2]) : 0;
+  if (count > 0 && !fill(directory, count)) {
+    return 1;
+  }
+
+  Playlist playlist;
+  const auto start = std::chrono::steady_clock::now();
+  build(directory, &playlist);
+  const auto built = std::chrono::steady_clock::now();
+  printf(
+    "%s: %d movies, built in %.1f ms\n",
+    directory.c_str(),
+    playlist.size(),
+    std::chrono::duration<double, std::milli>(built - start).count());
+  if (playlist.size() == 0) {
+    printf("No movies\n");
+    return 1;
+  }
+
+  bool passed = checkWrapping(playlist);
+  if (count > 0) {
+    passed = passed && playlist.size() == count;
+    for (int i = 0; passed && i < count; ++i) {
+      char name[32];
+      snprintf(name, sizeof(name), "movie%04d.anim", i);
+      // 50 ms a frame, and movie i has i + 1 frames
+      passed = strcmp(playlist.name(i), name) == 0 && playlist.duration_ms(i) == static_cast<uint32_t>((i + 1) * 50);
+    }
+  }
+  printf(passed ? "Playlist is good\n" : "Playlist is wrong\n");
+
+  // Changing movies shouldn't depend on how many there are
+  const int steps = 1000000;
+  uint32_t total = 0;
+  const auto stepStart = std::chrono::steady_clock::now();
+  for (int i = 0; i < steps; ++i) {
+    total += i % 3 == 0 ? playlist.previous() : playlist.next();
+    total += playlist.name(playlist.current())[0];
+  }
+  const auto stepEnd = std::chrono::steady_clock::now();
+  printf(
+    "%.1f ns per change (%u)\n",
+    std::chrono::duration<double, std::nano>(stepEnd - stepStart).count() / steps,
+    total);
+
+  return passed ? 0 : 1;
+}
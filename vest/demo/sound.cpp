@@ -0,0 +1,190 @@
+// Plays a WAV file through the vest's SoundAnalyzer, the same way the vest
+// feeds it from the microphone, and prints the bands and beats. With --test,
+// it makes up 10 seconds of a 120 BPM kick drum over a 1 kHz tone instead,
+// and checks that it finds the beats and the tone.
+//
+//     ./sound song.wav
+//     ./sound --test
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../soundAnalyzer.hpp"
+
+// The microphone reads this many at a time
+static const int READ_LENGTH = 256;
+
+static uint32_t readLittleEndian(const uint8_t* const bytes, const int length) {
+  uint32_t value = 0;
+  for (int i = length - 1; i >= 0; --i) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+
+// Reads a 16 bit PCM WAV file and mixes it down to mono
+static bool readWav(const std::string& path, std::vector<int16_t>* const samples, int* const sampleRate_Hz) {
+  FILE* const file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    printf("%s: couldn't read it\n", path.c_str());
+    return false;
+  }
+  std::vector<uint8_t> contents;
+  uint8_t buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    contents.insert(contents.end(), buffer, buffer + read);
+  }
+  fclose(file);
+
+  if (contents.size() < 12 || memcmp(&contents[0], "RIFF", 4) != 0 || memcmp(&contents[8], "WAVE", 4) != 0) {
+    printf("%s: not a WAV file\n", path.c_str());
+    return false;
+  }
+  int channels = 0;
+  size_t offset = 12;
+  while (offset + 8 <= contents.size()) {
+    const uint8_t* const chunk = &contents[offset];
+    const size_t size = std::min<size_t>(readLittleEndian(chunk + 4, 4), contents.size() - offset - 8);
+    if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+      const uint32_t format = readLittleEndian(chunk + 8, 2);
+      channels = readLittleEndian(chunk + 10, 2);
+      *sampleRate_Hz = readLittleEndian(chunk + 12, 4);
+      const uint32_t bitsPerSample = readLittleEndian(chunk + 22, 2);
+      if (format != 1 || bitsPerSample != 16 || channels == 0) {
+        printf("%s: only 16 bit PCM is supported\n", path.c_str());
+        return false;
+      }
+    } else if (memcmp(chunk, "data", 4) == 0 && channels > 0) {
+      const size_t frameCount = size / (channels * 2);
+      samples->resize(frameCount);
+      for (size_t i = 0; i < frameCount; ++i) {
+        int sum = 0;
+        for (int channel = 0; channel < channels; ++channel) {
+          sum += static_cast<int16_t>(readLittleEndian(chunk + 8 + (i * channels + channel) * 2, 2));
+        }
+        (*samples)[i] = sum / channels;
+      }
+      return true;
+    }
+    // Chunks are padded to an even size
+    offset += 8 + size + (size & 1);
+  }
+  printf("%s: no audio in it\n", path.c_str());
+  return false;
+}
+
+
+static void makeTest(std::vector<int16_t>* const samples, const int sampleRate_Hz) {
+  const float pi = static_cast<float>(M_PI);
+  const int length = sampleRate_Hz * 10;
+  // 120 BPM
+  const int beatLength = sampleRate_Hz / 2;
+  samples->resize(length);
+  uint32_t noise = 1;
+  for (int i = 0; i < length; ++i) {
+    const float t = static_cast<float>(i) / sampleRate_Hz;
+    const float sinceBeat = static_cast<float>(i % beatLength) / sampleRate_Hz;
+    const float kick = 12000.0f * expf(-sinceBeat * 30.0f) * sinf(2.0f * pi * 60.0f * sinceBeat);
+    const float tone = 3000.0f * sinf(2.0f * pi * 1000.0f * t);
+    noise = noise * 1103515245 + 12345;
+    const float hiss = static_cast<float>(static_cast<int>((noise >> 16) & 0x7FF) - 1024);
+    (*samples)[i] = static_cast<int16_t>(kick + tone + hiss);
+  }
+}
+
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s song.wav | --test\n", argv[0]);
+    return 1;
+  }
+  const bool test = strcmp(argv[1], "--test") == 0;
+  std::vector<int16_t> samples;
+  int sampleRate_Hz = 44100;
+  if (test) {
+    makeTest(&samples, sampleRate_Hz);
+  } else if (!readWav(argv[1], &samples, &sampleRate_Hz)) {
+    return 1;
+  }
+
+  SoundAnalyzer analyzer(sampleRate_Hz);
+  uint32_t bandTotals[SoundLevels::BAND_COUNT] = {};
+  std::chrono::duration<double, std::nano> analyzing(0);
+  uint32_t lastBeatCount = 0;
+  uint32_t firstBeat_ms = 0;
+  uint32_t lastBeat_ms = 0;
+  int sinceAnalysis = 0;
+  for (size_t start = 0; start + READ_LENGTH <= samples.size(); start += READ_LENGTH) {
+    analyzer.addSamples(&samples[start], READ_LENGTH);
+    sinceAnalysis += READ_LENGTH;
+    if (sinceAnalysis < SoundAnalyzer::ANALYSIS_INTERVAL) {
+      continue;
+    }
+    sinceAnalysis = 0;
+
+    const uint32_t now_ms = static_cast<uint64_t>(start + READ_LENGTH) * 1000 / sampleRate_Hz;
+    const auto before = std::chrono::steady_clock::now();
+    analyzer.analyze(now_ms);
+    analyzing += std::chrono::steady_clock::now() - before;
+
+    const SoundLevels& levels = analyzer.levels();
+    char bars[SoundLevels::BAND_COUNT + 1] = {};
+    const char shades[] = " .:-=+*#%@";
+    for (int band = 0; band < SoundLevels::BAND_COUNT; ++band) {
+      bars[band] = shades[levels.bands[band] * (sizeof(shades) - 2) / 255];
+      bandTotals[band] += levels.bands[band];
+    }
+    if (!test) {
+      printf(
+        "%3u.%03u |%s| %3d%s\n",
+        now_ms / 1000,
+        now_ms % 1000,
+        bars,
+        levels.volume,
+        levels.beatCount != lastBeatCount ? " beat" : "");
+    }
+    if (levels.beatCount != lastBeatCount) {
+      if (lastBeatCount == 0) {
+        firstBeat_ms = now_ms;
+      }
+      lastBeat_ms = now_ms;
+    }
+    lastBeatCount = levels.beatCount;
+  }
+
+  const SoundLevels& levels = analyzer.levels();
+  // From the time between the first and last beats
+  const float bpm = levels.beatCount > 1 ? (levels.beatCount - 1) * 60000.0f / (lastBeat_ms - firstBeat_ms) : 0.0f;
+  printf(
+    "%u analyses, %u beats, %.0f BPM, %.0f ns per analysis\n",
+    levels.updateCount,
+    levels.beatCount,
+    bpm,
+    analyzing.count() / std::max<uint32_t>(levels.updateCount, 1));
+  if (!test) {
+    return 0;
+  }
+
+  // Ignore the bottom bands, which have the kick drum
+  int loudestBand = 4;
+  for (int band = loudestBand; band < SoundLevels::BAND_COUNT; ++band) {
+    if (bandTotals[band] > bandTotals[loudestBand]) {
+      loudestBand = band;
+    }
+  }
+  const bool toneGood = loudestBand == analyzer.band(1000.0f);
+  printf(toneGood ? "The tone is in the right band\n" : "The tone is in band %d, not %d\n", loudestBand, analyzer.band(1000.0f));
+  // 10 seconds at 120 BPM, but the first one might come before the samples
+  // fill up
+  const bool beatsGood = levels.beatCount >= 19 && levels.beatCount <= 20 && fabsf(bpm - 120.0f) < 2.0f;
+  printf(beatsGood ? "Beats are good\n" : "Beats are wrong\n");
+  return beatsGood && toneGood ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+#include <Arduino.h>
+
+#include "constants.hpp"
+#include "microphone.hpp"
+
+// Piddle sees samples like 1 2 3 3 2 1 0 32767 32766 32765 from this
+// microphone, so correct them the same way it does
+static int16_t fixSampleSign(const int16_t value) {
+  return value < 0x4000 ? value : -(0x8000 - 1 - value);
+}
+
+Microphone::Microphone() :
+  _rxHandle(nullptr),
+  _analyzer(SAMPLE_RATE_HZ),
+  _levelsMutex(nullptr),
+  _levels(),
+  _readErrors(0)
+{
+}
+
+void Microphone::begin() {
+  _levelsMutex = xSemaphoreCreateMutex();
+
+  // I2S_NUM_0 is left for the LEDs
+  i2s_chan_config_t channelConfig = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_1, I2S_ROLE_MASTER);
+  // Send nullptr for the tx handle, we're only receiving
+  if (i2s_new_channel(&channelConfig, nullptr, &_rxHandle) != ESP_OK) {
+    Serial.println("Couldn't make the microphone's I2S channel");
+    return;
+  }
+
+  i2s_std_slot_config_t slotConfig = {
+    .data_bit_width = I2S_DATA_BIT_WIDTH_16BIT,
+    .slot_bit_width = I2S_SLOT_BIT_WIDTH_16BIT,
+    .slot_mode = I2S_SLOT_MODE_MONO,
+    .slot_mask = I2S_STD_SLOT_LEFT,
+    .ws_width = I2S_DATA_BIT_WIDTH_16BIT,
+    .ws_pol = false,
+    .bit_shift = false,
+    .msb_right = false,
+  };
+
+  i2s_std_config_t stdConfig = {
+    .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE_HZ),
+    .slot_cfg = slotConfig,
+    .gpio_cfg = {
+      .mclk = I2S_GPIO_UNUSED,
+      .bclk = static_cast<gpio_num_t>(MICROPHONE_CLOCK_PIN),
+      .ws = static_cast<gpio_num_t>(MICROPHONE_WORD_SELECT_PIN),
+      .dout = I2S_GPIO_UNUSED,
+      .din = static_cast<gpio_num_t>(MICROPHONE_DATA_PIN),
+      .invert_flags = {
+        .mclk_inv = false,
+        .bclk_inv = false,
+        .ws_inv = false,
+      },
+    },
+  };
+  if (
+    i2s_channel_init_std_mode(_rxHandle, &stdConfig) != ESP_OK
+    || i2s_channel_enable(_rxHandle) != ESP_OK
+  ) {
+    Serial.println("Couldn't start the microphone");
+    return;
+  }
+
+  // The loop runs on core 1, so listen on core 0
+  xTaskCreatePinnedToCore(
+    readTask,
+    "microphone",
+    4000, // Stack size
+    this, // Task input parameter
+    1, // Priority of the task
+    nullptr, // Task handle
+    0); // Core where the task should run
+}
+
+void Microphone::levels(SoundLevels* const levels) const {
+  if (_levelsMutex == nullptr) {
+    *levels = SoundLevels();
+    return;
+  }
+  xSemaphoreTake(_levelsMutex, portMAX_DELAY);
+  *levels = _levels;
+  xSemaphoreGive(_levelsMutex);
+}
+
+void Microphone::readTask(void* const microphone) {
+  static_cast<Microphone*>(microphone)->read();
+}
+
+void Microphone::read() {
+  int16_t samples[READ_LENGTH];
+  int sinceAnalysis = 0;
+  while (true) {
+    size_t bytesRead = 0;
+    if (i2s_channel_read(_rxHandle, samples, sizeof(samples), &bytesRead, portMAX_DELAY) != ESP_OK) {
+      ++_readErrors;
+      delay(10);
+      continue;
+    }
+    const int count = bytesRead / sizeof(samples[0]);
+    for (int i = 0; i < count; ++i) {
+      samples[i] = fixSampleSign(samples[i]);
+    }
+    _analyzer.addSamples(samples, count);
+
+    sinceAnalysis += count;
+    if (sinceAnalysis < SoundAnalyzer::ANALYSIS_INTERVAL) {
+      continue;
+    }
+    sinceAnalysis = 0;
+    // Analyze without the lock, so animations never wait on the FFT
+    _analyzer.analyze(millis());
+    xSemaphoreTake(_levelsMutex, portMAX_DELAY);
+    _levels = _analyzer.levels();
+    xSemaphoreGive(_levelsMutex);
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef MICROPHONE_HPP
+#define MICROPHONE_HPP
+
+#include <driver/i2s_std.h>
+
+#include "soundAnalyzer.hpp"
+
+// Reads the I2S microphone and analyzes it in a task on core 0, the same way
+// as piddle, so the animations on core 1 don't slow down. Animations get the
+// newest levels from levels().
+class Microphone {
+  public:
+    Microphone();
+    ~Microphone() = default;
+    // Starts I2S and the task. Call this from setup().
+    void begin();
+    // Copies the newest levels. They're all 0 until the task has analyzed
+    // something.
+    void levels(SoundLevels* levels) const;
+
+    // Debug info
+    uint32_t readErrors() const { return _readErrors; }
+
+  private:
+    Microphone(const Microphone&) = delete;
+    Microphone(Microphone&&) = delete;
+
+    static const int SAMPLE_RATE_HZ = 44100;
+    static const int READ_LENGTH = 256;
+
+    static void readTask(void* microphone);
+    void read();
+
+    i2s_chan_handle_t _rxHandle;
+    // Only the task uses this
+    SoundAnalyzer _analyzer;
+    // The task copies the analyzer's levels here, and animations copy them out
+    SemaphoreHandle_t _levelsMutex;
+    SoundLevels _levels;
+    uint32_t _readErrors;
+};
+
+#endif
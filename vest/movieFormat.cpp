@@ -0,0 +1,146 @@
+#include <cstring>
+
+#include "movieFormat.hpp"
+
+uint16_t readLittleEndian16(const uint8_t* const bytes) {
+  return bytes[0] | (bytes[1] << 8);
+}
+
+uint32_t readLittleEndian32(const uint8_t* const bytes) {
+  return readLittleEndian16(bytes) | (static_cast<uint32_t>(readLittleEndian16(bytes + 2)) << 16);
+}
+
+bool parseMovieHeader(const uint8_t* const bytes, MovieHeader* const header) {
+  if (memcmp(bytes, "ANIM", 4) != 0 || bytes[4] == 0 || bytes[4] > MOVIE_VERSION) {
+    return false;
+  }
+  header->width = bytes[5];
+  header->height = bytes[6];
+  header->microsPerFrame = readLittleEndian32(bytes + 8);
+  header->frameCount = readLittleEndian32(bytes + 12);
+  header->indexOffset = readLittleEndian32(bytes + 16);
+  return header->width > 0 && header->height > 0 && header->frameCount > 0;
+}
+
+static bool decodeRunLength(const uint8_t* const data, const size_t size, uint8_t* const pixels, const size_t pixelCount) {
+  const size_t pixelsSize = pixelCount * 3;
+  size_t in = 0;
+  size_t out = 0;
+  while (in < size) {
+    const uint8_t count = data[in];
+    ++in;
+    if (count < 128) {
+      const size_t length = (count + 1) * 3;
+      if (in + length > size || out + length > pixelsSize) {
+        return false;
+      }
+      memcpy(pixels + out, data + in, length);
+      in += length;
+      out += length;
+    } else {
+      const size_t repeats = count - 126;
+      if (in + 3 > size || out + repeats * 3 > pixelsSize) {
+        return false;
+      }
+      for (size_t i = 0; i < repeats; ++i) {
+        memcpy(pixels + out, data + in, 3);
+        out += 3;
+      }
+      in += 3;
+    }
+  }
+  return out == pixelsSize;
+}
+
+static bool decodeDelta(const uint8_t* const data, const size_t size, uint8_t* const pixels, const size_t pixelCount) {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < size) {
+    if (in + 2 > size) {
+      return false;
+    }
+    const size_t skip = data[in];
+    const size_t count = data[in + 1];
+    in += 2;
+    out += skip;
+    if (out + count > pixelCount || in + count * 3 > size) {
+      return false;
+    }
+    memcpy(pixels + out * 3, data + in, count * 3);
+    in += count * 3;
+    out += count;
+  }
+  return true;
+}
+
+static bool decodePalette(const uint8_t* const data, const size_t size, uint8_t* const pixels, const size_t pixelCount) {
+  if (size == 0) {
+    return false;
+  }
+  const size_t colorCount = data[0] + 1;
+  const uint8_t* const colors = data + 1;
+  size_t in = 1 + colorCount * 3;
+  if (in > size) {
+    return false;
+  }
+  size_t out = 0;
+  while (in < size) {
+    const uint8_t count = data[in];
+    ++in;
+    if (count < 128) {
+      const size_t length = count + 1;
+      if (in + length > size || out + length > pixelCount) {
+        return false;
+      }
+      for (size_t i = 0; i < length; ++i) {
+        const uint8_t index = data[in + i];
+        if (index >= colorCount) {
+          return false;
+        }
+        memcpy(pixels + (out + i) * 3, colors + index * 3, 3);
+      }
+      in += length;
+      out += length;
+    } else {
+      const size_t repeats = count - 126;
+      if (in + 1 > size || out + repeats > pixelCount || data[in] >= colorCount) {
+        return false;
+      }
+      const uint8_t* const color = colors + data[in] * 3;
+      for (size_t i = 0; i < repeats; ++i) {
+        memcpy(pixels + (out + i) * 3, color, 3);
+      }
+      in += 1;
+      out += repeats;
+    }
+  }
+  return out == pixelCount;
+}
+
+bool isMovieKeyFrame(const uint8_t type) {
+  return static_cast<MovieFrameType>(type) != MovieFrameType::delta;
+}
+
+bool decodeMovieFrame(
+  const uint8_t type,
+  const uint8_t* const data,
+  const size_t size,
+  uint8_t* const pixels,
+  const size_t pixelCount
+) {
+  switch (static_cast<MovieFrameType>(type)) {
+    case MovieFrameType::raw:
+      if (size != pixelCount * 3) {
+        return false;
+      }
+      memcpy(pixels, data, size);
+      return true;
+    case MovieFrameType::runLength:
+      return decodeRunLength(data, size, pixels, pixelCount);
+    case MovieFrameType::delta:
+      return decodeDelta(data, size, pixels, pixelCount);
+    case MovieFrameType::palette:
+      return decodePalette(data, size, pixels, pixelCount);
+  }
+  return false;
+}
@@ -0,0 +1,77 @@
+#ifndef MOVIE_FORMAT_HPP
+#define MOVIE_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// The .anim movie format that video/video.py writes. This doesn't use
+// anything from Arduino, so the demo can decode movies on a computer too.
+//
+// Everything is little endian. The file starts with a header:
+//   "ANIM"
+//   uint8_t version, MOVIE_VERSION
+//   uint8_t width, uint8_t height: the grid that the frames cover
+//   uint8_t reserved, 0
+//   uint32_t microsPerFrame
+//   uint32_t frameCount
+//   uint32_t indexOffset: where the frame index starts
+// Then the frames, one after another. Each one is:
+//   uint8_t type, one of MovieFrameType
+//   uint16_t size of the data after it
+//   data
+// Then the index, a uint32_t per frame with the offset of its type byte. The
+// top bit is set on key frames, which can be decoded without the frames
+// before them. Delta frames change the frame before them, so to seek to one,
+// decode from the key frame before it. The first frame is always a key frame.
+//
+// Pixels are 3 bytes, red green blue. They go up each column from the bottom,
+// starting at the left column, the same as Animation::framebuffer.
+
+// Version 2 added delta and palette frames. Version 1 movies still play.
+const uint8_t MOVIE_VERSION = 2;
+const int MOVIE_HEADER_SIZE = 20;
+const int MOVIE_FRAME_HEADER_SIZE = 3;
+const int MOVIE_INDEX_ENTRY_SIZE = 4;
+const uint32_t MOVIE_KEY_FRAME = 0x80000000;
+
+enum class MovieFrameType : uint8_t {
+  // width * height pixels
+  raw = 0,
+  // Runs of pixels. Each run starts with a count c. If c < 128, then c + 1
+  // pixels follow. Otherwise, one pixel follows that's repeated c - 126 times.
+  runLength = 1,
+  // Changes to the frame before. Each change starts with a skip s and a count
+  // c. s pixels stay the same, then c new pixels follow. Pixels after the last
+  // change stay the same.
+  delta = 2,
+  // For frames with 256 or fewer colors. It starts with the number of colors
+  // minus 1, then the colors. Then there's a byte per pixel with its color's
+  // index, run length encoded the same as runLength but with 1 byte instead
+  // of 3.
+  palette = 3,
+};
+
+// Whether frames of this type can be decoded without the frame before
+bool isMovieKeyFrame(uint8_t type);
+
+struct MovieHeader {
+  uint8_t width;
+  uint8_t height;
+  uint32_t microsPerFrame;
+  uint32_t frameCount;
+  uint32_t indexOffset;
+};
+
+uint16_t readLittleEndian16(const uint8_t* bytes);
+uint32_t readLittleEndian32(const uint8_t* bytes);
+
+// Returns false if it's not a movie, or it's a version I can't play
+bool parseMovieHeader(const uint8_t* bytes, MovieHeader* header);
+
+// Decodes a frame into pixels, which has room for pixelCount pixels. Delta
+// frames are applied to what's already in pixels, so that has to be the frame
+// before. Returns false if the data is bad or doesn't fill exactly pixelCount
+// pixels, and then pixels might be partly changed.
+bool decodeMovieFrame(uint8_t type, const uint8_t* data, size_t size, uint8_t* pixels, size_t pixelCount);
+
+#endif
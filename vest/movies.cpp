@@ -1,21 +1,51 @@
 #include "FS.h"
 #include "SD.h"
 #include "SPI.h"
-#include <endian.h>
+#include <cstring>
 
 #include "constants.hpp"
 #include "movies.hpp"
 
-extern CRGB leds[LED_COUNT];
-static const char* const DIRECTORY = "animations";
+// Newer ESP32 cores need the leading slash
+static const char* const DIRECTORY = "/animations";
+
+// Older ESP32 cores give the whole path from File::name(), and newer ones only
+// give the name, so keep the part after the last slash either way
+static const char* baseName(const char* const path) {
+  const char* const slash = strrchr(path, '/');
+  return slash == nullptr ? path : slash + 1;
+}
 
 MoviePlayer::MoviePlayer() :
   _playing(false),
-  _directory(),
+  _playlist(),
   _file(),
-  _currentFileIndex(0),
-  _millisPerFrame()
+  _fileMutex(nullptr),
+  _header(),
+  _valid(false),
+  _nextFrame(0),
+  _generation(0),
+  _freeSlots(nullptr),
+  _readySlots(nullptr),
+  _slots(),
+  _readBuffer(),
+  _decoded(),
+  _decodedGeneration(0),
+  _decodedValid(false),
+  _nextFrame_us(0),
+  _underruns(0),
+  _readErrors(0)
 {
+}
+
+void MoviePlayer::begin() {
+  _fileMutex = xSemaphoreCreateMutex();
+  _freeSlots = xQueueCreate(SLOT_COUNT, sizeof(uint8_t));
+  _readySlots = xQueueCreate(SLOT_COUNT, sizeof(uint8_t));
+  for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+    xQueueSend(_freeSlots, &i, 0);
+  }
+
   pinMode(SD_PIN, OUTPUT);
   if (!SD.begin(SD_PIN)) {
     return;
@@ -25,45 +55,63 @@ MoviePlayer::MoviePlayer() :
     return;
   }
 
-  _directory = SD.open(DIRECTORY);
-  if (!_directory.isDirectory()) {
+  File directory = SD.open(DIRECTORY);
+  if (!directory.isDirectory()) {
     return;
   }
 
-  _file = _directory.openNextFile();
-  if (_file) {
-    static_assert(BYTE_ORDER == LITTLE_ENDIAN);
-    _file.read(reinterpret_cast<uint8_t*>(&_millisPerFrame), sizeof(_millisPerFrame));
+  // Only walk the directory once, so changing movies later doesn't have to
+  // open every file before the one we want
+  uint8_t header[MOVIE_HEADER_SIZE];
+  for (File file = directory.openNextFile(); file; file = directory.openNextFile()) {
+    if (
+      file.isDirectory()
+      || file.read(header, sizeof(header)) != sizeof(header)
+      || !_playlist.add(baseName(file.name()), header)
+    ) {
+      Serial.printf("Skipping %s\n", file.name());
+    }
   }
+  _playlist.sort();
+  Serial.printf("Found %d movies\n", _playlist.size());
+  if (_playlist.size() == 0) {
+    return;
+  }
+
+  openCurrent();
+
+  // The loop runs on core 1, so read on core 0
+  xTaskCreatePinnedToCore(
+    readAheadTask,
+    "readAhead",
+    4000, // Stack size
+    this, // Task input parameter
+    1, // Priority of the task
+    nullptr, // Task handle
+    0); // Core where the task should run
 }
 
 void MoviePlayer::next(char* const output, const size_t length) {
-  _file = _directory.openNextFile();
-  if (!_file) {
-    _directory.rewindDirectory();
-    _file = _directory.openNextFile();
-  }
-  const char* const name = _file.name();
-  strncpy(output, name, length);
-  output[length - 1] = '\0';
-
-  ++_currentFileIndex;
-  _playing = false;
+  jump(_playlist.current() + 1, output, length);
 }
 
 void MoviePlayer::previous(char* const output, const size_t length) {
-  if (_currentFileIndex > 0) {
-    _directory.rewindDirectory();
-    for (int i = 0; i <= _currentFileIndex; ++i) {
-      _file = _directory.openNextFile();
-      static_assert(BYTE_ORDER == LITTLE_ENDIAN);
-      _file.read(reinterpret_cast<uint8_t*>(&_millisPerFrame), sizeof(_millisPerFrame));
-    }
-    --_currentFileIndex;
-  } else {
-    // TODO: Support previous when we're at the start
-  }
+  jump(_playlist.current() - 1, output, length);
+}
+
+void MoviePlayer::jump(const int index, char* const output, const size_t length) {
   _playing = false;
+  if (_playlist.size() == 0) {
+    strncpy(output, "No movies", length);
+    output[length - 1] = '\0';
+    return;
+  }
+  xSemaphoreTake(_fileMutex, portMAX_DELAY);
+  _playlist.jump(index);
+  openCurrent();
+  xSemaphoreGive(_fileMutex);
+  strncpy(output, _playlist.name(_playlist.current()), length);
+  output[length - 1] = '\0';
 }
 
 void MoviePlayer::play() {
@@ -83,22 +131,177 @@ MoviePlayer::operator bool() const {
 }
 
 int MoviePlayer::animate() {
-  //const int HEADER_OFFSET = 2;
-  if (!_playing) {
+  if (!_playing || _readySlots == nullptr) {
     return 100;
   }
 
-  if (!_file.available()) {
-    _file.seek(sizeof(_millisPerFrame));
+  uint8_t slotIndex;
+  while (xQueueReceive(_readySlots, &slotIndex, 0) == pdTRUE) {
+    const Slot& slot = _slots[slotIndex];
+    const bool current = slot.generation == _generation;
+    if (current) {
+      draw(slot);
+    }
+    xQueueSend(_freeSlots, &slotIndex, 0);
+    if (!current) {
+      continue;
+    }
+
+    // Keep to the movie's frame rate instead of adding up rounded delays.
+    // If we fell more than a frame behind, like when it just started, then
+    // start counting again from now.
+    const uint32_t now_us = micros();
+    if (static_cast<int32_t>(now_us - _nextFrame_us) > static_cast<int32_t>(_header.microsPerFrame)) {
+      _nextFrame_us = now_us;
+    }
+    _nextFrame_us += _header.microsPerFrame;
+    const int32_t wait_us = _nextFrame_us - now_us;
+    return wait_us > 0 ? wait_us / 1000 : 0;
   }
-  // Looks like the struct is packed
-  static_assert(sizeof(leds) == LED_COUNT * 3);
-  // TODO: Should I check the response number of bytes read?
-  _file.read(reinterpret_cast<uint8_t*>(leds), sizeof(leds));
-  return _millisPerFrame;
-}
 
+  // The reader hasn't kept up, so leave the last frame up and check back soon
+  ++_underruns;
+  return 1;
+}
 
 void MoviePlayer::reset() {
-  _file.seek(sizeof(_millisPerFrame));
+  if (_fileMutex == nullptr) {
+    return;
+  }
+  xSemaphoreTake(_fileMutex, portMAX_DELAY);
+  if (_valid) {
+    _valid = seekFrame(0);
+  }
+  ++_generation;
+  xSemaphoreGive(_fileMutex);
+}
+
+void MoviePlayer::openCurrent() {
+  char path[300];  // FAT names can be up to 255 characters
+  snprintf(path, sizeof(path), "%s/%s", DIRECTORY, _playlist.name(_playlist.current()));
+  _file = SD.open(path);
+  openMovie();
+}
+
+bool MoviePlayer::openMovie() {
+  uint8_t bytes[MOVIE_HEADER_SIZE];
+  _valid = _file
+    && _file.read(bytes, sizeof(bytes)) == sizeof(bytes)
+    && parseMovieHeader(bytes, &_header)
+    && _header.width <= LED_COLUMN_COUNT
+    && _header.height <= LED_ROW_COUNT
+    && seekFrame(0);
+  ++_generation;
+  if (_file && !_valid) {
+    Serial.printf("%s isn't a movie I can play\n", _file.name());
+  }
+  return _valid;
+}
+
+bool MoviePlayer::seekFrame(const uint32_t frame) {
+  uint8_t entry[MOVIE_INDEX_ENTRY_SIZE];
+  if (
+    frame >= _header.frameCount
+    || !_file.seek(_header.indexOffset + frame * MOVIE_INDEX_ENTRY_SIZE)
+    || _file.read(entry, sizeof(entry)) != sizeof(entry)
+  ) {
+    return false;
+  }
+  if (!_file.seek(readLittleEndian32(entry) & ~MOVIE_KEY_FRAME)) {
+    return false;
+  }
+  _nextFrame = frame;
+  return true;
+}
+
+bool MoviePlayer::readFrame(uint8_t* const type, uint16_t* const size) {
+  uint8_t frameHeader[MOVIE_FRAME_HEADER_SIZE];
+  if (_file.read(frameHeader, sizeof(frameHeader)) != sizeof(frameHeader)) {
+    return false;
+  }
+  *type = frameHeader[0];
+  *size = readLittleEndian16(frameHeader + 1);
+  if (*size > sizeof(_readBuffer)) {
+    return false;
+  }
+  return _file.read(_readBuffer, *size) == *size;
+}
+
+void MoviePlayer::readAheadTask(void* const player) {
+  static_cast<MoviePlayer*>(player)->readAhead();
+}
+
+void MoviePlayer::readAhead() {
+  while (true) {
+    uint8_t slotIndex;
+    xQueueReceive(_freeSlots, &slotIndex, portMAX_DELAY);
+    Slot& slot = _slots[slotIndex];
+
+    bool filled = false;
+    while (!filled) {
+      xSemaphoreTake(_fileMutex, portMAX_DELAY);
+      const uint32_t generation = _generation;
+      const MovieHeader header = _header;
+      uint8_t type = 0;
+      uint16_t size = 0;
+      bool read = false;
+      if (_valid) {
+        if (_nextFrame >= _header.frameCount) {
+          // Loop back to the start
+          seekFrame(0);
+        }
+        read = readFrame(&type, &size);
+        if (read) {
+          ++_nextFrame;
+        } else {
+          ++_readErrors;
+          seekFrame(0);
+        }
+      }
+      xSemaphoreGive(_fileMutex);
+
+      if (!read) {
+        // Nothing to play, or the card is acting up, so don't spin
+        delay(100);
+        continue;
+      }
+      // Decode without the lock, so the loop can change movies in the
+      // meantime. Delta frames change the frame before, so every frame is
+      // decoded into the same pixels, and then copied into the slot.
+      const bool keyFrame = isMovieKeyFrame(type);
+      if (!keyFrame && (!_decodedValid || _decodedGeneration != generation)) {
+        // The frame it changes is gone, so skip ahead to the next key frame
+        ++_readErrors;
+        continue;
+      }
+      const size_t pixelCount = header.width * header.height;
+      _decodedValid = decodeMovieFrame(type, _readBuffer, size, _decoded, pixelCount);
+      _decodedGeneration = generation;
+      if (_decodedValid) {
+        memcpy(slot.pixels, _decoded, pixelCount * 3);
+        slot.width = header.width;
+        slot.height = header.height;
+        slot.generation = generation;
+        filled = true;
+      } else {
+        ++_readErrors;
+      }
+    }
+    xQueueSend(_readySlots, &slotIndex, portMAX_DELAY);
+  }
+}
+
+void MoviePlayer::draw(const Slot& slot) {
+  // Movies smaller than the grid go in the middle
+  const int xOffset = (LED_COLUMN_COUNT - slot.width) / 2;
+  const int yOffset = (LED_ROW_COUNT - slot.height) / 2;
+  clearFramebuffer();
+  const uint8_t* pixel = slot.pixels;
+  for (int x = 0; x < slot.width; ++x) {
+    for (int y = 0; y < slot.height; ++y) {
+      framebuffer[x + xOffset][y + yOffset] = CRGB(pixel[0], pixel[1], pixel[2]);
+      pixel += 3;
+    }
+  }
+  showFramebuffer();
 }
@@ -2,14 +2,25 @@
 #define MOVIES_HPP
 
 #include "animations.hpp"
+#include "movieFormat.hpp"
+#include "playlist.hpp"
 #include <FS.h>
 
+// Plays .anim movies from the SD card. A task on the other core reads and
+// decodes frames ahead of time into a few slots, so animate() only has to
+// copy a frame that's ready and never waits on the SD card.
 class MoviePlayer : public Animation {
   public:
     MoviePlayer();
     ~MoviePlayer() = default;
+    // Starts the SD card, reads every movie's header into the playlist, and
+    // starts the reading task. Call this from setup().
+    void begin();
+    // These copy the new movie's name into output. They wrap around.
     void next(char* output, size_t length);
     void previous(char* output, size_t length);
+    void jump(int index, char* output, size_t length);
+    int movieCount() const { return _playlist.size(); }
     void play();
     void pause();
     void togglePlay();
@@ -18,15 +29,64 @@ class MoviePlayer : public Animation {
     int animate() override;
     void reset() override;
 
+    // Debug info
+    uint32_t underruns() const { return _underruns; }  // Times a frame wasn't ready in time
+    uint32_t readErrors() const { return _readErrors; }
+
   private:
     MoviePlayer(const MoviePlayer&) = delete;
     MoviePlayer(MoviePlayer&&) = delete;
 
+    static const int SLOT_COUNT = 4;
+    static const int MAXIMUM_PIXEL_COUNT = LED_COLUMN_COUNT * LED_ROW_COUNT;
+    // The encoder only uses another frame type when it's smaller than raw
+    static const int MAXIMUM_FRAME_SIZE = MAXIMUM_PIXEL_COUNT * 3;
+
+    struct Slot {
+      uint8_t pixels[MAXIMUM_PIXEL_COUNT * 3];
+      uint8_t width;
+      uint8_t height;
+      // Which movie this frame came from. It's stale if the movie changed or
+      // restarted since.
+      uint32_t generation;
+    };
+
+    // These are all called with _fileMutex held
+    void openCurrent();
+    bool openMovie();
+    bool seekFrame(uint32_t frame);
+    bool readFrame(uint8_t* type, uint16_t* size);
+
+    static void readAheadTask(void* player);
+    void readAhead();
+    void draw(const Slot& slot);
+
     bool _playing;
-    File _directory;
+    Playlist _playlist;
     File _file;
-    int _currentFileIndex;
-    uint16_t _millisPerFrame;
+
+    // The reading task and the loop both use the file, so they take turns
+    SemaphoreHandle_t _fileMutex;
+    MovieHeader _header;
+    bool _valid;
+    uint32_t _nextFrame;
+    uint32_t _generation;
+
+    // Slot indexes. The reading task takes free slots and fills them, and
+    // animate() shows ready ones and gives them back.
+    QueueHandle_t _freeSlots;
+    QueueHandle_t _readySlots;
+    Slot _slots[SLOT_COUNT];
+    // Only the reading task uses these. _decoded is the last frame it
+    // decoded, which the next delta frame changes.
+    uint8_t _readBuffer[MAXIMUM_FRAME_SIZE];
+    uint8_t _decoded[MAXIMUM_PIXEL_COUNT * 3];
+    uint32_t _decodedGeneration;
+    bool _decodedValid;
+
+    uint32_t _nextFrame_us;
+    uint32_t _underruns;
+    uint32_t _readErrors;
 };
 
 #endif
@@ -87,6 +87,9 @@ def print_luts() -> None:
 
     color_to_count = {}
     total_led_count = 0
+    # LEDs that are wired up but aren't on the grid, like the ones that run
+    # between columns
+    skipped_leds = []
     def fill_grid() -> None:
         total_active_led_count = 0
 
@@ -99,6 +102,7 @@ def print_luts() -> None:
             nonlocal total_led_count
             for part in parts:
                 if part == "n":
+                    skipped_leds.append(total_led_count)
                     strand_led_count += 1
                     total_led_count += 1
                 else:
@@ -185,6 +189,7 @@ constexpr int STRAND_TO_LED_COUNT[] = {{ {", ".join((str(i) for i in led_count_p
 constexpr int LINEAR_LED_INDEXES[] = {{ {", ".join(str(sum(led_count_per_strand[:i])) for i in range(0, len(led_count_per_strand)))} }};
 const int LED_COUNT = {total_led_count};
 const int STRAND_COUNT = {len(formats)};
+const int LONGEST_STRAND_LED_COUNT = {max(led_count_per_strand)};
 
 // x first then y, starting at lower left corner
 """)
@@ -195,6 +200,39 @@ const int STRAND_COUNT = {len(formats)};
         print(f"    {{{joined}}},")
     print("};")
 
+    # Animations draw into a dense framebuffer, so they don't need to check
+    # for unused cells. Then this list copies the cells that have LEDs into
+    # leds[] in one pass. Animations that work out every pixel, like the
+    # plasmas, can go through it themselves and skip the framebuffer. It's in
+    # LED order so the writes to leds[] go straight along.
+    grid_leds = sorted(grid.items(), key=lambda item: item[1].total_offset)
+    print()
+    print("// The grid cells that have LEDs, in LED order")
+    print("struct GridLed {")
+    print("  uint8_t x;")
+    print("  uint8_t y;")
+    print("  uint16_t led;")
+    print("};")
+    print(f"const int GRID_LED_COUNT = {len(grid_leds)};")
+    print("const GridLed GRID_LEDS[GRID_LED_COUNT] = {")
+    per_line = 8
+    for start in range(0, len(grid_leds), per_line):
+        line = grid_leds[start:start + per_line]
+        joined = ", ".join(f"{{{x}, {y}, {info.total_offset}}}" for (x, y), info in line)
+        print(f"    {joined},")
+    print("};")
+
+    # Nothing draws these, so showing the framebuffer turns them off in case
+    # an animation that uses leds[] directly left them on
+    print()
+    print("// The LEDs that aren't on the grid")
+    print(f"const int SKIPPED_LED_COUNT = {len(skipped_leds)};")
+    print("const uint16_t SKIPPED_LEDS[SKIPPED_LED_COUNT] = {")
+    per_line = 16
+    for start in range(0, len(skipped_leds), per_line):
+        print(f"    {', '.join(str(led) for led in skipped_leds[start:start + per_line])},")
+    print("};")
+
     return max_y, max_x
 
 
@@ -213,6 +251,18 @@ def print_precomputed_bidoulle_v3(row_count: int, column_count: int) -> None:
     print("};")
 
 
+def print_quarter_sine() -> None:
+    """Prints a quarter of a sine wave, for when sin16 isn't close enough."""
+    steps = 256
+    print(f"// sin(angle) * 32767 for {steps} steps from 0 up to pi / 2, plus pi / 2 itself")
+    print(f"const int16_t QUARTER_SINE[{steps + 1}] = {{")
+    per_line = 16
+    for start in range(0, steps + 1, per_line):
+        values = (round(math.sin(i / steps * math.pi / 2) * 32767) for i in range(start, min(start + per_line, steps + 1)))
+        print(f"    {', '.join(str(value) for value in values)},")
+    print("};")
+
+
 def main() -> None:
     global debug
     if len(sys.argv) > 1:
@@ -223,6 +273,7 @@ def main() -> None:
     else:
         row_count, column_count = print_luts()
         print_precomputed_bidoulle_v3(row_count, column_count)
+        print_quarter_sine()
 
 
 if __name__ == "__main__":
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cstring>
+
+#include "movieFormat.hpp"
+#include "playlist.hpp"
+
+Playlist::Playlist() : names(), entries(), currentIndex(0) {}
+
+void Playlist::clear() {
+  names.clear();
+  entries.clear();
+  currentIndex = 0;
+}
+
+bool Playlist::add(const char* const name, const uint8_t* const headerBytes) {
+  MovieHeader header;
+  if (!parseMovieHeader(headerBytes, &header)) {
+    return false;
+  }
+  const Entry entry = {
+    static_cast<uint32_t>(names.size()),
+    static_cast<uint32_t>(static_cast<uint64_t>(header.frameCount) * header.microsPerFrame / 1000),
+  };
+  names.insert(names.end(), name, name + strlen(name) + 1);
+  entries.push_back(entry);
+  return true;
+}
+
+void Playlist::sort() {
+  const char* const pool = names.data();
+  std::sort(entries.begin(), entries.end(), [pool](const Entry& first, const Entry& second) {
+    return strcmp(pool + first.nameOffset, pool + second.nameOffset) < 0;
+  });
+  currentIndex = 0;
+}
+
+int Playlist::size() const {
+  return static_cast<int>(entries.size());
+}
+
+int Playlist::current() const {
+  return currentIndex;
+}
+
+int Playlist::next() {
+  return jump(currentIndex + 1);
+}
+
+int Playlist::previous() {
+  return jump(currentIndex - 1);
+}
+
+int Playlist::jump(const int index) {
+  // % keeps the sign, so negative indexes need to come back around
+  currentIndex = index % size();
+  if (currentIndex < 0) {
+    currentIndex += size();
+  }
+  return currentIndex;
+}
+
+const char* Playlist::name(const int index) const {
+  return names.data() + entries[index].nameOffset;
+}
+
+uint32_t Playlist::duration_ms(const int index) const {
+  return entries[index].duration_ms;
+}
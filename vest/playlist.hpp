@@ -0,0 +1,47 @@
+#ifndef PLAYLIST_HPP
+#define PLAYLIST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The movies on the SD card, so going to the next, previous, or any movie
+// doesn't have to walk the directory again. It's built once when starting up
+// from each movie's header. This doesn't use anything from Arduino, so the
+// demo can test it on a directory on a computer.
+class Playlist {
+  public:
+    Playlist();
+    ~Playlist() = default;
+
+    void clear();
+    // Adds the movie if headerBytes is a header I can play. Returns whether
+    // it was added.
+    bool add(const char* name, const uint8_t* headerBytes);
+    // Puts the movies in name order, so the order doesn't depend on how the
+    // files happened to be written to the card, and goes back to the first one
+    void sort();
+
+    int size() const;
+    int current() const;
+    // These move the current movie and return it. They wrap around in both
+    // directions. Don't call them when it's empty.
+    int next();
+    int previous();
+    int jump(int index);
+
+    const char* name(int index) const;
+    uint32_t duration_ms(int index) const;
+
+  private:
+    struct Entry {
+      uint32_t nameOffset;  // Into names
+      uint32_t duration_ms;
+    };
+    // All the names, each ending in '\0', so there's only one allocation
+    std::vector<char> names;
+    std::vector<Entry> entries;
+    int currentIndex;
+};
+
+#endif
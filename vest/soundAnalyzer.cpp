@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cmath>
+
+#include "soundAnalyzer.hpp"
+
+// The bands go from here up, spaced evenly in octaves
+static const float LOWEST_FREQUENCY_HZ = 60.0f;
+static const float HIGHEST_FREQUENCY_HZ = 12000.0f;
+// Beats are in the kick drum and the bass, under this
+static const float BASS_FREQUENCY_HZ = 150.0f;
+// A beat is when the bass jumps this far over its running average
+static const float BEAT_RATIO = 1.5f;
+// How much each analysis counts towards the running average of the bass
+static const float BASS_AVERAGE_WEIGHT = 0.05f;
+// How fast the peak falls each analysis. At 40 analyses a second, this about
+// halves it in 5 seconds.
+static const float PEAK_DECAY = 0.997f;
+
+static constexpr float square(const float f) {
+  return f * f;
+}
+
+// The peak never goes under this, so a quiet room doesn't get scaled up into
+// noise. This is the same as the minimum divisor in piddle, but that's on
+// power and this is on amplitude.
+static const float MINIMUM_PEAK = 10000.0f;
+// Bass power has to be over this to be a beat
+static const float MINIMUM_BASS = square(50000.0f);
+
+/**
+ * Returns the A weighting multiplier for a frequency, see https://en.wikipedia.org/wiki/A-weighting
+ */
+static float aWeightingMultiplier(const float frequency) {
+  const float freq_2 = square(frequency);
+  const float denom1 = freq_2 + square(20.6f);
+  const float denom2 = sqrtf((freq_2 + square(107.7f)) * (freq_2 + square(737.9f)));
+  const float denom3 = freq_2 + square(12194.0f);
+  const float denom = denom1 * denom2 * denom3;
+  const float enumer = (square(freq_2) * square(12194.0f));
+  const float ra = enumer / denom;
+  const float aWeighting_db = 2.0f + 20.0f * log10f(ra);
+  return powf(10.0f, aWeighting_db / 10.0f);
+}
+
+/**
+ * Returns the windowing multiplier, see https://en.wikipedia.org/wiki/Window_function
+ */
+static float windowingMultiplier(const int offset, const int length) {
+  // a0 = 0.5 for Hann, a0 = 0.54 for original Hamming, a0 = 0.53836 for new Hamming
+  const float a0 = 0.53836f;
+  return a0 - (1.0f - a0) * cosf(2.0f * static_cast<float>(M_PI) * offset / length);
+}
+
+SoundAnalyzer::SoundAnalyzer(const int sampleRate_Hz_) :
+  sampleRate_Hz(sampleRate_Hz_),
+  samples(),
+  sampleOffset(0),
+  input(),
+  output(),
+  fftPlan(fft_init(SAMPLE_COUNT, FFT_REAL, FFT_FORWARD, input, output)),
+  windowingConstants(),
+  weightingConstants(),
+  bandStarts(),
+  peak(MINIMUM_PEAK),
+  averageBass(0.0f),
+  lastBeat_ms(0),
+  soundLevels()
+{
+  for (int i = 0; i < SAMPLE_COUNT; ++i) {
+    windowingConstants[i] = windowingMultiplier(i, SAMPLE_COUNT);
+  }
+
+  const float binWidth_Hz = static_cast<float>(sampleRate_Hz) / SAMPLE_COUNT;
+  for (int i = 0; i < SAMPLE_COUNT / 2; ++i) {
+    weightingConstants[i] = aWeightingMultiplier(std::max(binWidth_Hz * i, 1.0f));
+  }
+
+  // Low bands are narrower than a bin, so make sure each one gets at least one
+  const float highest_Hz = std::min(HIGHEST_FREQUENCY_HZ, sampleRate_Hz * 0.5f);
+  for (int band = 0; band <= SoundLevels::BAND_COUNT; ++band) {
+    const float frequency_Hz = LOWEST_FREQUENCY_HZ * powf(highest_Hz / LOWEST_FREQUENCY_HZ, static_cast<float>(band) / SoundLevels::BAND_COUNT);
+    int bin = std::max(1, static_cast<int>(lroundf(frequency_Hz / binWidth_Hz)));
+    if (band > 0) {
+      bin = std::max(bin, bandStarts[band - 1] + 1);
+    }
+    bandStarts[band] = std::min(bin, SAMPLE_COUNT / 2 - SoundLevels::BAND_COUNT + band);
+  }
+}
+
+SoundAnalyzer::~SoundAnalyzer() {
+  fft_destroy(fftPlan);
+}
+
+void SoundAnalyzer::addSamples(const int16_t* const newSamples, const int count) {
+  for (int i = 0; i < count; ++i) {
+    samples[sampleOffset] = newSamples[i];
+    sampleOffset = (sampleOffset + 1) % SAMPLE_COUNT;
+  }
+}
+
+void SoundAnalyzer::analyze(const uint32_t now_ms) {
+  // Oldest first, so the window lines up with them
+  float sumSquares = 0.0f;
+  for (int i = 0; i < SAMPLE_COUNT; ++i) {
+    const float sample = samples[(sampleOffset + i) % SAMPLE_COUNT];
+    sumSquares += sample * sample;
+    input[i] = sample * windowingConstants[i];
+  }
+
+  // Call this directly instead of through fft_execute for dead code elimination
+  rfft(input, output, fftPlan->twiddle_factors, SAMPLE_COUNT);
+  // Bin k is output[2k] + output[2k + 1]i, except that 0 and 1 are the DC and
+  // center ones, which we skip anyway
+  const auto power = [this](const int bin) {
+    return square(output[bin * 2]) + square(output[bin * 2 + 1]);
+  };
+
+  float bands[SoundLevels::BAND_COUNT];
+  float loudest = 0.0f;
+  for (int band = 0; band < SoundLevels::BAND_COUNT; ++band) {
+    float energy = 0.0f;
+    for (int bin = bandStarts[band]; bin < bandStarts[band + 1]; ++bin) {
+      energy += power(bin) * weightingConstants[bin];
+    }
+    bands[band] = sqrtf(energy / (bandStarts[band + 1] - bandStarts[band]));
+    loudest = std::max(loudest, bands[band]);
+  }
+  peak = std::max(std::max(peak * PEAK_DECAY, loudest), MINIMUM_PEAK);
+  for (int band = 0; band < SoundLevels::BAND_COUNT; ++band) {
+    soundLevels.bands[band] = static_cast<uint8_t>(255.0f * bands[band] / peak);
+  }
+
+  const float rms = sqrtf(sumSquares / SAMPLE_COUNT);
+  const float volume_dB = 20.0f * log10f(std::max(rms, 1.0f) / 32768.0f);
+  soundLevels.volume = static_cast<uint8_t>(std::min(std::max((volume_dB + 60.0f) * 255.0f / 60.0f, 0.0f), 255.0f));
+
+  // Beats aren't A weighted, because that takes out most of the bass
+  const int bassEnd = std::max(2, static_cast<int>(BASS_FREQUENCY_HZ * SAMPLE_COUNT / sampleRate_Hz) + 1);
+  float bass = 0.0f;
+  for (int bin = 1; bin < bassEnd; ++bin) {
+    bass += power(bin);
+  }
+  if (
+    bass > averageBass * BEAT_RATIO
+    && bass > MINIMUM_BASS
+    && now_ms - lastBeat_ms >= MINIMUM_BEAT_INTERVAL_MS
+  ) {
+    ++soundLevels.beatCount;
+    lastBeat_ms = now_ms;
+  }
+  averageBass += (bass - averageBass) * BASS_AVERAGE_WEIGHT;
+
+  ++soundLevels.updateCount;
+}
+
+const SoundLevels& SoundAnalyzer::levels() const {
+  return soundLevels;
+}
+
+int SoundAnalyzer::band(const float frequency_Hz) const {
+  const int bin = static_cast<int>(lroundf(frequency_Hz * SAMPLE_COUNT / sampleRate_Hz));
+  for (int band = 0; band < SoundLevels::BAND_COUNT; ++band) {
+    if (bandStarts[band] <= bin && bin < bandStarts[band + 1]) {
+      return band;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,72 @@
+#ifndef SOUND_ANALYZER_HPP
+#define SOUND_ANALYZER_HPP
+
+#include <cstdint>
+
+#include "esp32-fft.hpp"
+
+// What the microphone heard, for animations that react to sound
+struct SoundLevels {
+  static const int BAND_COUNT = 16;
+  // How loud each band is, 0 - 255, bass first. They're scaled to the
+  // loudest band lately, so quiet rooms still show something.
+  uint8_t bands[BAND_COUNT];
+  // 0 is -60 dB from the loudest the microphone can go, 255 is the loudest
+  uint8_t volume;
+  // Goes up by one every beat, so compare it to the last one you saw
+  uint32_t beatCount;
+  // Goes up by one every analysis, so you can tell if these are new
+  uint32_t updateCount;
+};
+
+// Works out SoundLevels from microphone samples, the same way as the
+// spectrum analyzer in piddle: window the newest SAMPLE_COUNT samples, FFT
+// them, and A weight them. This doesn't use anything from Arduino, so the demo
+// can run WAV files through it on a computer.
+class SoundAnalyzer {
+  public:
+    static const int SAMPLE_COUNT = 1024;
+    // Call analyze() after about this many new samples, 23 ms at 44.1 kHz
+    static const int ANALYSIS_INTERVAL = 1024;
+
+    explicit SoundAnalyzer(int sampleRate_Hz);
+    ~SoundAnalyzer();
+
+    // Adds new samples. Only the newest SAMPLE_COUNT are kept.
+    void addSamples(const int16_t* samples, int count);
+    // Updates levels() from the newest samples. now_ms is for spacing beats.
+    void analyze(uint32_t now_ms);
+    const SoundLevels& levels() const;
+    // Which band a frequency is in, or -1 if it's not in any
+    int band(float frequency_Hz) const;
+
+  private:
+    SoundAnalyzer(const SoundAnalyzer&) = delete;
+    SoundAnalyzer& operator=(const SoundAnalyzer&) = delete;
+
+    // Don't count beats closer than this, which is 240 BPM
+    static const uint32_t MINIMUM_BEAT_INTERVAL_MS = 250;
+
+    const int sampleRate_Hz;
+    int16_t samples[SAMPLE_COUNT];
+    int sampleOffset;  // Where the next sample goes, which is the oldest
+
+    float input[SAMPLE_COUNT];
+    float output[SAMPLE_COUNT];
+    fft_config_t* fftPlan;
+    float windowingConstants[SAMPLE_COUNT];
+    // A weighting for each FFT bin
+    float weightingConstants[SAMPLE_COUNT / 2];
+    // The bins in band b are [bandStarts[b], bandStarts[b + 1])
+    int bandStarts[SoundLevels::BAND_COUNT + 1];
+
+    // Slowly falls, so the bands are scaled to the loudest they've been lately
+    float peak;
+    // Running average of the bass energy. A beat is when it jumps above this.
+    float averageBass;
+    uint32_t lastBeat_ms;
+
+    SoundLevels soundLevels;
+};
+
+#endif
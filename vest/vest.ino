@@ -1,4 +1,5 @@
 #include <FastLED.h>
+#include <inttypes.h>
 #include <math.h>
 #include <SPI.h>
 // you can enable debug logging to Serial at 115200
@@ -10,9 +11,19 @@
 
 #define REMOTEXY_BLUETOOTH_NAME "vest"
 
+// Send all the strands at once over I2S, the same way as piddle, instead of one
+// after another with FastLED. Build with this set to 0 to compare the two.
+#ifndef PARALLEL_OUTPUT
+#define PARALLEL_OUTPUT 1
+#endif
+
 #include "animations.hpp"
 #include "constants.hpp"
+#include "microphone.hpp"
 #include "movies.hpp"
+#if PARALLEL_OUTPUT
+#include "I2SClocklessLedDriver/I2SClocklessLedDriver.h"
+#endif
 
 // RemoteXY GUI configuration  
 #pragma pack(push, 1)  
@@ -61,6 +72,107 @@ struct {
 #pragma pack(pop)
 
 CRGB leds[LED_COUNT];
+static MoviePlayer moviePlayer;
+static Microphone microphone;
+
+#if PARALLEL_OUTPUT
+static I2SClocklessLedDriver driver;
+// Animations draw into leds. showLeds copies each frame into one of these and
+// the driver sends it from there while the next frame is drawn. The driver has
+// finished with a buffer by the time we come back around to it, because it
+// waits for the last frame before it starts the next one.
+static CRGB outputLeds[2][LED_COUNT];
+static int outputIndex = 0;
+static uint8_t outputBrightness = 255;
+static uint32_t maxPower_mW = 5 * 500;
+#endif
+
+// BLE and RemoteXY run in their own task on core 0, so they don't slow down
+// or jitter the animations on core 1. Only that task touches RemoteXY after
+// setup; it sends what changed in the app to the loop, and the loop sends back
+// what the app should show.
+struct ControlMessage {
+  uint8_t switchCycle;
+  uint8_t animation;
+  // Only true when the animation was picked in the app. Otherwise the loop
+  // might have cycled to another one since the app last heard about it.
+  bool animationChanged;
+  int8_t maxPower;
+  int8_t brightness;
+  // These are only true once per press, not the whole time it's held
+  bool play;
+  bool previous;
+  bool next;
+  uint32_t sent_us;
+};
+struct DisplayMessage {
+  uint8_t animation;
+  char text_sd[sizeof(RemoteXY.text_sd)];
+};
+static QueueHandle_t controlQueue;
+static QueueHandle_t displayQueue;
+static const int REMOTEXY_INTERVAL_MS = 5;
+// The loop's copy of what's set in the app
+static ControlMessage controls;
+
+// Debug info, printed and reset whenever something comes in over serial
+static struct {
+  uint32_t frames;
+  uint32_t lateFrames;  // Frames that finished after their deadline
+  uint32_t totalRender_us;
+  uint32_t maxRender_us;
+  uint32_t totalShow_us;
+  uint32_t maxShow_us;
+  // Frames where the last one was still being sent, so showing had to wait.
+  // FastLED always waits, so this only counts with PARALLEL_OUTPUT.
+  uint32_t busyFrames;
+  uint32_t start_ms;
+  // From the RemoteXY task seeing a change to the loop acting on it
+  uint32_t messages;
+  uint32_t totalLatency_us;
+  uint32_t maxLatency_us;
+  // These are written by the RemoteXY task. 32 bit writes are atomic, so the
+  // loop can read them, and if it resets them in the middle of a write, it's
+  // only debug info.
+  uint32_t handlerCalls;
+  uint32_t maxHandler_us;
+  uint32_t droppedMessages;
+} stats;
+
+static void setLedBrightness(const uint8_t brightness) {
+#if PARALLEL_OUTPUT
+  outputBrightness = brightness;
+#else
+  FastLED.setBrightness(brightness);
+#endif
+}
+
+static void setLedMaxPower(const uint32_t milliamps) {
+#if PARALLEL_OUTPUT
+  maxPower_mW = 5 * milliamps;
+#else
+  FastLED.setMaxPowerInVoltsAndMilliamps(5, milliamps);
+#endif
+}
+
+static void showLeds() {
+#if PARALLEL_OUTPUT
+  // The driver's setBrightness remakes its tables with powf, which is too slow
+  // to do every frame, so scale the copy instead, like FastLED does
+  const uint8_t brightness = calculate_max_brightness_for_power_mW(leds, LED_COUNT, outputBrightness, maxPower_mW);
+  outputIndex = 1 - outputIndex;
+  CRGB* const output = outputLeds[outputIndex];
+  memcpy(output, leds, sizeof(leds));
+  nscale8(output, LED_COUNT, brightness);
+  if (driver.isDisplaying) {
+    ++stats.busyFrames;
+  }
+  // This returns as soon as the frame starts going out
+  driver.showPixels(NO_WAIT, reinterpret_cast<uint8_t*>(output));
+#else
+  FastLED.show();
+#endif
+}
 
 void setup() {
   Serial.begin(115200);
@@ -76,8 +188,7 @@ void setup() {
   pinMode(LED_BUILTIN, OUTPUT);
   digitalWrite(LED_BUILTIN, LOW);
   pinMode(SD_PIN, OUTPUT);
-  constexpr int pins[] = {17, 21, 4, 0, 15};
-  for (const auto pin : pins) {
+  for (const auto pin : LED_PINS) {
     pinMode(pin, OUTPUT);
   }
 
@@ -88,19 +199,67 @@ void setup() {
   RemoteXY.slider_max_power = 25;
   RemoteXY.slider_brightness = 50;
   RemoteXY.switch_cycle = 1;  // Start off cycling
+  controls = {
+    RemoteXY.switch_cycle,
+    RemoteXY.animation,
+    false,
+    RemoteXY.slider_max_power,
+    RemoteXY.slider_brightness,
+    false,
+    false,
+    false,
+    0,
+  };
+  controlQueue = xQueueCreate(8, sizeof(ControlMessage));
+  displayQueue = xQueueCreate(4, sizeof(DisplayMessage));
 
-  Serial.println("FastLED");
+  Serial.println("LEDs");
   Serial.flush();
   delay(100);
-  FastLED.addLeds<WS2812, pins[0], GRB>(&leds[LINEAR_LED_INDEXES[0]], STRAND_TO_LED_COUNT[0]);
-  FastLED.addLeds<WS2812, pins[1], GRB>(&leds[LINEAR_LED_INDEXES[1]], STRAND_TO_LED_COUNT[1]);
-  FastLED.addLeds<WS2812, pins[2], GRB>(&leds[LINEAR_LED_INDEXES[2]], STRAND_TO_LED_COUNT[2]);
-  FastLED.addLeds<WS2812, pins[3], GRB>(&leds[LINEAR_LED_INDEXES[3]], STRAND_TO_LED_COUNT[3]);
-  FastLED.addLeds<WS2812, pins[4], GRB>(&leds[LINEAR_LED_INDEXES[4]], STRAND_TO_LED_COUNT[4]);
+#if PARALLEL_OUTPUT
+  // The strands are one after another in leds, which is how the driver wants
+  // them when they're different lengths
+  int strandLedCounts[STRAND_COUNT];
+  for (int i = 0; i < STRAND_COUNT; ++i) {
+    strandLedCounts[i] = STRAND_TO_LED_COUNT[i];
+  }
+  driver.initled(reinterpret_cast<uint8_t*>(outputLeds[0]), LED_PINS, strandLedCounts, STRAND_COUNT, ORDER_GRB);
+  // showLeds does the brightness
+  driver.setBrightness(255);
+#else
+  FastLED.addLeds<WS2812, LED_PINS[0], GRB>(&leds[LINEAR_LED_INDEXES[0]], STRAND_TO_LED_COUNT[0]);
+  FastLED.addLeds<WS2812, LED_PINS[1], GRB>(&leds[LINEAR_LED_INDEXES[1]], STRAND_TO_LED_COUNT[1]);
+  FastLED.addLeds<WS2812, LED_PINS[2], GRB>(&leds[LINEAR_LED_INDEXES[2]], STRAND_TO_LED_COUNT[2]);
+  FastLED.addLeds<WS2812, LED_PINS[3], GRB>(&leds[LINEAR_LED_INDEXES[3]], STRAND_TO_LED_COUNT[3]);
+  FastLED.addLeds<WS2812, LED_PINS[4], GRB>(&leds[LINEAR_LED_INDEXES[4]], STRAND_TO_LED_COUNT[4]);
+#endif
   // Brightness and max power will be set below
-  FastLED.clear();
-  FastLED.show();
+  fill_solid(leds, LED_COUNT, CRGB::Black);
+  showLeds();
+
+  Serial.println("Movies");
+  Serial.flush();
+  delay(100);
+  moviePlayer.begin();
 
+  Serial.println("Microphone");
+  Serial.flush();
+  delay(100);
+  microphone.begin();
+
+  Serial.println("RemoteXY task");
+  Serial.flush();
+  delay(100);
+  xTaskCreatePinnedToCore(
+    remoteXyTask,
+    "remoteXy",
+    4000, // Stack size
+    nullptr, // Task input parameter
+    1, // Priority of the task
+    nullptr, // Task handle
+    0); // Core where the task should run
+
+  stats.start_ms = millis();
   Serial.println("exiting setup");
   Serial.flush();
   delay(100);
@@ -109,8 +268,8 @@ void setup() {
 static bool playingMovie = false;
 static uint8_t configuredBrightness; // out of 255
 
-static int soundFunction() {
-  return 0;
+static void soundFunction(SoundLevels* const levels) {
+  microphone.levels(levels);
 }
 
 static ColorGenerator hueGenerator;
@@ -133,26 +292,184 @@ static PlasmaBidoulleFast bidoullePastel(pastelGenerator);
 static PlasmaBidoulleFast bidoulleChanging(changingGenerator);
 static Plasma3 plasma3(hueGenerator);
 static BasicSpiral spiral(hueGenerator);
-static MoviePlayer moviePlayer;
 
 static SpectrumAnalyzer1 spectrumAnalyzer1(soundFunction);
 
 //static constexpr Animation* animations[] = { &plasma3, &horizontalSnake, &snake, &spiral, &shine, &blobs };
-static constexpr Animation* animations[] = { &plasma3, &snake, &bidoulleChanging, &shine, &bidoullePastel, &horizontalSnake, &spiral, &blobs, &bidoulleNeon };
+static constexpr Animation* animations[] = { &plasma3, &snake, &bidoulleChanging, &shine, &bidoullePastel, &horizontalSnake, &spiral, &blobs, &bidoulleNeon, &spectrumAnalyzer1 };
 //static constexpr Animation* const* animations[] = { &snake };
 
 void loop() {
+  uint32_t nextFrame_us = micros();
+  uint32_t show_us = 0;
+
+  while (true) {
+    handleControls();
+
+    const uint32_t start_us = micros();
+    const int delay_ms = playingMovie ? moviePlayer.animate() : animations[controls.animation]->animate();
+    cycleAnimations(false);
+    const uint32_t render_us = micros() - start_us;
+    showLeds();
+    show_us = micros() - start_us - render_us;
+
+    ++stats.frames;
+    stats.totalRender_us += render_us;
+    stats.maxRender_us = max(stats.maxRender_us, render_us);
+    stats.totalShow_us += show_us;
+    stats.maxShow_us = max(stats.maxShow_us, show_us);
+
+    // Keep to deadlines instead of adding up delays, so how long a frame takes
+    // doesn't change how fast the animation goes. If we fell more than a whole
+    // frame behind, start counting again from now instead of rushing to catch
+    // up.
+    nextFrame_us += delay_ms * 1000;
+    const int32_t slack_us = nextFrame_us - micros();
+    if (slack_us < 0) {
+      ++stats.lateFrames;
+      if (slack_us < -delay_ms * 1000) {
+        nextFrame_us = micros();
+      }
+    }
+#if !PARALLEL_OUTPUT
+    // Keep showing while there's time, for FastLED's brightness dithering
+    while (static_cast<int32_t>(nextFrame_us - micros()) > static_cast<int32_t>(show_us)) {
+      FastLED.show();
+    }
+#endif
+    const int32_t remaining_us = nextFrame_us - micros();
+    if (remaining_us > 0) {
+      delayMicroseconds(remaining_us);
+    }
+
+    if (Serial.available() > 0) {
+      while (Serial.available() > 0) {
+        Serial.read();
+      }
+      printStats();
+    }
+  }
+}
 
+static void remoteXyTask(void*) {
+  ControlMessage sent = controls;
+  bool wasPlay = false, wasPrevious = false, wasNext = false;
   while (true) {
-    const int delay_ms = playingMovie ? moviePlayer.animate() : animations[RemoteXY.animation]->animate();
-    FastLED.show();
-    delayAndHandleRemoteXy(delay_ms);
+    const uint32_t start_us = micros();
+    RemoteXY_Handler();
+    const uint32_t handler_us = micros() - start_us;
+    ++stats.handlerCalls;
+    if (handler_us > stats.maxHandler_us) {
+      stats.maxHandler_us = handler_us;
+    }
+
+    DisplayMessage display;
+    while (xQueueReceive(displayQueue, &display, 0) == pdTRUE) {
+      RemoteXY.animation = display.animation;
+      // The loop already knows about this one
+      sent.animation = display.animation;
+      if (display.text_sd[0] != '\0') {
+        strcpy(RemoteXY.text_sd, display.text_sd);
+      }
+    }
+
+    ControlMessage message = {
+      RemoteXY.switch_cycle,
+      RemoteXY.animation,
+      RemoteXY.animation != sent.animation,
+      RemoteXY.slider_max_power,
+      RemoteXY.slider_brightness,
+      RemoteXY.button_play && !wasPlay,
+      RemoteXY.button_previous && !wasPrevious,
+      RemoteXY.button_next && !wasNext,
+      0,
+    };
+    bool delivered = true;
+    if (
+      message.switchCycle != sent.switchCycle
+      || message.animationChanged
+      || message.maxPower != sent.maxPower
+      || message.brightness != sent.brightness
+      || message.play
+      || message.previous
+      || message.next
+    ) {
+      message.sent_us = micros();
+      delivered = xQueueSend(controlQueue, &message, 0) == pdTRUE;
+      if (delivered) {
+        sent = message;
+      } else {
+        // Try again next time, presses included
+        ++stats.droppedMessages;
+      }
+    }
+    if (delivered) {
+      wasPlay = RemoteXY.button_play;
+      wasPrevious = RemoteXY.button_previous;
+      wasNext = RemoteXY.button_next;
+    }
+
+    delay(REMOTEXY_INTERVAL_MS);
   }
 }
 
-static void delayAndHandleRemoteXy(const int delay_ms) {
-  static uint8_t previousSwitchCycle = RemoteXY.switch_cycle;
+static void sendDisplay(const char* const text_sd) {
+  DisplayMessage display;
+  display.animation = controls.animation;
+  strncpy(display.text_sd, text_sd, COUNT_OF(display.text_sd));
+  display.text_sd[COUNT_OF(display.text_sd) - 1] = '\0';
+  // If the app is behind, it'll catch up with the next one
+  xQueueSend(displayQueue, &display, 0);
+}
+
+static void handleControls() {
+  ControlMessage message;
+  while (xQueueReceive(controlQueue, &message, 0) == pdTRUE) {
+    const uint32_t latency_us = micros() - message.sent_us;
+    ++stats.messages;
+    stats.totalLatency_us += latency_us;
+    stats.maxLatency_us = max(stats.maxLatency_us, latency_us);
+
+    if (message.switchCycle != controls.switchCycle) {
+      // Start over with the cycle
+      cycleAnimations(true);
+      playingMovie = false;
+    }
+    if (message.animationChanged && message.animation < COUNT_OF(animations)) {
+      controls.animation = message.animation;
+    }
+    controls.switchCycle = message.switchCycle;
+    controls.maxPower = message.maxPower;
+    controls.brightness = message.brightness;
 
+    if (message.play) {
+      playingMovie = true;
+      moviePlayer.play();
+    }
+    if (message.next || message.previous) {
+      char text_sd[COUNT_OF(RemoteXY.text_sd)];
+      if (moviePlayer) {
+        if (message.next) {
+          moviePlayer.next(text_sd, COUNT_OF(text_sd));
+        } else {
+          moviePlayer.previous(text_sd, COUNT_OF(text_sd));
+        }
+      } else {
+        const char failMessage[] = "FAIL";
+        static_assert(COUNT_OF(failMessage) < COUNT_OF(text_sd));
+        strcpy(text_sd, failMessage);
+      }
+      sendDisplay(text_sd);
+    }
+  }
+
+  // Set max milliamps between 500 and 2000
+  setLedMaxPower(controls.maxPower * (1500 / 100) + 500);
+
+  configuredBrightness = max(controls.brightness * 255 / 100, 5);
+}
+
+static void cycleAnimations(const bool restart) {
   // TODO: Make this a slider too?
   const int animationDuration_ms = 30000;
   const int fade_ms = 2000;
@@ -165,43 +482,14 @@ static void delayAndHandleRemoteXy(const int delay_ms) {
   static AnimationState state = AnimationState::Playing;
   static decltype(millis()) nextState_ms = millis() + animationDuration_ms;
 
-  const int start_ms = millis();
-  do {
-    // Do this delay manually, to keep both RemoteXY and FastLED brightness dithering
-    RemoteXY_Handler();
-    FastLED.show();
-  } while (millis() < start_ms + delay_ms);
-
-  if (previousSwitchCycle != RemoteXY.switch_cycle) {
+  if (restart) {
     nextState_ms = millis() + animationDuration_ms;
     state = AnimationState::Playing;
-    playingMovie = false;
-  }
-  previousSwitchCycle = RemoteXY.switch_cycle;
-
-  if (RemoteXY.button_play) {
-    playingMovie = true;
-  }
-  if (RemoteXY.button_next) {
-    if (moviePlayer) {
-      moviePlayer.next(RemoteXY.text_sd, COUNT_OF(RemoteXY.text_sd));
-    } else {
-      const char message[] = "FAIL";
-      static_assert(COUNT_OF(message) < COUNT_OF(RemoteXY.text_sd));
-      strcpy(RemoteXY.text_sd, message);
-    }
-  } else if (RemoteXY.button_previous) {
-    if (moviePlayer) {
-      moviePlayer.previous(RemoteXY.text_sd, COUNT_OF(RemoteXY.text_sd));
-    } else {
-      const char message[] = "FAIL";
-      static_assert(COUNT_OF(message) < COUNT_OF(RemoteXY.text_sd));
-      strcpy(RemoteXY.text_sd, message);
-    }
+    return;
   }
 
   // Switch animation
-  if (RemoteXY.switch_cycle) {
+  if (controls.switchCycle) {
     const auto now_ms = millis();
 
     if (now_ms >= nextState_ms) {
@@ -214,10 +502,11 @@ static void delayAndHandleRemoteXy(const int delay_ms) {
           state = AnimationState::FadeIn;
           nextState_ms = now_ms + fade_ms;
           // Go to next animation
-          ++RemoteXY.animation;
-          if (RemoteXY.animation > COUNT_OF(animations)) {
-            RemoteXY.animation = 0;
+          ++controls.animation;
+          if (controls.animation >= COUNT_OF(animations)) {
+            controls.animation = 0;
           }
+          sendDisplay("");
           break;
         case AnimationState::FadeIn:
           state = AnimationState::Playing;
@@ -228,14 +517,14 @@ static void delayAndHandleRemoteXy(const int delay_ms) {
 
     switch (state) {
       case AnimationState::Playing:
-        FastLED.setBrightness(gamma8[configuredBrightness]);
+        setLedBrightness(gamma8[configuredBrightness]);
         break;
       case AnimationState::FadeOut: {
           const auto diff_ms = nextState_ms - now_ms;
           const float ratio = static_cast<float>(diff_ms) / fade_ms;
           const uint8_t brightness = constrain(ratio * configuredBrightness, 0, 255);
           const uint8_t corrected = gamma8[brightness];
-          FastLED.setBrightness(corrected);
+          setLedBrightness(corrected);
           break;
         }
       case AnimationState::FadeIn: {
@@ -243,14 +532,54 @@ static void delayAndHandleRemoteXy(const int delay_ms) {
           const float ratio = 1.0f - (static_cast<float>(diff_ms) / fade_ms);
           const uint8_t brightness = constrain(ratio * configuredBrightness, 0, 255);
           const uint8_t corrected = gamma8[brightness];
-          FastLED.setBrightness(corrected);
+          setLedBrightness(corrected);
           break;
         }
     }
   }
+}
 
-  // Set max milliamps between 500 and 2000
-  FastLED.setMaxPowerInVoltsAndMilliamps(5, RemoteXY.slider_max_power * (1500 / 100) + 500);
-
-  configuredBrightness = max(RemoteXY.slider_brightness * 255 / 100, 5);
+static void printStats() {
+  const uint32_t frames = stats.frames > 0 ? stats.frames : 1;
+  const uint32_t messages = stats.messages > 0 ? stats.messages : 1;
+  const uint32_t now_ms = millis();
+  const uint32_t elapsed_ms = now_ms > stats.start_ms ? now_ms - stats.start_ms : 1;
+  Serial.printf(
+    "%s frames:%" PRIu32 " fps:%.1f late:%" PRIu32 " busy:%" PRIu32 " render_us:%" PRIu32 "/%" PRIu32 " show_us:%" PRIu32 "/%" PRIu32 " (average/max)\n",
+    PARALLEL_OUTPUT ? "parallel" : "FastLED",
+    stats.frames,
+    stats.frames * 1000.0f / elapsed_ms,
+    stats.lateFrames,
+    stats.busyFrames,
+    stats.totalRender_us / frames,
+    stats.maxRender_us,
+    stats.totalShow_us / frames,
+    stats.maxShow_us);
+  Serial.printf(
+    "remoteXy handlers:%" PRIu32 " max_us:%" PRIu32 " messages:%" PRIu32 " dropped:%" PRIu32 " latency_us:%" PRIu32 "/%" PRIu32 " (average/max)\n",
+    stats.handlerCalls,
+    stats.maxHandler_us,
+    stats.messages,
+    stats.droppedMessages,
+    stats.totalLatency_us / messages,
+    stats.maxLatency_us);
+  Serial.printf(
+    "movie underruns:%" PRIu32 " readErrors:%" PRIu32 " microphone readErrors:%" PRIu32 "\n",
+    moviePlayer.underruns(),
+    moviePlayer.readErrors(),
+    microphone.readErrors());
+  stats.frames = 0;
+  stats.lateFrames = 0;
+  stats.totalRender_us = 0;
+  stats.maxRender_us = 0;
+  stats.totalShow_us = 0;
+  stats.maxShow_us = 0;
+  stats.busyFrames = 0;
+  stats.start_ms = now_ms;
+  stats.messages = 0;
+  stats.totalLatency_us = 0;
+  stats.maxLatency_us = 0;
+  stats.handlerCalls = 0;
+  stats.maxHandler_us = 0;
+  stats.droppedMessages = 0;
 }
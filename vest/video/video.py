@@ -1,22 +1,183 @@
-"""Processes video and outputs header files."""
+"""Processes video and outputs .anim movies for the vest.
 
-from typing import List, Optional
+The format is described in ../movieFormat.hpp.
+"""
+
+from typing import BinaryIO, Dict, List, Optional
 import argparse
-import cv2
-import numpy
 import pathlib
+import random
 import re
 
 # TODO: Import these instead of copy/paste?
 LED_COLUMN_COUNT = 32
 LED_ROW_COUNT = 15
 
+MOVIE_VERSION = 2
+MOVIE_HEADER_SIZE = 20
+KEY_FRAME = 0x80000000
+RAW_FRAME = 0
+RUN_LENGTH_FRAME = 1
+DELTA_FRAME = 2
+PALETTE_FRAME = 3
+FRAME_TYPE_NAMES = {RAW_FRAME: "raw", RUN_LENGTH_FRAME: "run length", DELTA_FRAME: "delta", PALETTE_FRAME: "palette"}
+# Seeking has to decode from the key frame before, so don't go too long
+# without one
+DEFAULT_KEY_FRAME_INTERVAL = 60
+
 
 def debug_print(s: str) -> None:
     """Debug print."""
     print(s)
 
 
+def encode_run_length(pixels: bytes, unit_size: int = 3) -> bytes:
+    """Run length encodes 3 byte pixels, or whatever unit_size is. Each run
+    starts with a count c. If c < 128, then c + 1 units follow. Otherwise, one
+    unit follows that's repeated c - 126 times."""
+    units = [pixels[i:i + unit_size] for i in range(0, len(pixels), unit_size)]
+    output = bytearray()
+    literals: List[bytes] = []
+
+    def flush_literals() -> None:
+        while literals:
+            chunk = literals[:128]
+            del literals[:128]
+            output.append(len(chunk) - 1)
+            output.extend(b"".join(chunk))
+
+    i = 0
+    while i < len(units):
+        run = 1
+        while i + run < len(units) and run < 129 and units[i + run] == units[i]:
+            run += 1
+        if run >= 2:
+            flush_literals()
+            output.append(run + 126)
+            output.extend(units[i])
+            i += run
+        else:
+            literals.append(units[i])
+            i += 1
+    flush_literals()
+    return bytes(output)
+
+
+def encode_delta(previous: bytes, pixels: bytes) -> bytes:
+    """Encodes the pixels that changed since previous. Each change starts with a
+    skip s and a count c. s pixels stay the same, then c new pixels follow."""
+    pixel_count = len(pixels) // 3
+    changed = [pixels[i * 3:i * 3 + 3] != previous[i * 3:i * 3 + 3] for i in range(pixel_count)]
+    output = bytearray()
+    i = 0
+    while True:
+        skip = 0
+        while i < pixel_count and not changed[i]:
+            skip += 1
+            i += 1
+        if i == pixel_count:
+            # Everything after the last change stays the same
+            break
+        # A new change costs 2 bytes and an unchanged pixel costs 3, so it's
+        # never worth sending unchanged pixels to keep a change going
+        while skip > 255:
+            output.extend((255, 0))
+            skip -= 255
+        start = i
+        while i < pixel_count and changed[i] and i - start < 255:
+            i += 1
+        output.extend((skip, i - start))
+        output.extend(pixels[start * 3:i * 3])
+    return bytes(output)
+
+
+def encode_palette(pixels: bytes) -> Optional[bytes]:
+    """Encodes the pixels as indexes into a list of their colors, or returns None
+    if there are more than 256 colors."""
+    indexes: Dict[bytes, int] = {}
+    pixel_indexes = bytearray()
+    for i in range(0, len(pixels), 3):
+        color = pixels[i:i + 3]
+        if color not in indexes:
+            if len(indexes) == 256:
+                return None
+            indexes[color] = len(indexes)
+        pixel_indexes.append(indexes[color])
+    output = bytearray((len(indexes) - 1,))
+    for color in indexes:
+        output.extend(color)
+    output.extend(encode_run_length(bytes(pixel_indexes), 1))
+    return bytes(output)
+
+
+class MovieWriter:
+    """Writes a .anim movie. Frames are 3 byte red green blue pixels, going up
+    each column from the bottom, starting at the left column."""
+
+    def __init__(
+        self,
+        file: BinaryIO,
+        width: int,
+        height: int,
+        micros_per_frame: int,
+        key_frame_interval: int = DEFAULT_KEY_FRAME_INTERVAL,
+    ) -> None:
+        assert 0 < width <= 255 and 0 < height <= 255
+        assert key_frame_interval > 0
+        self.file = file
+        self.width = width
+        self.height = height
+        self.micros_per_frame = micros_per_frame
+        self.key_frame_interval = key_frame_interval
+        # Index entries, with KEY_FRAME already set
+        self.offsets: List[int] = []
+        self.previous: Optional[bytes] = None
+        self.frames_since_key_frame = 0
+        self.type_counts = {frame_type: 0 for frame_type in FRAME_TYPE_NAMES}
+        # Come back and fill the header in at the end
+        self.file.write(bytes(MOVIE_HEADER_SIZE))
+
+    def write_frame(self, pixels: bytes) -> None:
+        """Writes a frame, in whichever type is smallest. It's only a delta from
+        the frame before if there's been a key frame recently enough."""
+        assert len(pixels) == self.width * self.height * 3
+        candidates = [(RAW_FRAME, pixels), (RUN_LENGTH_FRAME, encode_run_length(pixels))]
+        palette = encode_palette(pixels)
+        if palette is not None:
+            candidates.append((PALETTE_FRAME, palette))
+        if self.previous is not None and self.frames_since_key_frame < self.key_frame_interval:
+            candidates.append((DELTA_FRAME, encode_delta(self.previous, pixels)))
+        # min keeps the first on ties, so key frames win those
+        frame_type, data = min(candidates, key=lambda candidate: len(candidate[1]))
+        # The size has to fit in 2 bytes, and raw always does for 255x255
+        assert len(data) < 1 << 16
+
+        if frame_type == DELTA_FRAME:
+            self.frames_since_key_frame += 1
+            self.offsets.append(self.file.tell())
+        else:
+            self.frames_since_key_frame = 1
+            self.offsets.append(self.file.tell() | KEY_FRAME)
+        self.type_counts[frame_type] += 1
+        self.previous = pixels
+        self.file.write(frame_type.to_bytes(1, "little"))
+        self.file.write(len(data).to_bytes(2, "little"))
+        self.file.write(data)
+
+    def close(self) -> None:
+        """Writes the index and the header."""
+        index_offset = self.file.tell()
+        for offset in self.offsets:
+            self.file.write(offset.to_bytes(4, "little"))
+        self.file.seek(0)
+        self.file.write(b"ANIM")
+        self.file.write(bytes((MOVIE_VERSION, self.width, self.height, 0)))
+        self.file.write(self.micros_per_frame.to_bytes(4, "little"))
+        self.file.write(len(self.offsets).to_bytes(4, "little"))
+        self.file.write(index_offset.to_bytes(4, "little"))
+        self.file.seek(0, 2)
+
+
 def process(arguments: argparse.Namespace) -> None:
     """Save outputs."""
     output_file_name_str = arguments.out if arguments.out else re.sub("\.[^.]+$", ".anim", arguments.video_file)
@@ -35,6 +196,8 @@ def process(arguments: argparse.Namespace) -> None:
 
 def process_inner(arguments: argparse.Namespace, output_name: pathlib.Path) -> None:
     """Save outputs."""
+    import cv2
+
     if arguments.center:
         center_index = 8
         target_width = (LED_COLUMN_COUNT // 2 - center_index) * 2
@@ -55,12 +218,6 @@ def process_inner(arguments: argparse.Namespace, output_name: pathlib.Path) -> N
     height = len(image)
     width = len(image[0])
 
-    def sample_to_int(sample: List[numpy.uint8]) -> int:
-        """Converts a sample to int."""
-        value = (sample[2] << 16) + (sample[1] << 8) + sample[0]
-        return int(value)
-
-
     video_ratio = width / height
     target_ratio = target_width / target_height
 
@@ -89,26 +246,123 @@ def process_inner(arguments: argparse.Namespace, output_name: pathlib.Path) -> N
 
     count = 0
     with open(output_name, "wb") as file:
-        # First, write info
-        file.write(target_width.to_bytes(1, "little"))
-        file.write(target_height.to_bytes(1, "little"))
-        # Then milliseonds per frame. This probably won't ever exceed 255, but
-        # use 2 bytes just in case.
-        file.write(int(1000 / video_fps).to_bytes(2, "little"))
-
+        writer = MovieWriter(
+            file,
+            target_width,
+            target_height,
+            round(1_000_000 / video_fps),
+            arguments.key_frame_interval,
+        )
         while success:
             success, image = capture.read()
             if not success:
                 break
-            for h_index in h_indexes:
-                for w_index in w_indexes:
-                    # Write 4-byte samples? I don't know if it's worth trying to do 3
-                    sample_int = sample_to_int(image[h_index][w_index])
-                    file.write(sample_int.to_bytes(4, "little"))
-
+            pixels = bytearray()
+            for w_index in w_indexes:
+                # The video's rows go down from the top, and the vest's go up
+                # from the bottom
+                for h_index in reversed(h_indexes):
+                    # OpenCV is blue green red
+                    sample = image[h_index][w_index]
+                    pixels.extend((int(sample[2]), int(sample[1]), int(sample[0])))
+            writer.write_frame(bytes(pixels))
             count += 1
+        writer.close()
 
     debug_print(f"Wrote {count} frames")
+    for frame_type, type_count in writer.type_counts.items():
+        debug_print(f"{FRAME_TYPE_NAMES[frame_type]}: {type_count}")
+
+
+def write_test_corpus(directory: pathlib.Path) -> None:
+    """Writes some made up movies to check decoders with. Each name.anim gets a
+    name.rgb next to it with the pixels of every frame, one after another."""
+    directory.mkdir(parents=True, exist_ok=True)
+    generator = random.Random(1)
+
+    def black(width: int, height: int, frame: int) -> bytes:
+        return bytes(width * height * 3)
+
+    def gradient(width: int, height: int, frame: int) -> bytes:
+        return bytes(
+            channel
+            for x in range(width)
+            for y in range(height)
+            for channel in ((x * 8 + frame) % 256, y * 17 % 256, frame * 5 % 256)
+        )
+
+    def bar(width: int, height: int, frame: int) -> bytes:
+        return bytes(
+            channel
+            for x in range(width)
+            for y in range(height)
+            for channel in ((255, 0, 0) if x == frame % width else (0, 0, 64))
+        )
+
+    def noise(width: int, height: int, frame: int) -> bytes:
+        return bytes(generator.randrange(256) for _ in range(width * height * 3))
+
+    def half(width: int, height: int, frame: int) -> bytes:
+        """Noise in more than 255 pixels, and the rest stays the same, so deltas
+        need more than one change."""
+        changing = min(300, width * height)
+        return bytes(generator.randrange(256) for _ in range(changing * 3)) + bytes((9, 8, 7)) * (width * height - changing)
+
+    def dot(width: int, height: int, frame: int) -> bytes:
+        """One moving pixel, so deltas have to skip more than 255 pixels."""
+        position = frame * 37 % (width * height)
+        return bytes(
+            channel
+            for i in range(width * height)
+            for channel in ((255, 255, 255) if i == position else (0, 0, 0))
+        )
+
+    def stripes(width: int, height: int, frame: int) -> bytes:
+        """A few colors, but no runs, so palettes are smallest."""
+        colors = ((255, 0, 0), (0, 255, 0), (0, 0, 255), (255, 255, 0), (0, 255, 255), (255, 0, 255), (40, 40, 40))
+        return bytes(
+            channel
+            for x in range(width)
+            for y in range(height)
+            for channel in colors[(x * 3 + y * 5 + frame) % len(colors)]
+        )
+
+    def runs(width: int, height: int, frame: int) -> bytes:
+        """Runs and literals right around the longest ones a count can hold."""
+        pixels = bytearray()
+        lengths = (127, 128, 129, 130, 1, 2, 3, 257, 258)
+        while len(pixels) < width * height * 3:
+            length = lengths[len(pixels) % len(lengths)]
+            value = len(pixels) % 251
+            if frame % 2:
+                # Different every pixel, so it's all literals
+                pixels.extend(bytes((value + i) % 256 for i in range(length * 3)))
+            else:
+                pixels.extend(bytes((value, frame, 7)) * length)
+        return bytes(pixels[:width * height * 3])
+
+    clips = (
+        ("black", LED_COLUMN_COUNT, LED_ROW_COUNT, 3, black),
+        ("gradient", LED_COLUMN_COUNT, LED_ROW_COUNT, 10, gradient),
+        ("centered", 16, LED_ROW_COUNT, 20, bar),
+        ("noise", LED_COLUMN_COUNT, LED_ROW_COUNT, 5, noise),
+        ("runs", LED_COLUMN_COUNT, LED_ROW_COUNT, 4, runs),
+        ("half", LED_COLUMN_COUNT, LED_ROW_COUNT, 20, half),
+        ("dot", LED_COLUMN_COUNT, LED_ROW_COUNT, 20, dot),
+        ("stripes", LED_COLUMN_COUNT, LED_ROW_COUNT, 10, stripes),
+        ("tiny", 1, 1, 2, gradient),
+    )
+    for name, width, height, frame_count, make_frame in clips:
+        with open(directory / f"{name}.anim", "wb") as movie, open(directory / f"{name}.rgb", "wb") as expected:
+            # Short enough that seeking has to decode deltas from a key frame
+            # in the middle
+            writer = MovieWriter(movie, width, height, 33_333, key_frame_interval=8)
+            for frame in range(frame_count):
+                pixels = make_frame(width, height, frame)
+                writer.write_frame(pixels)
+                expected.write(pixels)
+            writer.close()
+        debug_print(f"Wrote {name}.anim")
 
 
 def make_parser() -> argparse.ArgumentParser:
@@ -129,7 +383,19 @@ def make_parser() -> argparse.ArgumentParser:
         type=str,
         help="Output file name",
     )
-    parser.add_argument("video_file", help="The video to read data from.")
+    parser.add_argument(
+        "-k",
+        "--key-frame-interval",
+        type=int,
+        help="Most frames between key frames. Seeking decodes from the key frame before.",
+        default=DEFAULT_KEY_FRAME_INTERVAL,
+    )
+    parser.add_argument(
+        "--test-corpus",
+        type=str,
+        help="Write made up movies to this directory to test decoders with, instead of reading a video.",
+    )
+    parser.add_argument("video_file", nargs="?", help="The video to read data from.")
     return parser
 
 
@@ -138,7 +404,12 @@ def main() -> None:
 
     parser = make_parser()
     arguments = parser.parse_args()
-    process(arguments)
+    if arguments.test_corpus:
+        write_test_corpus(pathlib.Path(arguments.test_corpus))
+    elif arguments.video_file:
+        process(arguments)
+    else:
+        parser.error("Need a video file")
 
 
 if __name__ == "__main__":